@@ -49,6 +49,9 @@ public:
 	// Sets into matrix with translational and rotational components
 	inline void setTransform( const Vector4& translation, const Real rotation );
 
+	// Same as above with cos and sin of rotation already known
+	inline void setTransform( const Vector4& translation, const Real rotation, const Real cosRot, const Real sinRot );
+
 	// Sets into pure reflection matrix across direction
 	inline void setReflection( const Vector4& direction );
 
@@ -78,6 +78,15 @@ inline void Transform::setTransform( const Vector4& translation, const Real rota
 	addRotation( rotation );
 }
 
+inline void Transform::setTransform( const Vector4& translation, const Real rotation, const Real cosRot, const Real sinRot )
+{
+	setIdentity();
+	addTranslation( translation );
+	m_data[0][0] = cosRot; m_data[0][1] = -sinRot;
+	m_data[1][0] = sinRot; m_data[1][1] = cosRot;
+	m_rotation = rotation;
+}
+
 inline void Transform::setReflection( const Vector4& direction )
 {
 	setIdentity();
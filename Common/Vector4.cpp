@@ -34,6 +34,20 @@ void Vector4::setTransformedInversePos( const Transform& t, const Vector4& v )
 	setTransformedPos( tinv, v );
 }
 
+void Vector4::setRotatedPos( const Transform& t, const Vector4& v )
+{
+	Real x = t( 0, 0 )*v( 0 ) + t( 0, 1 )*v( 1 );
+	( *this )( 1 ) = t( 1, 0 )*v( 0 ) + t( 1, 1 )*v( 1 );
+	( *this )( 0 ) = x;
+}
+
+void Vector4::setInverseRotatedPos( const Transform& t, const Vector4& v )
+{
+	Real x = t( 0, 0 )*v( 0 ) + t( 1, 0 )*v( 1 );
+	( *this )( 1 ) = t( 0, 1 )*v( 0 ) + t( 1, 1 )*v( 1 );
+	( *this )( 0 ) = x;
+}
+
 void Vector4::setClampedLength( const Vector4& v, const Real length )
 {
 	Assert( !v.isZero(), "Trying to give length to zero vector" );
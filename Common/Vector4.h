@@ -151,6 +151,11 @@ public:
 
 	void setTransformedInversePos( const Transform& t, const Vector4& v );
 
+	// Rotation part of t only, inverse uses the transposed rotation so t isn't inverted
+	void setRotatedPos( const Transform& t, const Vector4& v );
+
+	void setInverseRotatedPos( const Transform& t, const Vector4& v );
+
 	void setClampedLength( const Vector4& v, const Real length );
 
 	//
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+// Runs func numRuns times and returns the fastest run in milliseconds,
+// the fastest run is the one least disturbed by everything else on the machine
+template <typename Func>
+double measureBestMs( const int numRuns, Func func )
+{
+    double bestMs = 1e30;
+
+    for ( int run = 0; run < numRuns; run++ )
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        bestMs = std::min( bestMs, std::chrono::duration<double, std::milli>( end - start ).count() );
+    }
+
+    return bestMs;
+}
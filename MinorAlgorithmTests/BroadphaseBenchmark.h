@@ -0,0 +1,46 @@
+#pragma once
+
+#include "BenchmarkUtils.h"
+#include <physicsBroadphase.h>
+
+#include <vector>
+#include <cstdlib>
+
+// Full sweep and prune rebuild of densely packed boxes of mixed sizes
+void sweepAndPruneRebuildBenchmark()
+{
+    const int numBodies = 20000;
+    const int numRuns = 10;
+
+    // Bodies added since last update are sorted and swept from scratch, each run gets a fresh broadphase
+    std::vector<physicsSweepAndPrune> sweepAndPrunes( numRuns );
+
+    for ( int run = 0; run < numRuns; run++ )
+    {
+        srand( 1 );
+
+        for ( int i = 0; i < numBodies; i++ )
+        {
+            Vector4 center( ( Real )( rand() % 2000 ), ( Real )( rand() % 2000 ) );
+            Vector4 halfExtent( ( Real )( rand() % 10 + 2 ), ( Real )( rand() % 10 + 2 ) );
+            sweepAndPrunes[run].addBody( BroadphaseBody( i, physicsAabb( center + halfExtent, center - halfExtent ) ) );
+        }
+    }
+
+    int run = 0;
+    int numPairs = 0;
+
+    double ms = measureBestMs( numRuns, [&]()
+    {
+        std::vector<BodyIdPair> addedPairs, removedPairs;
+        sweepAndPrunes[run++].updatePairs( addedPairs, removedPairs );
+        numPairs = ( int )addedPairs.size();
+    } );
+
+    printf( "sweep and prune rebuild, %d bodies, %d pairs: %.2f ms\n", numBodies, numPairs, ms );
+}
+
+void broadphaseBenchmark()
+{
+    sweepAndPruneRebuildBenchmark();
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <physicsBroadphase.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+// Moves random boxes around and checks that the pairs tracked through
+// broadphase's added/removed reports match brute-force overlap tests
+void broadphaseTest( physicsBroadphase& broadphase )
+{
+    const int numBodies = 300;
+    const int numSteps = 200;
+
+    srand( 0 );
+
+    std::vector<Vector4> positions, velocities, halfExtents;
+    std::vector<unsigned int> categories, masks;
+
+    for ( int i = 0; i < numBodies; i++ )
+    {
+        positions.push_back( Vector4( ( Real )( rand() % 1000 ), ( Real )( rand() % 1000 ) ) );
+        velocities.push_back( Vector4( ( Real )( rand() % 11 - 5 ), ( Real )( rand() % 11 - 5 ) ) );
+        halfExtents.push_back( Vector4( ( Real )( rand() % 20 + 2 ), ( Real )( rand() % 20 + 2 ) ) );
+
+        // Three groups, some bodies ignore their own group
+        categories.push_back( 1 << ( i % 3 ) );
+        masks.push_back( ( i % 5 == 0 ) ? ~categories[i] : 0xffffffff );
+
+        BroadphaseBody body( i, physicsAabb( positions[i] + halfExtents[i], positions[i] - halfExtents[i] ) );
+        body.isStatic = ( i % 10 == 0 );
+        body.category = categories[i];
+        body.mask = masks[i];
+        broadphase.addBody( body );
+    }
+
+    std::vector<BodyIdPair> trackedPairs;
+
+    for ( int step = 0; step < numSteps; step++ )
+    {
+        for ( int i = 0; i < numBodies; i++ )
+        {
+            if ( i % 10 == 0 )
+            {
+                continue;
+            }
+
+            positions[i] += velocities[i];
+            broadphase.updateBody( i, physicsAabb( positions[i] + halfExtents[i], positions[i] - halfExtents[i] ) );
+        }
+
+        if ( step % 50 == 0 )
+        {
+            // Static bodies only move when teleported
+            positions[0] = Vector4( ( Real )( rand() % 1000 ), ( Real )( rand() % 1000 ) );
+            broadphase.updateBody( 0, physicsAabb( positions[0] + halfExtents[0], positions[0] - halfExtents[0] ) );
+        }
+
+        std::vector<BodyIdPair> addedPairs, removedPairs;
+        broadphase.updatePairs( addedPairs, removedPairs );
+
+        // Reported in no particular order
+        std::sort( removedPairs.begin(), removedPairs.end(), bodyIdPairLess );
+
+        BodyIdPairsUtils::deletePairsBfromA( trackedPairs, removedPairs );
+        BodyIdPairsUtils::movePairsBtoA( trackedPairs, addedPairs );
+        std::sort( trackedPairs.begin(), trackedPairs.end(), bodyIdPairLess );
+
+        // Brute force reference, pairs between dynamic bodies of aabb tree are found on fat aabb's
+        const physicsAabbTreeBroadphase* aabbTree = ( broadphase.getType() == physicsBroadphase::AABB_TREE ) ?
+            static_cast< const physicsAabbTreeBroadphase* >( &broadphase ) : nullptr;
+
+        std::vector<BodyIdPair> brutePairs;
+
+        for ( int i = 0; i < numBodies; i++ )
+        {
+            for ( int j = 0; j < i; j++ )
+            {
+                if ( i % 10 == 0 && j % 10 == 0 )
+                {
+                    continue;
+                }
+
+                if ( ( categories[i] & masks[j] ) == 0 || ( categories[j] & masks[i] ) == 0 )
+                {
+                    continue;
+                }
+
+                physicsAabb aabbI( positions[i] + halfExtents[i], positions[i] - halfExtents[i] );
+                physicsAabb aabbJ( positions[j] + halfExtents[j], positions[j] - halfExtents[j] );
+
+                if ( aabbTree && i % 10 != 0 && j % 10 != 0 )
+                {
+                    aabbI = aabbTree->getFatAabb( i );
+                    aabbJ = aabbTree->getFatAabb( j );
+                }
+
+                if ( aabbI.overlaps( aabbJ ) )
+                {
+                    brutePairs.push_back( BodyIdPair( i, j ) );
+                }
+            }
+        }
+
+        std::sort( brutePairs.begin(), brutePairs.end(), bodyIdPairLess );
+
+        std::vector<BodyIdPair> broadphasePairs;
+        broadphase.getPairs( broadphasePairs );
+
+        Assert( trackedPairs == broadphasePairs, "reported pairs don't add up to broadphase's pair set" );
+        Assert( trackedPairs == brutePairs, "broadphase pairs don't match brute force" );
+
+        // Region query should return exactly the bodies overlapping it
+        Vector4 queryCenter( ( Real )( rand() % 1000 ), ( Real )( rand() % 1000 ) );
+        Vector4 queryHalfExtent( 50.f, 50.f );
+
+        std::vector<BodyId> queryHits, bruteHits;
+        broadphase.queryAabb( physicsAabb( queryCenter + queryHalfExtent, queryCenter - queryHalfExtent ), queryHits );
+
+        for ( int i = 0; i < numBodies; i++ )
+        {
+            Vector4 d = positions[i] - queryCenter;
+            Vector4 sum = halfExtents[i] + queryHalfExtent;
+
+            if ( fabs( d( 0 ) ) < sum( 0 ) && fabs( d( 1 ) ) < sum( 1 ) )
+            {
+                bruteHits.push_back( i );
+            }
+        }
+
+        std::sort( queryHits.begin(), queryHits.end() );
+        Assert( queryHits == bruteHits, "broadphase query doesn't match overlapping bodies" );
+    }
+}
+
+// Wide overlap kernels should agree with scalar test, including padding past the last entry
+void aabbSoaTest()
+{
+    const int numAabbs = 37;
+
+    srand( 0 );
+
+    physicsAabbSoa aabbs;
+    aabbs.resize( numAabbs );
+
+    std::vector<physicsAabb> scalarAabbs;
+
+    for ( int i = 0; i < numAabbs; i++ )
+    {
+        Vector4 center( ( Real )( rand() % 100 ), ( Real )( rand() % 100 ) );
+        Vector4 halfExtent( ( Real )( rand() % 10 + 1 ), ( Real )( rand() % 10 + 1 ) );
+
+        scalarAabbs.push_back( physicsAabb( center + halfExtent, center - halfExtent ) );
+        aabbs.set( i, scalarAabbs.back() );
+    }
+
+    physicsAabb query( Vector4( 60.f, 60.f ), Vector4( 30.f, 30.f ) );
+
+    std::vector<int> hits;
+    aabbs.query( query, 3, numAabbs, hits );
+
+    std::vector<int> bruteHits;
+
+    for ( int i = 0; i < numAabbs; i++ )
+    {
+        unsigned int mask = aabbs.overlaps8( query, i & ~7 );
+        Assert( ( ( mask >> ( i & 7 ) ) & 1 ) == ( unsigned int )scalarAabbs[i].overlaps( query ), "8 wide overlap mismatch" );
+
+        mask = aabbs.overlaps4( query, i & ~3 );
+        Assert( ( ( mask >> ( i & 3 ) ) & 1 ) == ( unsigned int )scalarAabbs[i].overlaps( query ), "4 wide overlap mismatch" );
+
+        if ( i >= 3 && scalarAabbs[i].overlaps( query ) )
+        {
+            bruteHits.push_back( i );
+        }
+    }
+
+    Assert( hits == bruteHits, "soa query doesn't match overlapping aabbs" );
+    Assert( aabbs.overlaps8( query, 32 ) >> ( numAabbs - 32 ) == 0, "padding overlapped" );
+}
+
+// Pair map should behave like a set through inserts and removes which shift entries around
+void pairMapTest()
+{
+    const int numOps = 20000;
+    const int numIds = 64;
+
+    srand( 0 );
+
+    physicsPairMap<int> pairMap;
+    std::vector<BodyIdPair> brutePairs;
+
+    for ( int i = 0; i < numOps; i++ )
+    {
+        BodyId a = ( BodyId )( rand() % numIds );
+        BodyId b = ( BodyId )( ( a + 1 + rand() % ( numIds - 1 ) ) % numIds );
+        BodyIdPair pair( a, b );
+
+        auto bruteIter = std::find( brutePairs.begin(), brutePairs.end(), pair );
+        bool inBrute = ( bruteIter != brutePairs.end() );
+
+        Assert( ( pairMap.find( pair ) != nullptr ) == inBrute, "pair map lookup mismatch" );
+
+        // Insert more often than remove so map grows through a few sizes
+        if ( rand() % 3 != 0 )
+        {
+            bool inserted;
+            int& value = pairMap.insert( pair, i, &inserted );
+            Assert( inserted != inBrute, "pair map inserted existing pair" );
+
+            if ( inserted )
+            {
+                brutePairs.push_back( pair );
+                Assert( value == i, "pair map didn't store inserted value" );
+            }
+        }
+        else
+        {
+            Assert( pairMap.remove( pair ) == inBrute, "pair map removed missing pair" );
+
+            if ( inBrute )
+            {
+                brutePairs.erase( bruteIter );
+            }
+        }
+
+        Assert( pairMap.getSize() == ( int )brutePairs.size(), "pair map size mismatch" );
+    }
+
+    std::vector<BodyIdPair> mapPairs;
+
+    for ( int slotIdx = 0; slotIdx < pairMap.getNumSlots(); slotIdx++ )
+    {
+        if ( pairMap.isSlotUsed( slotIdx ) )
+        {
+            mapPairs.push_back( pairMap.getSlotPair( slotIdx ) );
+        }
+    }
+
+    std::sort( mapPairs.begin(), mapPairs.end(), bodyIdPairLess );
+    std::sort( brutePairs.begin(), brutePairs.end(), bodyIdPairLess );
+    Assert( mapPairs == brutePairs, "pair map slots don't match inserted pairs" );
+}
+
+void broadphaseTest()
+{
+    aabbSoaTest();
+    pairMapTest();
+
+    physicsSweepAndPrune sweepAndPrune;
+    broadphaseTest( sweepAndPrune );
+
+    physicsHashGrid hashGrid( 32.f );
+    broadphaseTest( hashGrid );
+
+    physicsAabbTreeBroadphase aabbTree( 4.f );
+    broadphaseTest( aabbTree );
+
+    // Same again with pair finding split across threads
+    physicsThreadPool threadPool( 4 );
+
+    physicsSweepAndPrune threadedSweepAndPrune;
+    threadedSweepAndPrune.setThreadPool( &threadPool );
+    broadphaseTest( threadedSweepAndPrune );
+
+    physicsHashGrid threadedHashGrid( 32.f );
+    threadedHashGrid.setThreadPool( &threadPool );
+    broadphaseTest( threadedHashGrid );
+
+    physicsAabbTreeBroadphase threadedAabbTree( 4.f );
+    threadedAabbTree.setThreadPool( &threadPool );
+    broadphaseTest( threadedAabbTree );
+}
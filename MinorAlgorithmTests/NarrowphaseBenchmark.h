@@ -0,0 +1,309 @@
+#pragma once
+
+#include "BenchmarkUtils.h"
+#include "NarrowphaseTest.h"
+#include <physicsCircleBatch.h>
+#include <physicsCollider.h>
+#include <physicsShape.h>
+#include <physicsWorld.h>
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+// Support queries along a slowly turning direction, like GJK sees from step to step.
+// Climbing from the last support, climbing from vertex 0 and scanning every vertex
+void supportBenchmark()
+{
+    const int numQueries = 100000;
+    const int numRuns = 10;
+    const int vertexCounts[] = { 3, 32, 256 };
+    const int numVertexCounts = sizeof( vertexCounts ) / sizeof( vertexCounts[0] );
+
+    srand( 1 );
+
+    std::vector<Vector4> directions;
+
+    for ( int i = 0; i < numQueries; i++ )
+    {
+        Real angle = ( Real )i * 0.01f;
+        directions.push_back( Vector4( cos( angle ), sin( angle ) ) );
+    }
+
+    for ( int i = 0; i < numVertexCounts; i++ )
+    {
+        std::shared_ptr<physicsShape> shape = makeRoundConvexShape( vertexCounts[i], 50.f );
+
+        std::vector<Vector4> hull;
+        shape->getHullVertices( hull );
+
+        // Summed so queries can't be optimized away
+        Real sum = 0.f;
+
+        double coherentMs = measureBestMs( numRuns, [&]()
+        {
+            int vertexIdx = 0;
+
+            for ( auto iter = directions.begin(); iter != directions.end(); iter++ )
+            {
+                Vector4 support;
+                shape->getSupportingVertexFrom( *iter, vertexIdx, support );
+                sum += support( 0 );
+            }
+        } );
+
+        double fromStartMs = measureBestMs( numRuns, [&]()
+        {
+            for ( auto iter = directions.begin(); iter != directions.end(); iter++ )
+            {
+                Vector4 support;
+                shape->getSupportingVertex( *iter, support );
+                sum += support( 0 );
+            }
+        } );
+
+        double scanMs = measureBestMs( numRuns, [&]()
+        {
+            for ( auto iter = directions.begin(); iter != directions.end(); iter++ )
+            {
+                Real bestDot = std::numeric_limits<Real>::lowest();
+                int bestIdx = 0;
+
+                for ( int j = 0; j < ( int )hull.size(); j++ )
+                {
+                    Real dot = iter->dot<2>( hull[j] );
+
+                    if ( dot > bestDot )
+                    {
+                        bestDot = dot;
+                        bestIdx = j;
+                    }
+                }
+
+                sum += hull[bestIdx]( 0 );
+            }
+        } );
+
+        printf( "support, %d vertices: climb from last %.1f ns, climb from vertex 0 %.1f ns, scan %.1f ns (%g)\n", vertexCounts[i],
+                coherentMs * 1e6 / numQueries, fromStartMs * 1e6 / numQueries, scanMs * 1e6 / numQueries, sum );
+    }
+}
+
+// Overlapping convex pairs moving a little each step, collided with their caches and from scratch
+void gjkWarmStartBenchmark()
+{
+    const int numPairs = 1000;
+    const int numSteps = 20;
+    const int numRuns = 10;
+
+    srand( 2 );
+
+    std::shared_ptr<physicsShape> shapes[] =
+    {
+        physicsBoxShape::create( Vector4( 15.f, 10.f ) ),
+        makeRoundConvexShape( 6, 15.f ),
+        makeRoundConvexShape( 5, 12.f ),
+    };
+
+    struct Pair
+    {
+        const physicsShape* shapeA;
+        const physicsShape* shapeB;
+        Vector4 offset;
+        Real rotA;
+        Real rotB;
+    };
+
+    std::vector<Pair> pairs;
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        Pair pair;
+        pair.shapeA = shapes[i % 3].get();
+        pair.shapeB = shapes[( i / 3 ) % 3].get();
+        Real angle = ( Real )( rand() % 628 ) * 0.01f;
+        pair.offset = Vector4( cos( angle ), sin( angle ) ) * ( Real )( rand() % 10 + 15 );
+        pair.rotA = ( Real )( rand() % 628 ) * 0.01f;
+        pair.rotB = ( Real )( rand() % 628 ) * 0.01f;
+        pairs.push_back( pair );
+    }
+
+    int numContacts = 0;
+
+    for ( int useCache = 0; useCache < 2; useCache++ )
+    {
+        double ms = measureBestMs( numRuns, [&]()
+        {
+            std::vector<ColliderCache> caches( numPairs );
+            numContacts = 0;
+
+            for ( int step = 0; step < numSteps; step++ )
+            {
+                Real wobble = ( Real )step * 0.002f;
+
+                for ( int i = 0; i < numPairs; i++ )
+                {
+                    const Pair& pair = pairs[i];
+                    Transform transformA( Vector4( 0.f, 0.f ), pair.rotA + wobble );
+                    Transform transformB( pair.offset + Vector4( wobble, -wobble ), pair.rotB - wobble );
+
+                    ContactManifold contacts;
+                    physicsConvexCollider::collide( pair.shapeA, pair.shapeB, transformA, transformB, contacts, useCache ? &caches[i] : nullptr );
+                    numContacts += contacts.getNumContacts();
+                }
+            }
+        } );
+
+        printf( "convex collider %s, %d pairs, %d steps, %d contacts: %.2f ms\n", useCache ? "warm started" : "cold",
+                numPairs, numSteps, numContacts, ms );
+    }
+}
+
+// Circle pairs of a packed pile through the batch kernels and through the scalar collider
+void circleBatchBenchmark()
+{
+    const int numCircles = 2000;
+    const int numRuns = 20;
+
+    srand( 3 );
+
+    std::vector<Vector4> positions;
+    std::vector<Real> radii;
+    std::vector<std::shared_ptr<physicsShape>> shapes;
+
+    for ( int i = 0; i < numCircles; i++ )
+    {
+        Real radius = ( Real )( rand() % 5 + 8 );
+        positions.push_back( Vector4( ( Real )( i % 50 ) * 20.f + ( Real )( rand() % 5 ), ( Real )( i / 50 ) * 20.f + ( Real )( rand() % 5 ) ) );
+        radii.push_back( radius );
+        shapes.push_back( physicsCircleShape::create( radius ) );
+    }
+
+    // Neighbours close enough to be broadphase pairs, most of them touching
+    std::vector<std::pair<int, int>> pairs;
+
+    for ( int i = 0; i < numCircles; i++ )
+    {
+        for ( int j = i + 1; j < numCircles && j <= i + 51; j++ )
+        {
+            if ( ( positions[j] - positions[i] ).length<2>() < radii[i] + radii[j] + 4.f )
+            {
+                pairs.push_back( std::make_pair( i, j ) );
+            }
+        }
+    }
+
+    int numPairs = ( int )pairs.size();
+    int numTouching = 0;
+    physicsCircleBatch batch;
+    std::vector<int> touching;
+
+    double batchMs = measureBestMs( numRuns, [&]()
+    {
+        batch.resize( numPairs );
+
+        for ( int i = 0; i < numPairs; i++ )
+        {
+            batch.set( i, positions[pairs[i].first], radii[pairs[i].first], positions[pairs[i].second], radii[pairs[i].second] );
+        }
+
+        touching.clear();
+        batch.collide( touching );
+
+        // Contacts only for touching pairs, like the world does
+        numTouching = 0;
+
+        for ( auto iter = touching.begin(); iter != touching.end(); iter++ )
+        {
+            Vector4 norm = batch.getNormal( *iter );
+            ContactPoint contact( batch.getDepth( *iter ), norm * batch.getRadiusA( *iter ), norm * -batch.getRadiusB( *iter ), norm );
+            numTouching += ( contact.getDepth() > 0.f ) ? 1 : 0;
+        }
+    } );
+
+    double scalarMs = measureBestMs( numRuns, [&]()
+    {
+        numTouching = 0;
+
+        for ( auto iter = pairs.begin(); iter != pairs.end(); iter++ )
+        {
+            ContactManifold contacts;
+            physicsCircleCollider::collide( shapes[iter->first].get(), shapes[iter->second].get(),
+                                            Transform( positions[iter->first], 0.f ), Transform( positions[iter->second], 0.f ), contacts );
+            numTouching += contacts.getNumContacts();
+        }
+    } );
+
+    printf( "circle pairs, %d pairs, %d touching: batch %.3f ms, scalar collider %.3f ms\n", numPairs, numTouching, batchMs, scalarMs );
+}
+
+// Steps of a settled pile in a box, sleeping is off so everything keeps being simulated
+void worldStepBenchmark( const char* name, const std::vector<std::shared_ptr<physicsShape>>& shapes, const int numBodies, const int width )
+{
+    const int numSettleSteps = 300;
+    const int numSteps = 200;
+
+    physicsWorldConfig config;
+    config.m_allowSleeping = false;
+    physicsWorld world( config );
+
+    Real containerHalfWidth = ( Real )width * 12.f + 20.f;
+    std::shared_ptr<physicsShape> floor = physicsBoxShape::create( Vector4( containerHalfWidth + 20.f, 20.f ) );
+    std::shared_ptr<physicsShape> wall = physicsBoxShape::create( Vector4( 20.f, 2000.f ) );
+
+    physicsBodyCinfo container[3];
+    container[0].m_shape = floor;
+    container[0].m_pos = Vector4( 0.f, -20.f );
+    container[1].m_shape = wall;
+    container[1].m_pos = Vector4( -containerHalfWidth - 20.f, 2000.f );
+    container[2].m_shape = wall;
+    container[2].m_pos = Vector4( containerHalfWidth + 20.f, 2000.f );
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        container[i].m_motionType = physicsMotionType::STATIC;
+        world.createBody( container[i] );
+    }
+
+    for ( int i = 0; i < numBodies; i++ )
+    {
+        physicsBodyCinfo cinfo;
+        cinfo.m_shape = shapes[i % shapes.size()];
+        cinfo.m_pos = Vector4( ( ( Real )( i % width ) - ( Real )width * 0.5f ) * 24.f + 12.f, 20.f + ( Real )( i / width ) * 24.f );
+        world.createBody( cinfo );
+    }
+
+    for ( int step = 0; step < numSettleSteps; step++ )
+    {
+        world.step();
+    }
+
+    double ms = measureBestMs( 1, [&]()
+    {
+        for ( int step = 0; step < numSteps; step++ )
+        {
+            world.step();
+        }
+    } );
+
+    printf( "world step, %s, %d bodies: %.3f ms per step\n", name, numBodies, ms / numSteps );
+}
+
+void narrowphaseBenchmark()
+{
+    supportBenchmark();
+    gjkWarmStartBenchmark();
+    circleBatchBenchmark();
+
+    std::vector<std::shared_ptr<physicsShape>> mixed;
+    mixed.push_back( physicsBoxShape::create( Vector4( 10.f, 10.f ) ) );
+    mixed.push_back( makeRoundConvexShape( 6, 11.f ) );
+    mixed.push_back( physicsCircleShape::create( 10.f ) );
+    worldStepBenchmark( "mixed boxes, hexagons and circles", mixed, 300, 20 );
+
+    std::vector<std::shared_ptr<physicsShape>> circles;
+    circles.push_back( physicsCircleShape::create( 10.f ) );
+    circles.push_back( physicsCircleShape::create( 8.f ) );
+    worldStepBenchmark( "packed circles", circles, 2000, 50 );
+}
@@ -0,0 +1,721 @@
+#pragma once
+
+#include <physicsCircleBatch.h>
+#include <physicsCollider.h>
+#include <physicsShape.h>
+#include <physicsWorld.h>
+
+#include <vector>
+#include <cstdlib>
+
+// Circle batch kernels should agree with scalar circle test, including padding past the last pair
+void circleBatchTest()
+{
+    const int numPairs = 37;
+
+    srand( 0 );
+
+    physicsCircleBatch batch;
+    batch.resize( numPairs );
+
+    std::vector<Vector4> posA, posB;
+    std::vector<Real> radiusA, radiusB;
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        posA.push_back( Vector4( ( Real )( rand() % 100 ), ( Real )( rand() % 100 ) ) );
+        radiusA.push_back( ( Real )( rand() % 20 + 1 ) );
+        radiusB.push_back( ( Real )( rand() % 20 + 1 ) );
+
+        // Some concentric pairs, which can't be pushed apart
+        posB.push_back( ( i % 9 == 0 ) ? posA[i] : Vector4( ( Real )( rand() % 100 ), ( Real )( rand() % 100 ) ) );
+
+        batch.set( i, posA[i], radiusA[i], posB[i], radiusB[i] );
+    }
+
+    std::vector<int> touching;
+    batch.collide( touching );
+
+    std::vector<int> bruteTouching;
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        Vector4 ab = posB[i] - posA[i];
+        Real dist = ab.length<2>();
+
+        if ( dist > 0.f && dist < radiusA[i] + radiusB[i] )
+        {
+            bruteTouching.push_back( i );
+
+            Vector4 normal = batch.getNormal( i );
+            Assert( fabs( batch.getDepth( i ) - ( radiusA[i] + radiusB[i] - dist ) ) < 1e-3f, "circle batch depth mismatch" );
+            Assert( fabs( normal( 0 ) - ab( 0 ) / dist ) < 1e-5f && fabs( normal( 1 ) - ab( 1 ) / dist ) < 1e-5f, "circle batch normal mismatch" );
+        }
+    }
+
+    Assert( touching == bruteTouching, "circle batch touching pairs don't match scalar test" );
+
+    // Wide kernel should give what two narrow ones do, lane for lane
+    for ( int start = 0; start + 8 <= numPairs; start += 8 )
+    {
+        unsigned int narrowMask = batch.collide4( start ) | ( batch.collide4( start + 4 ) << 4 );
+
+        Real depth[8], normalX[8], normalY[8];
+
+        for ( int i = 0; i < 8; i++ )
+        {
+            depth[i] = batch.getDepth( start + i );
+            normalX[i] = batch.getNormal( start + i )( 0 );
+            normalY[i] = batch.getNormal( start + i )( 1 );
+        }
+
+        unsigned int wideMask = batch.collide8( start );
+        Assert( wideMask == narrowMask, "circle batch 8 wide kernel touches different pairs" );
+
+        for ( int i = 0; i < 8; i++ )
+        {
+            if ( wideMask & ( 1 << i ) )
+            {
+                Assert( batch.getDepth( start + i ) == depth[i] && batch.getNormal( start + i )( 0 ) == normalX[i] && batch.getNormal( start + i )( 1 ) == normalY[i],
+                        "circle batch 8 wide kernel results differ" );
+            }
+        }
+    }
+
+    // Shrinking leaves dropped pairs as padding which never touches
+    batch.resize( 5 );
+    touching.clear();
+    batch.collide( touching );
+
+    for ( auto iter = touching.begin(); iter != touching.end(); iter++ )
+    {
+        Assert( *iter < 5, "circle batch padding touched" );
+    }
+}
+
+bool isNear( const Vector4& a, const Vector4& b, const Real tolerance = 1e-3f )
+{
+    return ( a - b ).length<2>() < tolerance;
+}
+
+// Contact point of A or B back in world space
+Vector4 getWorldContact( const Transform& transform, const Vector4& local )
+{
+    return transform.getTranslation() + local.getRotatedDir( transform.getRotation() );
+}
+
+// Separated, face and corner contacts of two boxes, the whole setup is turned by some angle
+void boxColliderTest()
+{
+    const Real angle = 0.4f;
+
+    std::shared_ptr<physicsShape> box = physicsBoxShape::create( Vector4( 10.f, 10.f ) );
+    Vector4 axisX = Vector4( 1.f, 0.f ).getRotatedDir( angle );
+    Vector4 axisY = Vector4( 0.f, 1.f ).getRotatedDir( angle );
+    Transform transformA( Vector4( 0.f, 0.f ), angle );
+
+    ContactManifold contacts;
+
+    // Separated along A's +x face
+    physicsBoxCollider::collide( box.get(), box.get(), transformA, Transform( axisX * 21.f, angle ), contacts );
+    Assert( contacts.isEmpty(), "separated boxes touched" );
+
+    // B overlaps A's +x face by 1, both of B's -x face corners touch
+    contacts.clear();
+    Transform transformB( axisX * 19.f + axisY * 2.f, angle );
+    physicsBoxCollider::collide( box.get(), box.get(), transformA, transformB, contacts );
+    Assert( contacts.getNumContacts() == 2, "box face contact should have two points" );
+
+    unsigned int featureIds[2];
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        const ContactPoint& contact = contacts[i];
+        unsigned int id = contact.getFeatureId();
+
+        Assert( isNear( contact.getNormal(), axisX ), "box face contact normal should point from A to B" );
+        Assert( fabs( contact.getDepth() - 1.f ) < 1e-3f, "box face contact depth" );
+        Assert( ( id >> 24 ) == 0 && ( ( id >> 16 ) & 0xff ) == 0 && ( ( id >> 8 ) & 0xff ) == 2, "box face contact should be A's +x face against B's -x face" );
+
+        // Point on A is on its face, point on B is its corner
+        Assert( fabs( contact.getContactA()( 0 ) - 10.f ) < 1e-3f, "box contact on A isn't on reference face" );
+        Assert( fabs( contact.getContactB()( 0 ) + 10.f ) < 1e-3f, "box contact on B isn't on incident face" );
+
+        featureIds[i] = id;
+    }
+
+    Assert( featureIds[0] != featureIds[1], "box contact points share feature Id" );
+
+    // Small motion keeps the same features
+    contacts.clear();
+    physicsBoxCollider::collide( box.get(), box.get(), transformA, Transform( axisX * 19.2f + axisY * 2.5f, angle ), contacts );
+    Assert( contacts.getNumContacts() == 2, "box face contact lost a point" );
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        Assert( contacts[i].getFeatureId() == featureIds[0] || contacts[i].getFeatureId() == featureIds[1], "box feature Ids changed with small motion" );
+    }
+
+    // Shapes passed the other way around, normal flips and points swap
+    ContactManifold flippedContacts;
+    physicsBoxCollider::collide( box.get(), box.get(), transformB, transformA, flippedContacts );
+    Assert( flippedContacts.getNumContacts() == 2, "flipped box face contact should have two points" );
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        Assert( isNear( flippedContacts[i].getNormal(), axisX.getNegated() ), "flipped box contact normal should point from B to A" );
+        Assert( fabs( flippedContacts[i].getDepth() - 1.f ) < 1e-3f, "flipped box contact depth" );
+    }
+
+    // B turned by 45 degrees, its corner goes 1 into A's +x face
+    Real cornerDist = 10.f + 10.f * sqrt( 2.f ) - 1.f;
+    contacts.clear();
+    physicsBoxCollider::collide( box.get(), box.get(), transformA, Transform( axisX * cornerDist, angle + 45.f * g_degToRad ), contacts );
+    Assert( contacts.getNumContacts() == 1, "box corner contact should have one point" );
+    Assert( isNear( contacts[0].getNormal(), axisX ), "box corner contact normal should be A's face normal" );
+    Assert( fabs( contacts[0].getDepth() - 1.f ) < 1e-2f, "box corner contact depth" );
+    Assert( ( ( contacts[0].getFeatureId() >> 16 ) & 0xff ) == 0, "box corner contact should be on A's +x face" );
+    Assert( isNear( getWorldContact( transformA, contacts[0].getContactA() ), axisX * 10.f, 1e-2f ), "box corner contact on A" );
+}
+
+// Separated, face, corner and deep contacts of a circle and a box, then the same pair flipped
+void circleBoxColliderTest()
+{
+    const Real angle = -0.7f;
+
+    std::shared_ptr<physicsShape> circle = physicsCircleShape::create( 5.f );
+    std::shared_ptr<physicsShape> box = physicsBoxShape::create( Vector4( 10.f, 10.f ) );
+    Transform transformB( Vector4( 3.f, -2.f ), angle );
+
+    // Circle center in box space, expected normal from box to circle in box space, depth and feature
+    struct Case
+    {
+        Vector4 center;
+        Vector4 normal;
+        Real depth;
+        unsigned int featureId;
+        bool isTouching;
+    };
+
+    Real invSqrt2 = 1.f / sqrt( 2.f );
+
+    Case cases[] =
+    {
+        { Vector4( 16.f, 0.f ), Vector4( 1.f, 0.f ), 0.f, 0, false },
+        { Vector4( 14.f, 3.f ), Vector4( 1.f, 0.f ), 1.f, 0, true },
+        { Vector4( -2.f, -14.f ), Vector4( 0.f, -1.f ), 1.f, 3, true },
+        { Vector4( 13.f, 13.f ), Vector4( invSqrt2, invSqrt2 ), 5.f - 3.f * sqrt( 2.f ), 5, true },
+        { Vector4( -13.f, 13.f ), Vector4( -invSqrt2, invSqrt2 ), 5.f - 3.f * sqrt( 2.f ), 6, true },
+        { Vector4( 8.f, 1.f ), Vector4( 1.f, 0.f ), 7.f, 0, true }, // Center inside
+    };
+
+    const int numCases = sizeof( cases ) / sizeof( cases[0] );
+
+    for ( int i = 0; i < numCases; i++ )
+    {
+        const Case& c = cases[i];
+        Transform transformA( transformB.getTranslation() + c.center.getRotatedDir( angle ), 0.3f );
+
+        ContactManifold contacts;
+        physicsCircleBoxCollider::collide( circle.get(), box.get(), transformA, transformB, contacts );
+
+        if ( !c.isTouching )
+        {
+            Assert( contacts.isEmpty(), "separated circle and box touched" );
+            continue;
+        }
+
+        Assert( contacts.getNumContacts() == 1, "circle box contact should have one point" );
+
+        // Normal points from circle to box
+        Vector4 normalAb = c.normal.getRotatedDir( angle ).getNegated();
+        ContactPoint contact = contacts[0];
+
+        Assert( isNear( contact.getNormal(), normalAb ), "circle box contact normal" );
+        Assert( fabs( contact.getDepth() - c.depth ) < 1e-3f, "circle box contact depth" );
+        Assert( contact.getFeatureId() == c.featureId, "circle box contact feature Id" );
+
+        Vector4 onCircle = getWorldContact( transformA, contact.getContactA() );
+        Vector4 onBox = getWorldContact( transformB, contact.getContactB() );
+        Assert( isNear( onCircle, transformA.getTranslation() + normalAb * 5.f ), "circle box contact on circle" );
+        Assert( fabs( ( onCircle - onBox ).dot<2>( normalAb ) - c.depth ) < 1e-3f, "circle box contact points don't span depth" );
+
+        // World passes box first as B and flips contacts, which should look like a box-circle collider's
+        contact.flip();
+        Assert( isNear( contact.getNormal(), normalAb.getNegated() ), "flipped circle box normal should point from box to circle" );
+        Assert( isNear( getWorldContact( transformB, contact.getContactA() ), onBox ), "flipped circle box contact on box" );
+        Assert( isNear( getWorldContact( transformA, contact.getContactB() ), onCircle ), "flipped circle box contact on circle" );
+    }
+}
+
+// Contacts of a circle against every face and vertex of a convex polygon
+void circleConvexColliderTest()
+{
+    const Real angle = 0.9f;
+    const Real radius = 4.f;
+
+    std::vector<Vector4> vertices;
+    vertices.push_back( Vector4( -12.f, 1.f ) );
+    vertices.push_back( Vector4( -5.f, -10.f ) );
+    vertices.push_back( Vector4( 9.f, -8.f ) );
+    vertices.push_back( Vector4( 13.f, 4.f ) );
+    vertices.push_back( Vector4( 2.f, 11.f ) );
+
+    std::shared_ptr<physicsShape> circle = physicsCircleShape::create( radius );
+    std::shared_ptr<physicsShape> shape = physicsConvexShape::create( vertices, 0.f );
+    const physicsConvexShape* convex = static_cast< const physicsConvexShape* >( shape.get() );
+
+    const std::vector<Vector4>& hull = convex->getVertices();
+    const std::vector<int>& connectivity = convex->getConnectivity();
+    int numEdges = ( int )connectivity.size() - 1;
+    Assert( numEdges == 5, "convex hull should keep all vertices" );
+
+    Transform transformB( Vector4( -4.f, 7.f ), angle );
+
+    // Outward normals, edge turned the way the collider does
+    std::vector<Vector4> normals;
+
+    for ( int i = 0; i < numEdges; i++ )
+    {
+        const Vector4& v0 = hull[connectivity[i]];
+        const Vector4& v1 = hull[connectivity[i + 1]];
+
+        Vector4 normal( v0( 1 ) - v1( 1 ), v1( 0 ) - v0( 0 ) );
+        normal.normalize<2>();
+        normals.push_back( normal );
+    }
+
+    for ( int i = 0; i < numEdges; i++ )
+    {
+        const Vector4& v0 = hull[connectivity[i]];
+        const Vector4& v1 = hull[connectivity[i + 1]];
+        Vector4 midpoint = ( v0 + v1 ) * 0.5f;
+
+        for ( int isVertex = 0; isVertex < 2; isVertex++ )
+        {
+            // In front of face middle, or off vertex i between the normals of its faces
+            Vector4 normal = isVertex ? ( normals[( i + numEdges - 1 ) % numEdges] + normals[i] ) : normals[i];
+            normal.normalize<2>();
+
+            Vector4 closest = isVertex ? v0 : midpoint;
+            unsigned int featureId = isVertex ? numEdges + i : i;
+
+            for ( int isTouching = 0; isTouching < 2; isTouching++ )
+            {
+                Real depth = isTouching ? 1.f : -1.f;
+                Vector4 center = closest + normal * ( radius - depth );
+                Transform transformA( transformB.getTranslation() + center.getRotatedDir( angle ), 0.f );
+
+                ContactManifold contacts;
+                physicsCircleConvexCollider::collide( circle.get(), convex, transformA, transformB, contacts );
+
+                if ( !isTouching )
+                {
+                    Assert( contacts.isEmpty(), "separated circle and convex touched" );
+                    continue;
+                }
+
+                Assert( contacts.getNumContacts() == 1, "circle convex contact should have one point" );
+
+                const ContactPoint& contact = contacts[0];
+                Assert( isNear( contact.getNormal(), normal.getRotatedDir( angle ).getNegated() ), "circle convex normal should point from circle to convex" );
+                Assert( fabs( contact.getDepth() - depth ) < 1e-3f, "circle convex contact depth" );
+                Assert( contact.getFeatureId() == featureId, "circle convex contact feature Id" );
+                Assert( isNear( contact.getContactB(), closest ), "circle convex contact on convex" );
+            }
+        }
+    }
+}
+
+// Pairs whose first body has the shape later in collider registration are flipped by the world,
+// bodies landing on a static circle should come to rest on top of it either way
+void flippedDispatchTest()
+{
+    std::vector<Vector4> vertices;
+    vertices.push_back( Vector4( -10.f, -10.f ) );
+    vertices.push_back( Vector4( 12.f, -10.f ) );
+    vertices.push_back( Vector4( 0.f, 10.f ) );
+
+    std::shared_ptr<physicsShape> shapes[] = { physicsBoxShape::create( Vector4( 10.f, 10.f ) ), physicsConvexShape::create( vertices, 0.f ) };
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        physicsWorldConfig config;
+        config.m_allowSleeping = false;
+        physicsWorld world( config );
+
+        // Created first so falling body has the larger Id and its shape goes first
+        physicsBodyCinfo ground;
+        ground.m_shape = physicsCircleShape::create( 50.f );
+        ground.m_motionType = physicsMotionType::STATIC;
+        world.createBody( ground );
+
+        physicsBodyCinfo falling;
+        falling.m_shape = shapes[i];
+        falling.m_pos = Vector4( 0.f, 80.f );
+        BodyId fallingId = world.createBody( falling );
+
+        for ( int step = 0; step < 300; step++ )
+        {
+            world.step();
+        }
+
+        const physicsBody& body = world.getBody( fallingId );
+        Assert( body.getPosition()( 1 ) > 55.f && body.getPosition()( 1 ) < 65.f, "body didn't come to rest on flipped pair" );
+        Assert( body.getLinearVelocity().length<2>() < 5.f, "body on flipped pair is still moving" );
+    }
+}
+
+// Convex polygon with vertices around a circle at jittered angles, every vertex is on the hull
+std::shared_ptr<physicsShape> makeRoundConvexShape( const int numVertices, const Real radius )
+{
+    std::vector<Vector4> vertices;
+
+    for ( int i = 0; i < numVertices; i++ )
+    {
+        Real angle = ( ( Real )i + ( Real )( rand() % 50 ) * 0.01f ) * 360.f * g_degToRad / ( Real )numVertices;
+        vertices.push_back( Vector4( radius * cos( angle ), radius * sin( angle ) ) );
+    }
+
+    return physicsConvexShape::create( vertices, 0.f );
+}
+
+// Hill climbed supports should be the vertex furthest along direction from any start, like scanning every vertex
+void hillClimbSupportTest()
+{
+    srand( 2 );
+
+    const int vertexCounts[] = { 3, 4, 7, 32, 256 };
+    const int numVertexCounts = sizeof( vertexCounts ) / sizeof( vertexCounts[0] );
+
+    for ( int i = 0; i < numVertexCounts; i++ )
+    {
+        std::shared_ptr<physicsShape> shape = makeRoundConvexShape( vertexCounts[i], 50.f );
+
+        std::vector<Vector4> hull;
+        shape->getHullVertices( hull );
+        Assert( ( int )hull.size() == vertexCounts[i], "round convex shape lost hull vertices" );
+
+        int coherentIdx = 0;
+
+        for ( int j = 0; j < 500; j++ )
+        {
+            // Sweeps around slowly so coherent start is near the answer, lengths vary since they shouldn't matter
+            Real angle = ( Real )j * 0.05f;
+            Vector4 direction = Vector4( cos( angle ), sin( angle ) ) * ( Real )( rand() % 100 + 1 ) * 0.1f;
+
+            Real bestDot = std::numeric_limits<Real>::lowest();
+
+            for ( auto iter = hull.begin(); iter != hull.end(); iter++ )
+            {
+                bestDot = std::max( bestDot, direction.dot<2>( *iter ) );
+            }
+
+            int randomIdx = rand() % ( vertexCounts[i] + 2 ) - 1; // Including out of range starts
+            int* starts[] = { &coherentIdx, &randomIdx };
+
+            for ( int k = 0; k < 2; k++ )
+            {
+                Vector4 support;
+                shape->getSupportingVertexFrom( direction, *starts[k], support );
+
+                Assert( fabs( direction.dot<2>( support ) - bestDot ) < 1e-3f, "hill climbed support isn't furthest vertex" );
+                Assert( hull[*starts[k]] == support, "hill climb left start at another vertex than support" );
+            }
+        }
+    }
+
+    // Box picks its corner from direction signs
+    std::shared_ptr<physicsShape> box = physicsBoxShape::create( Vector4( 10.f, 4.f ) );
+    std::vector<Vector4> corners;
+    box->getHullVertices( corners );
+
+    for ( int j = 0; j < 100; j++ )
+    {
+        Vector4 direction( ( Real )( rand() % 21 - 10 ), ( Real )( rand() % 21 - 10 ) );
+        Real bestDot = std::numeric_limits<Real>::lowest();
+
+        for ( auto iter = corners.begin(); iter != corners.end(); iter++ )
+        {
+            bestDot = std::max( bestDot, direction.dot<2>( *iter ) );
+        }
+
+        Vector4 support;
+        box->getSupportingVertex( direction, support );
+        Assert( direction.dot<2>( support ) == bestDot, "box support isn't furthest corner" );
+    }
+}
+
+// Duplicate, collinear and interior vertices should stay out of the hull, so climbing still finds the furthest one
+void convexHullCleanupTest()
+{
+    srand( 5 );
+
+    // Square given out of order, with a vertex in the middle of two sides, one inside and a corner twice
+    std::vector<Vector4> vertices;
+    vertices.push_back( Vector4( 20.f, 20.f ) );
+    vertices.push_back( Vector4( 0.f, -20.f ) );
+    vertices.push_back( Vector4( -20.f, -20.f ) );
+    vertices.push_back( Vector4( 3.f, 4.f ) );
+    vertices.push_back( Vector4( 20.f, -20.f ) );
+    vertices.push_back( Vector4( 20.f, 5.f ) );
+    vertices.push_back( Vector4( -20.f, 20.f ) );
+    vertices.push_back( Vector4( 20.f, 20.f ) );
+
+    std::shared_ptr<physicsShape> shape = physicsConvexShape::create( vertices, 0.f );
+
+    std::vector<Vector4> hull;
+    shape->getHullVertices( hull );
+    Assert( hull.size() == 4, "convex hull should be the square's corners" );
+
+    for ( auto iter = hull.begin(); iter != hull.end(); iter++ )
+    {
+        Assert( fabs( ( *iter )( 0 ) ) == 20.f && fabs( ( *iter )( 1 ) ) == 20.f, "convex hull kept a vertex which isn't a corner" );
+    }
+
+    int coherentIdx = 0;
+
+    for ( int i = 0; i < 400; i++ )
+    {
+        Real angle = ( Real )i * 0.05f;
+        Vector4 direction( cos( angle ), sin( angle ) );
+
+        Real bestDot = std::numeric_limits<Real>::lowest();
+
+        for ( auto iter = vertices.begin(); iter != vertices.end(); iter++ )
+        {
+            bestDot = std::max( bestDot, direction.dot<2>( *iter ) );
+        }
+
+        int randomIdx = rand() % 4;
+        int* starts[] = { &coherentIdx, &randomIdx };
+
+        for ( int k = 0; k < 2; k++ )
+        {
+            Vector4 support;
+            shape->getSupportingVertexFrom( direction, *starts[k], support );
+            Assert( fabs( direction.dot<2>( support ) - bestDot ) < 1e-3f, "hill climbed support on cleaned hull isn't furthest vertex" );
+        }
+    }
+}
+
+// Convex collider contacts should be the same whether GJK starts from last step's simplex or from scratch.
+// Bodies circle each other, turning, so pairs go in and out of contact and the cache goes stale in every way
+void gjkWarmStartTest()
+{
+    srand( 3 );
+
+    std::shared_ptr<physicsShape> shapes[] =
+    {
+        makeRoundConvexShape( 6, 20.f ),
+        makeRoundConvexShape( 5, 15.f ),
+        makeRoundConvexShape( 3, 25.f ),
+        makeRoundConvexShape( 40, 10.f ),
+    };
+
+    const int numShapes = sizeof( shapes ) / sizeof( shapes[0] );
+
+    for ( int a = 0; a < numShapes; a++ )
+    {
+        for ( int b = 0; b < numShapes; b++ )
+        {
+            ColliderCache cache;
+            int numTouching = 0;
+
+            for ( int step = 0; step < 400; step++ )
+            {
+                Real t = ( Real )step * 0.02f;
+                Real dist = 25.f + 15.f * sin( t * 3.f );
+                Transform transformA( Vector4( 0.f, 0.f ), t * 0.5f );
+                Transform transformB( Vector4( dist * cos( t ), dist * sin( t ) ), -t );
+
+                ContactManifold warm, cold;
+                physicsConvexCollider::collide( shapes[a].get(), shapes[b].get(), transformA, transformB, warm, &cache );
+                physicsConvexCollider::collide( shapes[a].get(), shapes[b].get(), transformA, transformB, cold );
+
+                if ( warm.getNumContacts() != cold.getNumContacts() )
+                {
+                    // GJK stops once it gets within its tolerance of the origin, so barely touching pairs can go either way
+                    const ContactManifold& found = warm.isEmpty() ? cold : warm;
+                    Assert( warm.isEmpty() != cold.isEmpty() && found[0].getDepth() < 0.25f, "warm started GJK found different contacts" );
+                    continue;
+                }
+
+                for ( int i = 0; i < warm.getNumContacts(); i++ )
+                {
+                    Vector4 warmNormal = warm[i].getNormal().getNormalized<2>();
+                    Vector4 coldNormal = cold[i].getNormal().getNormalized<2>();
+
+                    Assert( isNear( warmNormal, coldNormal, 1e-2f ), "warm started GJK contact normal differs" );
+                    Assert( fabs( warm[i].getDepth() - cold[i].getDepth() ) < 1e-2f, "warm started GJK contact depth differs" );
+                }
+
+                numTouching += warm.isEmpty() ? 0 : 1;
+            }
+
+            Assert( numTouching > 0 && numTouching < 400, "warm start test pair should both touch and separate" );
+            Assert( cache.hasSimplex, "GJK never stored a simplex to warm start from" );
+        }
+    }
+}
+
+// EPA on boxes made convex shapes should find the same penetration as the SAT box collider
+void epaBoxDepthTest()
+{
+    srand( 4 );
+
+    const Vector4 halfExtentsA( 10.f, 6.f );
+    const Vector4 halfExtentsB( 8.f, 8.f );
+
+    std::shared_ptr<physicsShape> boxA = physicsBoxShape::create( halfExtentsA );
+    std::shared_ptr<physicsShape> boxB = physicsBoxShape::create( halfExtentsB );
+
+    std::vector<Vector4> cornersA, cornersB;
+    boxA->getHullVertices( cornersA );
+    boxB->getHullVertices( cornersB );
+
+    std::shared_ptr<physicsShape> convexA = physicsConvexShape::create( cornersA, 0.f );
+    std::shared_ptr<physicsShape> convexB = physicsConvexShape::create( cornersB, 0.f );
+
+    int numCompared = 0;
+
+    for ( int i = 0; i < 300; i++ )
+    {
+        Transform transformA( Vector4( 0.f, 0.f ), ( Real )( rand() % 628 ) * 0.01f );
+        Real angle = ( Real )( rand() % 628 ) * 0.01f;
+        Real dist = ( Real )( rand() % 200 ) * 0.1f + 2.f;
+        Transform transformB( Vector4( dist * cos( angle ), dist * sin( angle ) ), ( Real )( rand() % 628 ) * 0.01f );
+
+        ContactManifold satContacts, epaContacts;
+        physicsBoxCollider::collide( boxA.get(), boxB.get(), transformA, transformB, satContacts );
+        physicsConvexCollider::collide( convexA.get(), convexB.get(), transformA, transformB, epaContacts );
+
+        if ( satContacts.isEmpty() || epaContacts.isEmpty() )
+        {
+            continue;
+        }
+
+        // Box collider reports depth per clipped point, penetration is the deepest
+        int deepest = ( satContacts.getNumContacts() > 1 && satContacts[1].getDepth() > satContacts[0].getDepth() ) ? 1 : 0;
+        const ContactPoint& sat = satContacts[deepest];
+        const ContactPoint& epa = epaContacts[0];
+
+        Assert( fabs( sat.getDepth() - epa.getDepth() ) < 1e-2f, "EPA depth doesn't match SAT for boxes" );
+        Assert( isNear( sat.getNormal(), epa.getNormal().getNormalized<2>(), 1e-2f ), "EPA normal doesn't match SAT for boxes" );
+        numCompared++;
+    }
+
+    Assert( numCompared > 100, "too few overlapping boxes to compare EPA against SAT" );
+}
+
+// Box corner sliding on a convex slab keeps its feature id, another corner touching gets another one
+void convexFeatureIdTest()
+{
+    std::vector<Vector4> slabVertices;
+    slabVertices.push_back( Vector4( -50.f, -10.f ) );
+    slabVertices.push_back( Vector4( 50.f, -10.f ) );
+    slabVertices.push_back( Vector4( 50.f, 10.f ) );
+    slabVertices.push_back( Vector4( -50.f, 10.f ) );
+
+    std::shared_ptr<physicsShape> slab = physicsConvexShape::create( slabVertices, 0.f );
+    std::shared_ptr<physicsShape> box = physicsBoxShape::create( Vector4( 5.f, 5.f ) );
+
+    // Lowest corner of the tilted box 1 deep into the slab's top
+    const Real tilt = 0.5f;
+    const Real height = 10.f + 5.f * ( sin( tilt ) + cos( tilt ) ) - 1.f;
+
+    unsigned int featureIds[2];
+
+    for ( int turn = 0; turn < 2; turn++ )
+    {
+        ColliderCache cache;
+        Real rot = tilt + ( Real )turn * 90.f * g_degToRad;
+
+        for ( int step = 0; step < 20; step++ )
+        {
+            Transform transformA( Vector4( 0.f, 0.f ), 0.f );
+            Transform transformB( Vector4( ( Real )step * 0.5f - 5.f, height ), rot );
+
+            ContactManifold contacts;
+            physicsConvexCollider::collide( slab.get(), box.get(), transformA, transformB, contacts, &cache );
+
+            Assert( contacts.getNumContacts() == 1, "box corner should touch slab" );
+            Assert( fabs( contacts[0].getDepth() - 1.f ) < 1e-2f, "box corner depth is off" );
+            Assert( contacts[0].getFeatureId() != ContactPoint::INVALID_FEATURE_ID, "box and convex contact should have a feature id" );
+
+            if ( step == 0 )
+            {
+                featureIds[turn] = contacts[0].getFeatureId();
+            }
+
+            Assert( contacts[0].getFeatureId() == featureIds[turn], "feature id changed while same corner and face touch" );
+        }
+    }
+
+    Assert( featureIds[0] != featureIds[1], "different box corners got same feature id" );
+}
+
+// Manifold points should keep their impulses while the same features touch, whatever order contacts come in
+void manifoldFeatureMatchTest()
+{
+    CachedPair pair( 2, 1 );
+
+    ContactManifold contacts;
+    contacts.addContact( ContactPoint( 1.f, Vector4( 1.f, 0.f ), Vector4( -1.f, 0.f ), Vector4( 1.f, 0.f ), 7 ) );
+    contacts.addContact( ContactPoint( 1.f, Vector4( 1.f, 1.f ), Vector4( -1.f, 1.f ), Vector4( 1.f, 0.f ), 9 ) );
+    pair.updateManifold( contacts );
+
+    Assert( pair.numPoints == 2, "manifold didn't take both contacts" );
+    Assert( pair.points[0].normalImpulse == 0.f && pair.points[1].tangentImpulse == 0.f, "new manifold points should start without impulse" );
+
+    // Solver stores impulses back on points
+    pair.points[0].normalImpulse = 3.f;
+    pair.points[0].tangentImpulse = -1.f;
+    pair.points[1].normalImpulse = 5.f;
+    pair.points[1].tangentImpulse = 2.f;
+
+    // Feature 9 comes first now, feature 7 is gone and 4 is new
+    contacts.clear();
+    contacts.addContact( ContactPoint( 1.f, Vector4( 1.f, 1.f ), Vector4( -1.f, 1.f ), Vector4( 1.f, 0.f ), 9 ) );
+    contacts.addContact( ContactPoint( 1.f, Vector4( 1.f, -1.f ), Vector4( -1.f, -1.f ), Vector4( 1.f, 0.f ), 4 ) );
+    pair.updateManifold( contacts );
+
+    Assert( pair.numPoints == 2, "manifold lost a point" );
+    Assert( pair.points[0].contact.getFeatureId() == 9 && pair.points[0].normalImpulse == 5.f && pair.points[0].tangentImpulse == 2.f,
+            "matched feature didn't keep its impulses" );
+    Assert( pair.points[1].contact.getFeatureId() == 4 && pair.points[1].normalImpulse == 0.f && pair.points[1].tangentImpulse == 0.f,
+            "new feature took over impulses" );
+
+    // Separating clears the manifold, touching again starts from zero
+    pair.updateManifold( ContactManifold() );
+    Assert( pair.numPoints == 0, "separated pair kept manifold points" );
+
+    contacts.clear();
+    contacts.addContact( ContactPoint( 1.f, Vector4( 1.f, 1.f ), Vector4( -1.f, 1.f ), Vector4( 1.f, 0.f ), 9 ) );
+    pair.updateManifold( contacts );
+    Assert( pair.numPoints == 1 && pair.points[0].normalImpulse == 0.f, "impulses survived separation" );
+
+    // Contacts without a feature id never take over impulses, not even from each other
+    pair.points[0].normalImpulse = 3.f;
+    contacts.clear();
+    contacts.addContact( ContactPoint( 1.f, Vector4( 1.f, 1.f ), Vector4( -1.f, 1.f ), Vector4( 1.f, 0.f ), ContactPoint::INVALID_FEATURE_ID ) );
+    pair.updateManifold( contacts );
+    pair.points[0].normalImpulse = 3.f;
+    pair.updateManifold( contacts );
+    Assert( pair.numPoints == 1 && pair.points[0].normalImpulse == 0.f, "contact without feature id was warm started" );
+}
+
+void narrowphaseTest()
+{
+    circleBatchTest();
+    boxColliderTest();
+    circleBoxColliderTest();
+    circleConvexColliderTest();
+    flippedDispatchTest();
+    hillClimbSupportTest();
+    convexHullCleanupTest();
+    gjkWarmStartTest();
+    epaBoxDepthTest();
+    convexFeatureIdTest();
+    manifoldFeatureMatchTest();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "BenchmarkUtils.h"
+#include "SolverTest.h"
+#include <physicsSolver.h>
+#include <physicsThreadPool.h>
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+// One contact solve with each solver mode, including preparing rows or blocks
+void solverBenchmark()
+{
+    const int numBodies = 2000;
+    const int numPairs = 6000;
+    const int numRuns = 50;
+
+    SolverInfo info;
+    info.m_deltaTime = 0.016f;
+    info.m_numIter = 8;
+
+    std::vector<SolverBody> bodies;
+    std::vector<ConstrainedPair> pairs;
+
+    // Pairs between bodies close in id, like neighbours in a pile
+    ContactPairsConfig config;
+    config.seed = 1;
+    config.staticPeriod = 100;
+    config.hubPeriod = 0;
+    config.maxIdOffset = 30;
+    config.friction = 0.5f;
+    makeContactPairs( numBodies, numPairs, bodies, pairs, config );
+
+    physicsThreadPool threadPool( 4 );
+
+    const char* modeNames[] = { "sequential", "colored", "colored 4 threads", "wide" };
+
+    for ( int mode = 0; mode < 4; mode++ )
+    {
+        physicsSolver solver;
+        solver.setParallel( mode == 1 || mode == 2 );
+        solver.setWide( mode == 3 );
+
+        if ( mode == 2 )
+        {
+            solver.setThreadPool( &threadPool );
+        }
+
+        // Every run starts from the same velocities and warm start impulses, copies are made outside of timing
+        std::vector<std::vector<SolverBody>> runBodies( numRuns, bodies );
+        std::vector<std::vector<ConstrainedPair>> runPairs( numRuns, pairs );
+        int run = 0;
+
+        double ms = measureBestMs( numRuns, [&]()
+        {
+            solver.solveConstraints( info, true, runPairs[run], runBodies[run] );
+            run++;
+        } );
+
+        printf( "solver %s, %d bodies, %d pairs, %d iterations: %.2f ms\n", modeNames[mode], numBodies, numPairs, info.m_numIter, ms );
+    }
+}
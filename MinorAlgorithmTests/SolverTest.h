@@ -0,0 +1,493 @@
+#pragma once
+
+#include <physicsConstraintColoring.h>
+#include <physicsContactBatch.h>
+#include <physicsSolver.h>
+#include <physicsThreadPool.h>
+
+#include <vector>
+#include <cstdlib>
+#include <limits>
+
+// Colors should cover every pair once, keep pair order and never put two pairs sharing a dynamic body together
+void constraintColoringTest()
+{
+    const int numBodies = 200;
+    const int numPairs = 3000;
+
+    srand( 0 );
+
+    std::vector<SolverBody> bodies( numBodies );
+
+    for ( int i = 0; i < numBodies; i++ )
+    {
+        // A few static bodies every pair can touch without conflicts
+        bool isStatic = ( i % 50 == 0 );
+        bodies[i].mInv = isStatic ? 0.f : 1.f;
+        bodies[i].iInv = isStatic ? 0.f : 1.f;
+    }
+
+    std::vector<ConstrainedPair> pairs;
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        // Pile up pairs on body 1 so some of them run out of colors
+        BodyId a = ( BodyId )( ( i % 4 == 0 ) ? 1 : rand() % numBodies );
+        BodyId b = ( BodyId )( ( a + 1 + rand() % ( numBodies - 1 ) ) % numBodies );
+        pairs.push_back( ConstrainedPair( a, b ) );
+    }
+
+    physicsConstraintColoring coloring;
+    coloring.build( pairs, bodies );
+
+    Assert( coloring.getNumColors() == physicsConstraintColoring::MAX_COLORS, "colors weren't used up" );
+    Assert( coloring.hasOverflow(), "pairs of overused body didn't overflow" );
+
+    const std::vector<int>& pairIndices = coloring.getPairIndices();
+    std::vector<int> timesColored( numPairs, 0 );
+
+    for ( int colorIdx = 0; colorIdx <= coloring.getNumColors(); colorIdx++ )
+    {
+        int start, end;
+        coloring.getColorRange( colorIdx, start, end );
+
+        std::vector<bool> bodyUsed( numBodies, false );
+
+        for ( int i = start; i < end; i++ )
+        {
+            timesColored[pairIndices[i]]++;
+            Assert( i == start || pairIndices[i] > pairIndices[i - 1], "pair order changed inside color" );
+
+            if ( colorIdx == coloring.getNumColors() )
+            {
+                // Overflow may share bodies
+                continue;
+            }
+
+            const ConstrainedPair& pair = pairs[pairIndices[i]];
+            BodyId bodyIds[] = { pair.bodyIdA, pair.bodyIdB };
+
+            for ( int j = 0; j < 2; j++ )
+            {
+                if ( bodies[bodyIds[j]].mInv == 0.f )
+                {
+                    continue;
+                }
+
+                Assert( !bodyUsed[bodyIds[j]], "dynamic body shared inside color" );
+                bodyUsed[bodyIds[j]] = true;
+            }
+        }
+    }
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        Assert( timesColored[i] == 1, "pair not colored exactly once" );
+    }
+
+    // Static bodies alone don't need more than one color
+    std::vector<ConstrainedPair> staticPairs;
+
+    for ( int i = 1; i < numBodies; i++ )
+    {
+        if ( i % 50 != 0 )
+        {
+            staticPairs.push_back( ConstrainedPair( i, 0 ) );
+        }
+    }
+
+    coloring.build( staticPairs, bodies );
+    Assert( coloring.getNumColors() == 1 && !coloring.hasOverflow(), "static body made pairs conflict" );
+}
+
+// Solves one row of a pair from its Jacobian, working out everything rows prepare up front
+void solveContactRow( const Constraint& constraint, const Real friction, const Real normalImp, const bool isNormal,
+                      SolverBody& bodyA, SolverBody& bodyB, Real& accumImp, const Real deltaTime )
+{
+    const Jacobian& jac = constraint.jac;
+
+    Real jv = jac.vA( 0 ) * bodyA.v( 0 ) + jac.vA( 1 ) * bodyA.v( 1 ) + jac.wA( 2 ) * bodyA.w( 2 ) +
+              jac.vB( 0 ) * bodyB.v( 0 ) + jac.vB( 1 ) * bodyB.v( 1 ) + jac.wB( 2 ) * bodyB.w( 2 );
+
+    Real JmJ = jac.vA.dot<2>( jac.vA ) * bodyA.mInv + jac.wA( 2 ) * jac.wA( 2 ) * bodyA.iInv +
+               jac.vB.dot<2>( jac.vB ) * bodyB.mInv + jac.wB( 2 ) * jac.wB( 2 ) * bodyB.iInv;
+
+    Real impulse = ( 0.2f * constraint.error / deltaTime - jv ) / JmJ;
+    Real maxImp = isNormal ? std::numeric_limits<Real>::max() : friction * normalImp;
+    Real newImp = std::max( isNormal ? 0.f : -maxImp, std::min( accumImp + impulse, maxImp ) );
+
+    impulse = newImp - accumImp;
+    accumImp = newImp;
+
+    bodyA.v += jac.vA * impulse * bodyA.mInv;
+    bodyA.w += jac.wA * impulse * bodyA.iInv;
+    bodyB.v += jac.vB * impulse * bodyB.mInv;
+    bodyB.w += jac.wB * impulse * bodyB.iInv;
+}
+
+// How makeContactPairs picks bodies and friction, defaults are what tests use
+struct ContactPairsConfig
+{
+    unsigned int seed;
+    int staticPeriod; // Every this many bodies is static
+    int hubPeriod; // Every this many pairs has body 1 in it, 0 for none
+    int maxIdOffset; // Second body is at most this many ids after the first, 0 for any
+    Real friction; // Negative for random friction per pair
+
+    ContactPairsConfig() : seed( 0 ), staticPeriod( 10 ), hubPeriod( 3 ), maxIdOffset( 0 ), friction( -1.f ) {}
+};
+
+// Random contact pairs with a normal and tangent row per point, a few static bodies and by default one body in many pairs.
+// Angular parts of Jacobians come from contact points rotated with their bodies, like narrowphase contacts
+void makeContactPairs( const int numBodies, const int numPairs, std::vector<SolverBody>& bodiesOut, std::vector<ConstrainedPair>& pairsOut,
+                       const ContactPairsConfig& config = ContactPairsConfig() )
+{
+    srand( config.seed );
+
+    bodiesOut.assign( numBodies, SolverBody() );
+
+    for ( int i = 0; i < numBodies; i++ )
+    {
+        bool isStatic = ( i % config.staticPeriod == 0 );
+        bodiesOut[i].v = Vector4( ( Real )( rand() % 21 - 10 ), ( Real )( rand() % 21 - 10 ) );
+        bodiesOut[i].w = Vector4( 0.f, 0.f, ( Real )( rand() % 5 - 2 ) );
+        bodiesOut[i].pos = Vector4( 0.f, 0.f );
+        bodiesOut[i].ori = ( Real )( rand() % 360 ) * g_degToRad;
+        bodiesOut[i].mInv = isStatic ? 0.f : 1.f / ( Real )( rand() % 10 + 1 );
+        bodiesOut[i].iInv = isStatic ? 0.f : 1.f / ( Real )( rand() % 100 + 10 );
+    }
+
+    pairsOut.clear();
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        // Hub body is in enough pairs to overflow colors, static bodies are never paired with each other
+        BodyId a = ( BodyId )( ( config.hubPeriod > 0 && i % config.hubPeriod == 0 ) ? 1 : rand() % numBodies );
+        BodyId b = ( BodyId )( ( a + 1 + rand() % ( ( config.maxIdOffset > 0 ) ? config.maxIdOffset : numBodies - 1 ) ) % numBodies );
+
+        if ( a % config.staticPeriod == 0 && b % config.staticPeriod == 0 )
+        {
+            b++;
+        }
+
+        ConstrainedPair pair( a, b );
+        pair.friction = ( config.friction < 0.f ) ? ( Real )( rand() % 10 ) * 0.1f : config.friction;
+
+        int numPoints = rand() % 2 + 1;
+
+        for ( int j = 0; j < numPoints; j++ )
+        {
+            Real angle = ( Real )( rand() % 360 ) * g_degToRad;
+            Vector4 normal( cos( angle ), sin( angle ) );
+            Vector4 tangent( -normal( 1 ), normal( 0 ) );
+
+            Constraint contact;
+            contact.rA = Vector4( ( Real )( rand() % 11 - 5 ), ( Real )( rand() % 11 - 5 ) );
+            contact.rB = Vector4( ( Real )( rand() % 11 - 5 ), ( Real )( rand() % 11 - 5 ) );
+
+            Vector4 rA = contact.rA.getRotatedDir( bodiesOut[pair.bodyIdA].ori );
+            Vector4 rB = contact.rB.getRotatedDir( bodiesOut[pair.bodyIdB].ori );
+
+            contact.jac.vA = normal.getNegated();
+            contact.jac.vB = normal;
+            contact.jac.wA = rA.cross( contact.jac.vA );
+            contact.jac.wB = rB.cross( contact.jac.vB );
+            contact.error = ( Real )( rand() % 10 ) * 0.1f;
+            contact.accumImp = ( Real )( rand() % 10 );
+            pair.constraints.push_back( contact );
+
+            Constraint friction = contact;
+            friction.jac.vA = tangent;
+            friction.jac.vB = tangent.getNegated();
+            friction.jac.wA = rA.cross( friction.jac.vA );
+            friction.jac.wB = rB.cross( friction.jac.vB );
+            friction.error = 0.f;
+            friction.accumImp = 0.f;
+            pair.constraints.push_back( friction );
+        }
+
+        pairsOut.push_back( pair );
+    }
+}
+
+// Kernels are protected, this runs every block through both widths
+class ContactBatchKernels : public physicsContactBatch
+{
+public:
+
+    // Warm start and one iteration with the 8 wide kernels and with two 4 wide ones, true if every lane comes out the same
+    bool widthsMatch( const std::vector<SolverBody>& bodies ) const
+    {
+        for ( auto iter = m_blocks.begin(); iter != m_blocks.end(); iter++ )
+        {
+            Velocities vel;
+            gather( *iter, bodies, vel );
+
+            Block wideBlock = *iter;
+            Velocities wideVel = vel;
+            warmStart8( wideBlock, wideVel );
+            solve8( wideBlock, wideVel );
+
+            Block narrowBlock = *iter;
+            Velocities narrowVel = vel;
+            warmStart4( narrowBlock, 0, narrowVel );
+            warmStart4( narrowBlock, 4, narrowVel );
+            solve4( narrowBlock, 0, narrowVel );
+            solve4( narrowBlock, 4, narrowVel );
+
+            for ( int lane = 0; lane < WIDTH; lane++ )
+            {
+                if ( wideVel.vAx[lane] != narrowVel.vAx[lane] || wideVel.vAy[lane] != narrowVel.vAy[lane] || wideVel.wA[lane] != narrowVel.wA[lane] ||
+                     wideVel.vBx[lane] != narrowVel.vBx[lane] || wideVel.vBy[lane] != narrowVel.vBy[lane] || wideVel.wB[lane] != narrowVel.wB[lane] )
+                {
+                    return false;
+                }
+
+                for ( int rowIdx = 0; rowIdx < MAX_ROWS; rowIdx++ )
+                {
+                    if ( wideBlock.rows[rowIdx].accumImp[lane] != narrowBlock.rows[rowIdx].accumImp[lane] )
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+// Wide contacts should solve like scalar rows in the same color order, including padding lanes and overflow
+void contactBatchTest()
+{
+    const int numBodies = 40;
+    const int numPairs = 300;
+
+    SolverInfo info;
+    info.m_deltaTime = 0.016f;
+    info.m_numIter = 4;
+
+    std::vector<SolverBody> bodies;
+    std::vector<ConstrainedPair> pairs;
+    makeContactPairs( numBodies, numPairs, bodies, pairs );
+
+    physicsConstraintColoring coloring;
+    coloring.build( pairs, bodies );
+    Assert( coloring.hasOverflow(), "test pairs should overflow colors" );
+
+    // With AVX2 the 8 wide kernels are separate code, without it they are the 4 wide ones twice
+    ContactBatchKernels kernels;
+    kernels.build( info, coloring, pairs, bodies );
+    Assert( kernels.widthsMatch( bodies ), "8 wide contact kernels don't match 4 wide ones" );
+
+    std::vector<SolverBody> refBodies = bodies;
+    std::vector<ConstrainedPair> refPairs = pairs;
+
+    physicsSolver wideSolver;
+    wideSolver.setWide( true );
+    wideSolver.solveConstraints( info, true, pairs, bodies );
+
+    // Parallel mode without threads goes through pairs in color order, one row at a time
+    physicsSolver scalarSolver;
+    scalarSolver.setParallel( true );
+    scalarSolver.solveConstraints( info, true, refPairs, refBodies );
+
+    for ( int i = 0; i < numBodies; i++ )
+    {
+        Vector4 dv = bodies[i].v - refBodies[i].v;
+        Real dw = bodies[i].w( 2 ) - refBodies[i].w( 2 );
+        Assert( dv.length<2>() < 1e-2f && fabs( dw ) < 1e-3f, "wide contact solve doesn't match scalar" );
+    }
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        for ( int j = 0; j < ( int )pairs[i].constraints.size(); j++ )
+        {
+            Real diff = pairs[i].constraints[j].accumImp - refPairs[i].constraints[j].accumImp;
+            Assert( fabs( diff ) < 1e-2f, "wide contact impulses don't match scalar" );
+        }
+    }
+}
+
+// Prepared rows should solve contacts like computing everything per iteration, in the order pairs are given
+void solverRowsTest()
+{
+    const int numBodies = 40;
+    const int numPairs = 300;
+
+    SolverInfo info;
+    info.m_deltaTime = 0.016f;
+    info.m_numIter = 4;
+
+    std::vector<SolverBody> bodies;
+    std::vector<ConstrainedPair> pairs;
+    makeContactPairs( numBodies, numPairs, bodies, pairs );
+
+    std::vector<SolverBody> refBodies = bodies;
+    std::vector<ConstrainedPair> refPairs = pairs;
+
+    physicsSolver solver;
+    solver.solveConstraints( info, true, pairs, bodies );
+
+    for ( int pass = -1; pass < info.m_numIter; pass++ )
+    {
+        for ( int i = 0; i < numPairs; i++ )
+        {
+            ConstrainedPair& pair = refPairs[i];
+            SolverBody& bodyA = refBodies[pair.bodyIdA];
+            SolverBody& bodyB = refBodies[pair.bodyIdB];
+
+            for ( int j = 0; j < ( int )pair.constraints.size(); j++ )
+            {
+                Constraint& constraint = pair.constraints[j];
+
+                if ( pass < 0 )
+                {
+                    bodyA.v += constraint.jac.vA * constraint.accumImp * bodyA.mInv;
+                    bodyA.w += constraint.jac.wA * constraint.accumImp * bodyA.iInv;
+                    bodyB.v += constraint.jac.vB * constraint.accumImp * bodyB.mInv;
+                    bodyB.w += constraint.jac.wB * constraint.accumImp * bodyB.iInv;
+                    continue;
+                }
+
+                bool isNormal = ( j % 2 == 0 );
+                Real normalImp = isNormal ? 0.f : pair.constraints[j - 1].accumImp;
+                solveContactRow( constraint, pair.friction, normalImp, isNormal, bodyA, bodyB, constraint.accumImp, info.m_deltaTime );
+            }
+        }
+    }
+
+    for ( int i = 0; i < numBodies; i++ )
+    {
+        Vector4 dv = bodies[i].v - refBodies[i].v;
+        Real dw = bodies[i].w( 2 ) - refBodies[i].w( 2 );
+        Assert( dv.length<2>() < 1e-2f && fabs( dw ) < 1e-3f, "prepared rows don't match solving constraints directly" );
+    }
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        for ( int j = 0; j < ( int )pairs[i].constraints.size(); j++ )
+        {
+            Real diff = pairs[i].constraints[j].accumImp - refPairs[i].constraints[j].accumImp;
+            Assert( fabs( diff ) < 1e-2f, "prepared rows didn't store impulses" );
+        }
+    }
+}
+
+// Colored solve should give bit-identical results on any number of threads, for scalar rows and wide blocks
+void parallelSolverTest()
+{
+    const int numBodies = 200;
+    const int numPairs = 1000;
+
+    SolverInfo info;
+    info.m_deltaTime = 0.016f;
+    info.m_numIter = 4;
+
+    std::vector<SolverBody> bodies;
+    std::vector<ConstrainedPair> pairs;
+    makeContactPairs( numBodies, numPairs, bodies, pairs );
+
+    physicsThreadPool threadPool( 4 );
+
+    for ( int isWide = 0; isWide < 2; isWide++ )
+    {
+        std::vector<SolverBody> singleBodies = bodies;
+        std::vector<ConstrainedPair> singlePairs = pairs;
+
+        physicsSolver singleSolver;
+        singleSolver.setParallel( true );
+        singleSolver.setWide( isWide != 0 );
+        singleSolver.solveConstraints( info, true, singlePairs, singleBodies );
+
+        std::vector<SolverBody> threadedBodies = bodies;
+        std::vector<ConstrainedPair> threadedPairs = pairs;
+
+        physicsSolver threadedSolver;
+        threadedSolver.setParallel( true );
+        threadedSolver.setWide( isWide != 0 );
+        threadedSolver.setThreadPool( &threadPool );
+        threadedSolver.solveConstraints( info, true, threadedPairs, threadedBodies );
+
+        for ( int i = 0; i < numBodies; i++ )
+        {
+            bool isSame = ( singleBodies[i].v( 0 ) == threadedBodies[i].v( 0 ) &&
+                            singleBodies[i].v( 1 ) == threadedBodies[i].v( 1 ) &&
+                            singleBodies[i].w( 2 ) == threadedBodies[i].w( 2 ) );
+            Assert( isSame, "threads changed solved velocities" );
+        }
+
+        for ( int i = 0; i < numPairs; i++ )
+        {
+            for ( int j = 0; j < ( int )pairs[i].constraints.size(); j++ )
+            {
+                Assert( singlePairs[i].constraints[j].accumImp == threadedPairs[i].constraints[j].accumImp, "threads changed solved impulses" );
+            }
+        }
+    }
+}
+
+// Normal impulses should end up pushing only, tangent ones inside friction cone of their point's normal impulse,
+// even when warm started outside of it. Checked for every solver mode
+void frictionClampTest()
+{
+    const int numBodies = 100;
+    const int numPairs = 400;
+
+    SolverInfo info;
+    info.m_deltaTime = 0.016f;
+    info.m_numIter = 4;
+
+    std::vector<SolverBody> bodies;
+    std::vector<ConstrainedPair> pairs;
+    makeContactPairs( numBodies, numPairs, bodies, pairs );
+
+    for ( int i = 0; i < numPairs; i++ )
+    {
+        for ( int j = 1; j < ( int )pairs[i].constraints.size(); j += 2 )
+        {
+            pairs[i].constraints[j].accumImp = ( Real )( rand() % 41 - 20 );
+        }
+    }
+
+    for ( int mode = 0; mode < 3; mode++ )
+    {
+        std::vector<SolverBody> modeBodies = bodies;
+        std::vector<ConstrainedPair> modePairs = pairs;
+
+        physicsSolver solver;
+        solver.setParallel( mode == 1 );
+        solver.setWide( mode == 2 );
+        solver.solveConstraints( info, true, modePairs, modeBodies );
+
+        int numOnCone = 0;
+
+        for ( int i = 0; i < numPairs; i++ )
+        {
+            const ConstrainedPair& pair = modePairs[i];
+
+            for ( int j = 0; j < ( int )pair.constraints.size(); j += 2 )
+            {
+                Real normalImp = pair.constraints[j].accumImp;
+                Real tangentImp = pair.constraints[j + 1].accumImp;
+                Real maxTangentImp = pair.friction * normalImp;
+
+                Assert( normalImp >= 0.f, "normal impulse pulls bodies together" );
+                Assert( fabs( tangentImp ) <= maxTangentImp * 1.0001f + 1e-5f, "tangent impulse outside friction cone" );
+
+                numOnCone += ( maxTangentImp > 0.f && fabs( tangentImp ) >= maxTangentImp * 0.9999f ) ? 1 : 0;
+            }
+        }
+
+        Assert( numOnCone > 0, "no tangent impulse was clamped to friction cone" );
+    }
+}
+
+void solverTest()
+{
+    constraintColoringTest();
+    contactBatchTest();
+    solverRowsTest();
+    parallelSolverTest();
+    frictionClampTest();
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <physicsWorld.h>
+#include <physicsShape.h>
+
+#include <vector>
+
+// Steps until no body is awake, asserts if that takes too long
+void stepUntilAsleep( physicsWorld& world )
+{
+    const int maxSteps = 1000;
+
+    for ( int step = 0; step < maxSteps && !world.getAwakeBodyIds().empty(); step++ )
+    {
+        world.step();
+    }
+
+    Assert( world.getAwakeBodyIds().empty(), "bodies didn't fall asleep" );
+}
+
+bool areAllAwake( const physicsWorld& world, const std::vector<BodyId>& bodyIds )
+{
+    for ( auto iter = bodyIds.begin(); iter != bodyIds.end(); iter++ )
+    {
+        if ( world.getBody( *iter ).isSleeping() )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Box stack on static ground, next to it a box tied to a static anchor with a joint
+struct SleepTestScene
+{
+    physicsWorld world;
+    BodyId groundId;
+    BodyId anchorId;
+    BodyId tiedId;
+    std::vector<BodyId> stackIds;
+
+    SleepTestScene() : world( physicsWorldConfig() )
+    {
+        std::shared_ptr<physicsShape> box = physicsBoxShape::create( Vector4( 10.f, 10.f ) );
+
+        physicsBodyCinfo ground;
+        ground.m_shape = physicsBoxShape::create( Vector4( 200.f, 10.f ) );
+        ground.m_motionType = physicsMotionType::STATIC;
+        groundId = world.createBody( ground );
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            physicsBodyCinfo cinfo;
+            cinfo.m_shape = box;
+            cinfo.m_pos = Vector4( 0.f, 20.f + 20.f * i );
+            stackIds.push_back( world.createBody( cinfo ) );
+        }
+
+        physicsBodyCinfo tied;
+        tied.m_shape = box;
+        tied.m_pos = Vector4( 100.f, 20.f );
+        tiedId = world.createBody( tied );
+
+        // Like a mouse grab, a point which collides with nothing. It's away from the box so only the joint links them
+        physicsBodyCinfo anchor;
+        anchor.m_shape = physicsCircleShape::create( 0.f );
+        anchor.m_motionType = physicsMotionType::STATIC;
+        anchor.m_collidable = false;
+        anchor.m_pos = Vector4( 100.f, 50.f );
+        anchorId = world.createBody( anchor );
+
+        JointConfig joint;
+        joint.bodyIdA = anchorId;
+        joint.bodyIdB = tiedId;
+        joint.pivot = Vector4( 100.f, 50.f );
+        world.addJoint( joint );
+
+        stepUntilAsleep( world );
+    }
+};
+
+// Resting islands should fall asleep and every change touching them should wake the whole island
+void worldSleepTest()
+{
+    {
+        // Falling body wakes what it lands on through contact
+        SleepTestScene scene;
+
+        physicsBodyCinfo dropped;
+        dropped.m_shape = physicsBoxShape::create( Vector4( 10.f, 10.f ) );
+        dropped.m_pos = Vector4( 0.f, 150.f );
+        scene.world.createBody( dropped );
+
+        bool stackWoke = false;
+
+        for ( int step = 0; step < 100; step++ )
+        {
+            scene.world.step();
+            stackWoke = stackWoke || areAllAwake( scene.world, scene.stackIds );
+        }
+
+        Assert( stackWoke, "landing body didn't wake stack" );
+        stepUntilAsleep( scene.world );
+    }
+
+    {
+        // Moving the support wakes everything on it, moving a stacked body wakes its island
+        SleepTestScene scene;
+        scene.world.setPosition( scene.groundId, Vector4( 0.f, -100.f ) );
+        Assert( areAllAwake( scene.world, scene.stackIds ), "moving support didn't wake stack" );
+
+        SleepTestScene other;
+        other.world.setPosition( other.stackIds[2], Vector4( 0.f, 61.f ) );
+        Assert( areAllAwake( other.world, other.stackIds ), "moving stacked body didn't wake its island" );
+    }
+
+    {
+        // Joints to static bodies aren't in islands, moving the anchor still has to wake the tied body
+        SleepTestScene scene;
+        scene.world.setPosition( scene.anchorId, Vector4( 100.f, 100.f ) );
+        Assert( !scene.world.getBody( scene.tiedId ).isSleeping(), "moving anchor didn't wake jointed body" );
+    }
+
+    {
+        // Adding a joint ties islands together, removing it lets them go
+        SleepTestScene scene;
+
+        JointConfig joint;
+        joint.bodyIdA = scene.stackIds[2];
+        joint.bodyIdB = scene.tiedId;
+        joint.pivot = Vector4( 50.f, 40.f );
+        int jointId = scene.world.addJoint( joint );
+
+        Assert( areAllAwake( scene.world, scene.stackIds ), "adding joint didn't wake island" );
+        Assert( !scene.world.getBody( scene.tiedId ).isSleeping(), "adding joint didn't wake other body" );
+
+        stepUntilAsleep( scene.world );
+        scene.world.removeJoint( jointId );
+
+        Assert( areAllAwake( scene.world, scene.stackIds ), "removing joint didn't wake island" );
+        Assert( !scene.world.getBody( scene.tiedId ).isSleeping(), "removing joint didn't wake other body" );
+    }
+
+    {
+        // Removing a sleeping body or its support wakes what rested on it
+        SleepTestScene scene;
+        scene.world.removeBody( scene.stackIds[0] );
+        scene.stackIds.erase( scene.stackIds.begin() );
+        Assert( areAllAwake( scene.world, scene.stackIds ), "removing stacked body didn't wake island" );
+
+        SleepTestScene other;
+        other.world.removeBody( other.anchorId );
+        Assert( !other.world.getBody( other.tiedId ).isSleeping(), "removing anchor didn't wake jointed body" );
+
+        other.world.removeBody( other.groundId );
+        Assert( areAllAwake( other.world, other.stackIds ), "removing support didn't wake stack" );
+    }
+
+    {
+        // Turning a sleeping body static wakes the rest of its island, turning it back wakes it
+        SleepTestScene scene;
+        scene.world.setMotionType( scene.stackIds[0], physicsMotionType::STATIC );
+
+        std::vector<BodyId> above( scene.stackIds.begin() + 1, scene.stackIds.end() );
+        Assert( areAllAwake( scene.world, above ), "making body static didn't wake its island" );
+
+        stepUntilAsleep( scene.world );
+        scene.world.setMotionType( scene.stackIds[0], physicsMotionType::DYNAMIC );
+        Assert( areAllAwake( scene.world, scene.stackIds ), "making body dynamic didn't wake what rests on it" );
+    }
+}
+
+// Small circle hopping off another one faster than its scaled aabb margin covers in a step.
+// Scaled aabb's lose the pair together with its cached contact and find it again on landing,
+// predictive aabb's with a margin covering the hop keep the pair throughout
+void predictiveAabbTest()
+{
+    for ( int isPredictive = 0; isPredictive < 2; isPredictive++ )
+    {
+        physicsWorldConfig config;
+        config.m_gravity = Vector4( 0.f, -4000.f );
+        config.m_allowSleeping = false;
+        config.m_predictiveAabbs = ( isPredictive != 0 );
+        config.m_predictiveAabbMargin = 2.f;
+        physicsWorld world( config );
+
+        std::shared_ptr<physicsShape> circle = physicsCircleShape::create( 2.f );
+
+        physicsBodyCinfo ground;
+        ground.m_shape = circle;
+        ground.m_motionType = physicsMotionType::STATIC;
+        world.createBody( ground );
+
+        // Starts touching, moving up
+        physicsBodyCinfo hopping;
+        hopping.m_shape = circle;
+        hopping.m_pos = Vector4( 0.f, 3.9f );
+        hopping.m_linearVelocity = Vector4( 0.f, 200.f );
+        world.createBody( hopping );
+
+        int numRemovedPairs = 0;
+        int numLostContactCaches = 0;
+        int numStepsWithoutPair = 0;
+
+        for ( int step = 0; step < 12; step++ )
+        {
+            world.step();
+
+            const BroadphaseStats& stats = world.getBroadphaseStats();
+            numRemovedPairs += stats.numRemovedPairs;
+            numLostContactCaches += stats.numLostContactCaches;
+            numStepsWithoutPair += ( stats.numPairs == 0 ) ? 1 : 0;
+        }
+
+        Assert( world.getBroadphaseStats().numPairs == 1, "hopping body didn't land" );
+
+        if ( isPredictive )
+        {
+            Assert( numRemovedPairs == 0 && numStepsWithoutPair == 0, "predictive aabb's lost pair of hopping body" );
+        }
+        else
+        {
+            Assert( numRemovedPairs == 1 && numLostContactCaches == 1, "scaled aabb's should lose pair and contact cache of hopping body" );
+            Assert( numStepsWithoutPair > 0, "scaled aabb's kept pair of hopping body" );
+        }
+    }
+}
+
+// Contact arms are turned into world space with body's cached cos and sin, it should undo getLocalDir and turn counter-clockwise
+void bodyWorldDirTest()
+{
+    physicsWorld world( ( physicsWorldConfig() ) );
+
+    physicsBodyCinfo cinfo;
+    cinfo.m_shape = physicsBoxShape::create( Vector4( 10.f, 10.f ) );
+    cinfo.m_ori = 30.f * g_degToRad;
+    const physicsBody& body = world.getBody( world.createBody( cinfo ) );
+
+    Vector4 worldDir;
+    body.getWorldDir( Vector4( 1.f, 0.f ), worldDir );
+    Assert( fabs( worldDir( 0 ) - cos( cinfo.m_ori ) ) < 1e-5f && fabs( worldDir( 1 ) - sin( cinfo.m_ori ) ) < 1e-5f, "world direction isn't turned by body's rotation" );
+
+    Vector4 dir( 3.f, -7.f );
+    Vector4 localDir; body.getLocalDir( dir, localDir );
+    body.getWorldDir( localDir, worldDir );
+    Assert( fabs( worldDir( 0 ) - dir( 0 ) ) < 1e-4f && fabs( worldDir( 1 ) - dir( 1 ) ) < 1e-4f, "world direction doesn't undo local direction" );
+}
+
+// Pile of boxes, hexagons and circles dropped in a static box, stepped by a world with given thread count.
+// Returns bodies in creation order
+std::vector<physicsBody> stepMixedPile( const int numThreads, const bool parallelSolver, const bool wideContactSolver )
+{
+    physicsWorldConfig config;
+    config.m_numThreads = numThreads;
+    config.m_parallelSolver = parallelSolver;
+    config.m_wideContactSolver = wideContactSolver;
+    config.m_allowSleeping = false;
+    physicsWorld world( config );
+
+    std::shared_ptr<physicsShape> floor = physicsBoxShape::create( Vector4( 200.f, 20.f ) );
+    std::shared_ptr<physicsShape> wall = physicsBoxShape::create( Vector4( 20.f, 400.f ) );
+
+    physicsBodyCinfo container[3];
+    container[0].m_shape = floor;
+    container[0].m_pos = Vector4( 0.f, -20.f );
+    container[1].m_shape = wall;
+    container[1].m_pos = Vector4( -180.f, 400.f );
+    container[2].m_shape = wall;
+    container[2].m_pos = Vector4( 180.f, 400.f );
+
+    std::vector<BodyId> bodyIds;
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        container[i].m_motionType = physicsMotionType::STATIC;
+        bodyIds.push_back( world.createBody( container[i] ) );
+    }
+
+    std::vector<Vector4> hexagon;
+
+    for ( int i = 0; i < 6; i++ )
+    {
+        Real angle = ( Real )i * 60.f * g_degToRad;
+        hexagon.push_back( Vector4( 11.f * cos( angle ), 11.f * sin( angle ) ) );
+    }
+
+    std::shared_ptr<physicsShape> shapes[] =
+    {
+        physicsBoxShape::create( Vector4( 10.f, 10.f ) ),
+        physicsConvexShape::create( hexagon, 0.f ),
+        physicsCircleShape::create( 10.f ),
+    };
+
+    const int numShapes = sizeof( shapes ) / sizeof( shapes[0] );
+
+    for ( int i = 0; i < 120; i++ )
+    {
+        // Rows shifted by half a body so the pile tumbles instead of stacking
+        physicsBodyCinfo cinfo;
+        cinfo.m_shape = shapes[i % numShapes];
+        cinfo.m_pos = Vector4( ( Real )( i % 12 ) * 26.f - 145.f + ( Real )( ( i / 12 ) % 2 ) * 13.f, 20.f + ( Real )( i / 12 ) * 26.f );
+        bodyIds.push_back( world.createBody( cinfo ) );
+    }
+
+    for ( int step = 0; step < 200; step++ )
+    {
+        world.step();
+    }
+
+    std::vector<physicsBody> bodies;
+
+    for ( auto iter = bodyIds.begin(); iter != bodyIds.end(); iter++ )
+    {
+        bodies.push_back( world.getBody( *iter ) );
+    }
+
+    return bodies;
+}
+
+// Whole world steps should come out the same on any number of threads, bit for bit
+void worldThreadCountTest()
+{
+    for ( int mode = 0; mode < 3; mode++ )
+    {
+        bool parallelSolver = ( mode > 0 );
+        bool wideContactSolver = ( mode > 1 );
+
+        std::vector<physicsBody> single = stepMixedPile( 1, parallelSolver, wideContactSolver );
+        std::vector<physicsBody> threaded = stepMixedPile( 4, parallelSolver, wideContactSolver );
+
+        for ( int i = 0; i < ( int )single.size(); i++ )
+        {
+            bool isSame = ( single[i].getPosition()( 0 ) == threaded[i].getPosition()( 0 ) &&
+                            single[i].getPosition()( 1 ) == threaded[i].getPosition()( 1 ) &&
+                            single[i].getRotation() == threaded[i].getRotation() &&
+                            single[i].getLinearVelocity()( 0 ) == threaded[i].getLinearVelocity()( 0 ) &&
+                            single[i].getLinearVelocity()( 1 ) == threaded[i].getLinearVelocity()( 1 ) &&
+                            single[i].getAngularSpeed() == threaded[i].getAngularSpeed() );
+            Assert( isSame, "threads changed world step results" );
+        }
+    }
+}
+
+void worldTest()
+{
+    worldSleepTest();
+    predictiveAabbTest();
+    bodyWorldDirTest();
+    worldThreadCountTest();
+}
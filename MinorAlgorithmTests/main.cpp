@@ -2,13 +2,35 @@
 //#include "BodyIdPairSortTest.h"
 //#include "TransformsTest.h"
 #include "ArrayFreeListTest.h"
+#include "BroadphaseTest.h"
+#include "NarrowphaseTest.h"
+#include "SolverTest.h"
+#include "WorldTest.h"
+#include "BroadphaseBenchmark.h"
+#include "NarrowphaseBenchmark.h"
+#include "SolverBenchmark.h"
+
+#include <cstring>
 
 int main( int argc, char* argv[] )
 {
+    // Timings instead of tests, meant for optimized builds
+    if ( argc > 1 && strcmp( argv[1], "bench" ) == 0 )
+    {
+        broadphaseBenchmark();
+        narrowphaseBenchmark();
+        solverBenchmark();
+        return 0;
+    }
+
     //classifySetsTest();
 	//bodyIdPairSortTest();
 	//transformsTest();
     arrayFreeListTest();
+    broadphaseTest();
+    narrowphaseTest();
+    solverTest();
+    worldTest();
 
 	return 0;
 }
\ No newline at end of file
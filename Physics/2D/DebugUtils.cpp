@@ -1,6 +1,7 @@
 #include <Base.h>
 
 #include <DebugUtils.h>
+#include <Renderer.h>
 #include <physicsCollider.h>
 
 void DebugUtils::drawMinkowskiDifference( const physicsShape* shapeA,
@@ -31,32 +32,23 @@ void DebugUtils::drawContactNormal( const Vector4& contactA, const Vector4& norm
 	drawText( std::to_string( normal.length<2>() ), contactA + normal / 2 );
 }
 
-void DebugUtils::drawSimplex( const physicsConvexCollider::Simplex& simplex, unsigned int color )
+void DebugUtils::drawSimplex( const physicsConvexCollider::Polytope& simplex, unsigned int color )
 {
 	int szSimplex = ( int )simplex.size();
 
 	for ( int i = 0; i < szSimplex; i++ )
 	{
 		drawCross( simplex[i][0], 45.f * g_degToRad, 40.f, color );
-
-		if ( i == szSimplex - 1 )
-		{
-			drawLine( simplex[szSimplex - 1][0], simplex[0][0], color );
-		}
-		else
-		{
-			drawLine( simplex[i][0], simplex[i + 1][0], color );
-		}
+		drawLine( simplex[i][0], simplex[simplex.next[i]][0], color );
 	}
 }
 
-void DebugUtils::drawExpandedSimplex( const physicsConvexCollider::Simplex& simplex )
+void DebugUtils::drawExpandedSimplex( const physicsConvexCollider::Polytope& simplex )
 {
 	int szSimplex = ( int )simplex.size();
 	for ( int i = 0; i < szSimplex; i++ )
 	{
-		int j = i + 1 == szSimplex ? 0 : i + 1;
-		drawLine( simplex[i][0], simplex[j][0], BLUE );
+		drawLine( simplex[i][0], simplex[simplex.next[i]][0], BLUE );
 		std::stringstream ss;
 		ss << i << std::endl;
 		drawText( ss.str(), simplex[i][0] );
@@ -15,7 +15,10 @@
 // Solver
 #define D_SOLVER_IMPULSE
 
+// Drawing needs the renderer, physics built without it (like the test project) keeps every drawing flag off
+#if defined D_GJK_MINKOWSKI || defined D_GJK_CONTACT_LENGTH || defined D_GJK_SIMPLEX || defined D_EPA_SIMPLEX
 #include <Renderer.h>
+#endif
 
 #include <sstream>
 
@@ -32,6 +35,6 @@ namespace DebugUtils
 								  const Transform& transformA,
 								  const Transform& transformB );
 	void drawContactNormal( const Vector4& contactA, const Vector4& normal );
-	void drawSimplex( const physicsConvexCollider::Simplex& simplex, unsigned int color );
-	void drawExpandedSimplex( const physicsConvexCollider::Simplex& simplex );
+	void drawSimplex( const physicsConvexCollider::Polytope& simplex, unsigned int color );
+	void drawExpandedSimplex( const physicsConvexCollider::Polytope& simplex );
 }
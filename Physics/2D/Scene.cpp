@@ -314,6 +314,10 @@ std::shared_ptr<physicsWorld> initPhysicsScene()
 	wcfg.m_gravity.set( 0.f, -981.f );
 	wcfg.m_numIter = 4;
 
+	// Solver jitter grows with gravity, so do speeds bodies may rest at
+	wcfg.m_sleepLinearSpeed = 50.f;
+	wcfg.m_sleepAngularSpeed = 2.5f;
+
 	//return Scenes::oneConvexScene( wcfg );
 	//return Scenes::manyCirclesScene( wcfg );
 	return Scenes::massParticlesScene( wcfg );
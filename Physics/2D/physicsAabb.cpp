@@ -1,7 +1,5 @@
 #include <physicsAabb.h>
 
-#include <cstdlib> // abs()
-
 physicsAabb::physicsAabb()
 {
 	m_max.setAll( 0.f );
@@ -15,31 +13,25 @@ physicsAabb::physicsAabb( const Vector4& max, const Vector4& min )
 
 void physicsAabb::includeAabb( const physicsAabb& aabb )
 {
-	if ( m_max < aabb.m_max )
-	{
-		m_max = aabb.m_max;
-	}
-	if ( m_min > aabb.m_min )
-	{
-		m_min = aabb.m_min;
-	}
+	m_max.setMax( aabb.m_max );
+	m_min.setMin( aabb.m_min );
 }
 
-bool physicsAabb::overlaps( const physicsAabb& aabb )
+bool physicsAabb::overlaps( const physicsAabb& aabb ) const
 {
-	Vector4 centerA; centerA.setAdd( m_max, m_min );
-	centerA.setMul( centerA, 0.5f );
-
-	Vector4 centerB; centerB.setAdd( aabb.m_max, aabb.m_min );
-	centerB.setMul( centerB, 0.5f );
-
-	Real dx = abs( centerA( 0 ) - centerB( 0 ) );
-	Real dy = abs( centerA( 1 ) - centerB( 1 ) );
+	return ( m_min( 0 ) < aabb.m_max( 0 ) && aabb.m_min( 0 ) < m_max( 0 ) &&
+			 m_min( 1 ) < aabb.m_max( 1 ) && aabb.m_min( 1 ) < m_max( 1 ) );
+}
 
-	Real sumX = m_max( 0 ) - centerA( 0 ) + aabb.m_max( 0 ) - centerB( 0 );
-	Real sumY = m_max( 1 ) - centerA( 1 ) + aabb.m_max( 1 ) - centerB( 1 );
+bool physicsAabb::contains( const physicsAabb& aabb ) const
+{
+	return ( m_min( 0 ) <= aabb.m_min( 0 ) && aabb.m_max( 0 ) <= m_max( 0 ) &&
+			 m_min( 1 ) <= aabb.m_min( 1 ) && aabb.m_max( 1 ) <= m_max( 1 ) );
+}
 
-	return ( dx < sumX && dy < sumY );
+Real physicsAabb::getPerimeter() const
+{
+	return 2.f * ( ( m_max( 0 ) - m_min( 0 ) ) + ( m_max( 1 ) - m_min( 1 ) ) );
 }
 
 void physicsAabb::expand( const Real factor )
@@ -56,6 +48,13 @@ void physicsAabb::expand( const Vector4 & direction )
 	m_min.setMin( newMin );
 }
 
+void physicsAabb::enlarge( const Real margin )
+{
+	Vector4 marginVec( margin, margin );
+	m_max.setAdd( m_max, marginVec );
+	m_min.setSub( m_min, marginVec );
+}
+
 void physicsAabb::translate( const Vector4& translation )
 {
 	m_max.setAdd( m_max, translation );
@@ -9,9 +9,12 @@ public:
 	physicsAabb();
 	physicsAabb( const Vector4& max, const Vector4& min );
 	void includeAabb( const physicsAabb& aabb );
-	bool overlaps( const physicsAabb& aabb );
+	bool overlaps( const physicsAabb& aabb ) const;
+	bool contains( const physicsAabb& aabb ) const;
+	Real getPerimeter() const;
 	void expand( const Real factor );
 	void expand( const Vector4& direction );
+	void enlarge( const Real margin ); // Grows by margin on all sides
 	void translate( const Vector4& translation );
 
 	Vector4 m_max;
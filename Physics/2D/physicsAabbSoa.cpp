@@ -0,0 +1,96 @@
+#include <limits>
+#include <algorithm>
+
+#include <physicsAabbSoa.h>
+
+physicsAabbSoa::physicsAabbSoa() :
+	m_size( 0 )
+{
+
+}
+
+physicsAabbSoa::~physicsAabbSoa()
+{
+
+}
+
+void physicsAabbSoa::resize( const int size )
+{
+	// Padded entries past size are kept empty
+	int paddedSize = ( ( size + WIDTH - 1 ) / WIDTH ) * WIDTH;
+	int previousSize = m_size;
+
+	const Real inf = std::numeric_limits<Real>::infinity();
+
+	m_minX.resize( paddedSize, inf );
+	m_minY.resize( paddedSize, inf );
+	m_maxX.resize( paddedSize, -inf );
+	m_maxY.resize( paddedSize, -inf );
+
+	m_size = size;
+
+	for ( int i = size; i < std::min( previousSize, paddedSize ); i++ )
+	{
+		setEmpty( i );
+	}
+}
+
+void physicsAabbSoa::set( const int index, const physicsAabb& aabb )
+{
+	Assert( index < m_size, "setting aabb out of range" );
+
+	m_minX[index] = aabb.m_min( 0 );
+	m_minY[index] = aabb.m_min( 1 );
+	m_maxX[index] = aabb.m_max( 0 );
+	m_maxY[index] = aabb.m_max( 1 );
+}
+
+void physicsAabbSoa::setEmpty( const int index )
+{
+	const Real inf = std::numeric_limits<Real>::infinity();
+
+	m_minX[index] = inf;
+	m_minY[index] = inf;
+	m_maxX[index] = -inf;
+	m_maxY[index] = -inf;
+}
+
+void physicsAabbSoa::get( const int index, physicsAabb& aabbOut ) const
+{
+	aabbOut.m_min.set( m_minX[index], m_minY[index] );
+	aabbOut.m_max.set( m_maxX[index], m_maxY[index] );
+}
+
+void physicsAabbSoa::query( const physicsAabb& aabb, const int start, const int end, std::vector<int>& indicesOut ) const
+{
+	// Starts at a multiple of 4, entries outside of range are masked out
+	int i = start & ~3;
+
+#if defined( __AVX2__ )
+	for ( ; i < end && i + 8 <= ( int )m_minX.size(); i += 8 )
+	{
+		unsigned int mask = overlaps8( aabb, i );
+
+		for ( int bit = 0; mask != 0; bit++, mask >>= 1 )
+		{
+			if ( ( mask & 1 ) && i + bit >= start && i + bit < end )
+			{
+				indicesOut.push_back( i + bit );
+			}
+		}
+	}
+#endif
+
+	for ( ; i < end; i += 4 )
+	{
+		unsigned int mask = overlaps4( aabb, i );
+
+		for ( int bit = 0; mask != 0; bit++, mask >>= 1 )
+		{
+			if ( ( mask & 1 ) && i + bit >= start && i + bit < end )
+			{
+				indicesOut.push_back( i + bit );
+			}
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+#include <physicsAabb.h>
+
+// Structure-of-arrays aabb storage, bounds of each component are kept in separate arrays
+// so one aabb can be tested against several at once.
+// Arrays are padded to a multiple of WIDTH with empty aabb's which never overlap anything
+class physicsAabbSoa
+{
+public:
+
+	enum { WIDTH = 8 }; // Padding, enough for widest kernel
+
+	physicsAabbSoa();
+
+	~physicsAabbSoa();
+
+	// Newly exposed entries are empty
+	void resize( const int size );
+
+	void clear() { resize( 0 ); }
+
+	int getSize() const { return m_size; }
+
+	void set( const int index, const physicsAabb& aabb );
+
+	// Makes entry never overlap anything
+	void setEmpty( const int index );
+
+	void get( const int index, physicsAabb& aabbOut ) const;
+
+	inline bool overlaps( const int index, const physicsAabb& aabb ) const;
+
+	// Tests aabb against entries [start, start + 4), bit i of mask is set if start + i overlaps
+	inline unsigned int overlaps4( const physicsAabb& aabb, const int start ) const;
+
+	// Tests aabb against entries [start, start + 8), falls back to two SSE tests without AVX2
+	inline unsigned int overlaps8( const physicsAabb& aabb, const int start ) const;
+
+	// Appends indices of entries in [start, end) overlapping aabb
+	void query( const physicsAabb& aabb, const int start, const int end, std::vector<int>& indicesOut ) const;
+
+	void query( const physicsAabb& aabb, std::vector<int>& indicesOut ) const { query( aabb, 0, m_size, indicesOut ); }
+
+	const Real* getMinX() const { return m_minX.data(); }
+	const Real* getMinY() const { return m_minY.data(); }
+	const Real* getMaxX() const { return m_maxX.data(); }
+	const Real* getMaxY() const { return m_maxY.data(); }
+
+protected:
+
+	int m_size;
+
+	std::vector<Real> m_minX;
+	std::vector<Real> m_minY;
+	std::vector<Real> m_maxX;
+	std::vector<Real> m_maxY;
+};
+
+#include <physicsAabbSoa.inl>
@@ -0,0 +1,29 @@
+inline bool physicsAabbSoa::overlaps( const int index, const physicsAabb& aabb ) const
+{
+	return ( m_minX[index] < aabb.m_max( 0 ) && aabb.m_min( 0 ) < m_maxX[index] &&
+			 m_minY[index] < aabb.m_max( 1 ) && aabb.m_min( 1 ) < m_maxY[index] );
+}
+
+inline unsigned int physicsAabbSoa::overlaps4( const physicsAabb& aabb, const int start ) const
+{
+	__m128 overlapX = _mm_and_ps( _mm_cmplt_ps( _mm_loadu_ps( &m_minX[start] ), _mm_set1_ps( aabb.m_max( 0 ) ) ),
+								  _mm_cmplt_ps( _mm_set1_ps( aabb.m_min( 0 ) ), _mm_loadu_ps( &m_maxX[start] ) ) );
+	__m128 overlapY = _mm_and_ps( _mm_cmplt_ps( _mm_loadu_ps( &m_minY[start] ), _mm_set1_ps( aabb.m_max( 1 ) ) ),
+								  _mm_cmplt_ps( _mm_set1_ps( aabb.m_min( 1 ) ), _mm_loadu_ps( &m_maxY[start] ) ) );
+
+	return static_cast< unsigned int >( _mm_movemask_ps( _mm_and_ps( overlapX, overlapY ) ) );
+}
+
+inline unsigned int physicsAabbSoa::overlaps8( const physicsAabb& aabb, const int start ) const
+{
+#if defined( __AVX2__ )
+	__m256 overlapX = _mm256_and_ps( _mm256_cmp_ps( _mm256_loadu_ps( &m_minX[start] ), _mm256_set1_ps( aabb.m_max( 0 ) ), _CMP_LT_OQ ),
+									 _mm256_cmp_ps( _mm256_set1_ps( aabb.m_min( 0 ) ), _mm256_loadu_ps( &m_maxX[start] ), _CMP_LT_OQ ) );
+	__m256 overlapY = _mm256_and_ps( _mm256_cmp_ps( _mm256_loadu_ps( &m_minY[start] ), _mm256_set1_ps( aabb.m_max( 1 ) ), _CMP_LT_OQ ),
+									 _mm256_cmp_ps( _mm256_set1_ps( aabb.m_min( 1 ) ), _mm256_loadu_ps( &m_maxY[start] ), _CMP_LT_OQ ) );
+
+	return static_cast< unsigned int >( _mm256_movemask_ps( _mm256_and_ps( overlapX, overlapY ) ) );
+#else
+	return overlaps4( aabb, start ) | ( overlaps4( aabb, start + 4 ) << 4 );
+#endif
+}
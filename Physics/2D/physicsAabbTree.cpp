@@ -0,0 +1,346 @@
+#include <algorithm>
+
+#include <physicsAabbTree.h>
+
+physicsAabbTree::physicsAabbTree( const Real margin ) :
+	m_margin( margin ),
+	m_root( NULL_NODE ),
+	m_firstFree( NULL_NODE )
+{
+
+}
+
+physicsAabbTree::~physicsAabbTree()
+{
+
+}
+
+int physicsAabbTree::allocateNode()
+{
+	if ( m_firstFree == NULL_NODE )
+	{
+		Node node;
+		node.nextFree = NULL_NODE;
+		node.height = -1;
+		m_nodes.push_back( node );
+		m_firstFree = ( int )m_nodes.size() - 1;
+	}
+
+	int nodeId = m_firstFree;
+	Node& node = m_nodes[nodeId];
+	m_firstFree = node.nextFree;
+
+	node.parent = NULL_NODE;
+	node.children[0] = NULL_NODE;
+	node.children[1] = NULL_NODE;
+	node.height = 0;
+	node.bodyId = invalidId;
+
+	return nodeId;
+}
+
+void physicsAabbTree::freeNode( const int nodeId )
+{
+	m_nodes[nodeId].nextFree = m_firstFree;
+	m_nodes[nodeId].height = -1;
+	m_firstFree = nodeId;
+}
+
+int physicsAabbTree::createProxy( const physicsAabb& aabb, const BodyId bodyId )
+{
+	int proxyId = allocateNode();
+
+	Node& leaf = m_nodes[proxyId];
+	leaf.aabb = aabb;
+	leaf.aabb.enlarge( m_margin );
+	leaf.bodyId = bodyId;
+
+	insertLeaf( proxyId );
+
+	return proxyId;
+}
+
+void physicsAabbTree::destroyProxy( const int proxyId )
+{
+	Assert( m_nodes[proxyId].isLeaf(), "destroying non-leaf node" );
+
+	removeLeaf( proxyId );
+	freeNode( proxyId );
+}
+
+bool physicsAabbTree::moveProxy( const int proxyId, const physicsAabb& aabb )
+{
+	Assert( m_nodes[proxyId].isLeaf(), "moving non-leaf node" );
+
+	if ( m_nodes[proxyId].aabb.contains( aabb ) )
+	{
+		return false;
+	}
+
+	removeLeaf( proxyId );
+
+	m_nodes[proxyId].aabb = aabb;
+	m_nodes[proxyId].aabb.enlarge( m_margin );
+
+	insertLeaf( proxyId );
+
+	return true;
+}
+
+void physicsAabbTree::query( const physicsAabb& aabb, std::vector<BodyId>& bodyIdsOut ) const
+{
+	if ( m_root == NULL_NODE )
+	{
+		return;
+	}
+
+	// Queries run in parallel, so the stack is local and only moves to the heap if tree is deeper than expected
+	int fixedStack[MAX_QUERY_STACK];
+	std::vector<int> heapStack;
+	int* stack = fixedStack;
+	int stackCapacity = MAX_QUERY_STACK;
+	int stackSize = 0;
+	stack[stackSize++] = m_root;
+
+	while ( stackSize > 0 )
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		if ( !node.aabb.overlaps( aabb ) )
+		{
+			continue;
+		}
+
+		if ( node.isLeaf() )
+		{
+			bodyIdsOut.push_back( node.bodyId );
+		}
+		else
+		{
+			if ( stackSize + 2 > stackCapacity )
+			{
+				stackCapacity *= 2;
+				heapStack.resize( stackCapacity );
+
+				if ( stack == fixedStack )
+				{
+					std::copy( fixedStack, fixedStack + stackSize, heapStack.begin() );
+				}
+
+				stack = heapStack.data();
+			}
+
+			stack[stackSize++] = node.children[0];
+			stack[stackSize++] = node.children[1];
+		}
+	}
+}
+
+int physicsAabbTree::getHeight() const
+{
+	return ( m_root == NULL_NODE ) ? -1 : m_nodes[m_root].height;
+}
+
+void physicsAabbTree::insertLeaf( const int leafId )
+{
+	if ( m_root == NULL_NODE )
+	{
+		m_root = leafId;
+		m_nodes[leafId].parent = NULL_NODE;
+		return;
+	}
+
+	// Descend towards sibling which gives least perimeter increase
+	const physicsAabb leafAabb = m_nodes[leafId].aabb;
+	int siblingId = m_root;
+
+	while ( !m_nodes[siblingId].isLeaf() )
+	{
+		const Node& node = m_nodes[siblingId];
+
+		physicsAabb combined = node.aabb;
+		combined.includeAabb( leafAabb );
+
+		Real combinedPerimeter = combined.getPerimeter();
+
+		// Cost of making a new parent for node and leaf here
+		Real cost = 2.f * combinedPerimeter;
+
+		// Minimum cost of pushing leaf further down
+		Real inheritanceCost = 2.f * ( combinedPerimeter - node.aabb.getPerimeter() );
+
+		Real childCosts[2];
+
+		for ( int i = 0; i < 2; i++ )
+		{
+			const Node& child = m_nodes[node.children[i]];
+
+			physicsAabb childCombined = child.aabb;
+			childCombined.includeAabb( leafAabb );
+
+			childCosts[i] = childCombined.getPerimeter() + inheritanceCost;
+
+			if ( !child.isLeaf() )
+			{
+				childCosts[i] -= child.aabb.getPerimeter();
+			}
+		}
+
+		if ( cost < childCosts[0] && cost < childCosts[1] )
+		{
+			break;
+		}
+
+		siblingId = ( childCosts[0] < childCosts[1] ) ? node.children[0] : node.children[1];
+	}
+
+	// Replace sibling with new parent of sibling and leaf
+	int oldParentId = m_nodes[siblingId].parent;
+	int newParentId = allocateNode();
+
+	Node& newParent = m_nodes[newParentId];
+	newParent.parent = oldParentId;
+	newParent.aabb = leafAabb;
+	newParent.aabb.includeAabb( m_nodes[siblingId].aabb );
+	newParent.height = m_nodes[siblingId].height + 1;
+	newParent.children[0] = siblingId;
+	newParent.children[1] = leafId;
+
+	if ( oldParentId != NULL_NODE )
+	{
+		Node& oldParent = m_nodes[oldParentId];
+		oldParent.children[( oldParent.children[0] == siblingId ) ? 0 : 1] = newParentId;
+	}
+	else
+	{
+		m_root = newParentId;
+	}
+
+	m_nodes[siblingId].parent = newParentId;
+	m_nodes[leafId].parent = newParentId;
+
+	refitUpwards( oldParentId );
+}
+
+void physicsAabbTree::removeLeaf( const int leafId )
+{
+	if ( leafId == m_root )
+	{
+		m_root = NULL_NODE;
+		return;
+	}
+
+	// Sibling takes place of parent
+	int parentId = m_nodes[leafId].parent;
+	int grandParentId = m_nodes[parentId].parent;
+	int siblingId = ( m_nodes[parentId].children[0] == leafId ) ? m_nodes[parentId].children[1] : m_nodes[parentId].children[0];
+
+	if ( grandParentId != NULL_NODE )
+	{
+		Node& grandParent = m_nodes[grandParentId];
+		grandParent.children[( grandParent.children[0] == parentId ) ? 0 : 1] = siblingId;
+		m_nodes[siblingId].parent = grandParentId;
+		freeNode( parentId );
+
+		refitUpwards( grandParentId );
+	}
+	else
+	{
+		m_root = siblingId;
+		m_nodes[siblingId].parent = NULL_NODE;
+		freeNode( parentId );
+	}
+}
+
+void physicsAabbTree::refitUpwards( int nodeId )
+{
+	while ( nodeId != NULL_NODE )
+	{
+		nodeId = balance( nodeId );
+
+		Node& node = m_nodes[nodeId];
+		const Node& child0 = m_nodes[node.children[0]];
+		const Node& child1 = m_nodes[node.children[1]];
+
+		node.height = 1 + std::max( child0.height, child1.height );
+		node.aabb = child0.aabb;
+		node.aabb.includeAabb( child1.aabb );
+
+		nodeId = node.parent;
+	}
+}
+
+int physicsAabbTree::balance( const int nodeId )
+{
+	// A is nodeId, B and C are its children, C is rotated up to replace A if it is taller by 2 or more
+	Node& a = m_nodes[nodeId];
+
+	if ( a.isLeaf() || a.height < 2 )
+	{
+		return nodeId;
+	}
+
+	int bId = a.children[0];
+	int cId = a.children[1];
+	int heightDiff = m_nodes[cId].height - m_nodes[bId].height;
+
+	if ( heightDiff >= -1 && heightDiff <= 1 )
+	{
+		return nodeId;
+	}
+
+	// Let C be the taller child
+	int tallSlot = ( heightDiff > 1 ) ? 1 : 0;
+	if ( tallSlot == 0 )
+	{
+		std::swap( bId, cId );
+	}
+
+	Node& b = m_nodes[bId];
+	Node& c = m_nodes[cId];
+
+	int fId = c.children[0];
+	int gId = c.children[1];
+	Node& f = m_nodes[fId];
+	Node& g = m_nodes[gId];
+
+	// C takes place of A
+	c.children[0] = nodeId;
+	c.parent = a.parent;
+	a.parent = cId;
+
+	if ( c.parent != NULL_NODE )
+	{
+		Node& cParent = m_nodes[c.parent];
+		cParent.children[( cParent.children[0] == nodeId ) ? 0 : 1] = cId;
+	}
+	else
+	{
+		m_root = cId;
+	}
+
+	// Taller of C's children stays under C, shorter one goes under A in C's old slot
+	int keepId = fId;
+	int moveId = gId;
+	if ( f.height < g.height )
+	{
+		std::swap( keepId, moveId );
+	}
+
+	Node& keep = m_nodes[keepId];
+	Node& move = m_nodes[moveId];
+
+	c.children[1] = keepId;
+	a.children[tallSlot] = moveId;
+	move.parent = nodeId;
+
+	a.aabb = b.aabb;
+	a.aabb.includeAabb( move.aabb );
+	a.height = 1 + std::max( b.height, move.height );
+
+	c.aabb = a.aabb;
+	c.aabb.includeAabb( keep.aabb );
+	c.height = 1 + std::max( a.height, keep.height );
+
+	return cId;
+}
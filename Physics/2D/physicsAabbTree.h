@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#include <physicsTypes.h>
+#include <physicsAabb.h>
+
+// Dynamic bounding volume tree
+// Leaves hold fat aabb's enlarged by a margin, a leaf is only re-inserted once the aabb escapes its fat aabb.
+// Kept balanced with AVL-like rotations on the way back up after insertion and removal.
+// Queries test nodes one at a time, two children per node don't fill the 4 and 8 wide kernels of physicsAabbSoa
+class physicsAabbTree
+{
+public:
+
+	enum
+	{
+		NULL_NODE = -1,
+		MAX_QUERY_STACK = 256 // Plenty for a balanced tree of 65536 bodies, deeper queries grow a heap stack
+	};
+
+	physicsAabbTree( const Real margin );
+
+	~physicsAabbTree();
+
+	// Returns proxy Id of the created leaf
+	int createProxy( const physicsAabb& aabb, const BodyId bodyId );
+
+	void destroyProxy( const int proxyId );
+
+	// Returns true if leaf was re-inserted, false if aabb is still within fat aabb
+	bool moveProxy( const int proxyId, const physicsAabb& aabb );
+
+	const physicsAabb& getFatAabb( const int proxyId ) const { return m_nodes[proxyId].aabb; }
+
+	BodyId getBodyId( const int proxyId ) const { return m_nodes[proxyId].bodyId; }
+
+	// Appends body Ids of leaves whose fat aabb overlaps aabb
+	void query( const physicsAabb& aabb, std::vector<BodyId>& bodyIdsOut ) const;
+
+	// Height of root, 0 for a single leaf and -1 for empty tree
+	int getHeight() const;
+
+	Real getMargin() const { return m_margin; }
+
+protected:
+
+	struct Node
+	{
+		physicsAabb aabb;
+
+		union
+		{
+			int parent;
+			int nextFree;
+		};
+
+		int children[2];
+		int height; // Leaf at 0, -1 if free
+		BodyId bodyId;
+
+		bool isLeaf() const { return children[0] == NULL_NODE; }
+	};
+
+	int allocateNode();
+
+	void freeNode( const int nodeId );
+
+	void insertLeaf( const int leafId );
+
+	void removeLeaf( const int leafId );
+
+	// Refits and rebalances nodes from nodeId up to root
+	void refitUpwards( int nodeId );
+
+	// Rotates nodeId with its taller child if unbalanced, returns new root of the subtree
+	int balance( const int nodeId );
+
+	Real m_margin;
+
+	std::vector<Node> m_nodes;
+	int m_root;
+	int m_firstFree;
+};
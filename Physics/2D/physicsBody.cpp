@@ -5,9 +5,8 @@
 #include <physicsObject.h>
 #include <physicsSolver.h>
 
-#include <Renderer.h>
-
 #include <sstream>
+#include <immintrin.h>
 
 physicsBodyCinfo::physicsBodyCinfo()
 {
@@ -21,7 +20,10 @@ physicsBodyCinfo::physicsBodyCinfo()
 	m_angularSpeed = 0.f;
 	m_mass = -1.f;
 	m_inertia = -1.f;
+	m_friction = .5f;
 	m_collidable = true;
+	m_collisionCategory = 1;
+	m_collisionMask = 0xffffffff;
 }
 
 physicsBodyCinfo::~physicsBodyCinfo()
@@ -33,13 +35,21 @@ physicsBody::physicsBody( const physicsBodyCinfo& bodyCinfo ) :
 	m_name( bodyCinfo.m_name ),
 	m_bodyId( invalidId ),
 	m_shape( bodyCinfo.m_shape ),
+	m_shapeType( bodyCinfo.m_shape->getType() ),
 	m_motionType( bodyCinfo.m_motionType ),
 	m_pos( bodyCinfo.m_pos ),
 	m_ori( bodyCinfo.m_ori ),
 	m_linearVelocity( bodyCinfo.m_linearVelocity ),
 	m_angularSpeed( bodyCinfo.m_angularSpeed ),
 	m_mass( bodyCinfo.m_mass ),
-	m_inertia( bodyCinfo.m_inertia )
+	m_inertia( bodyCinfo.m_inertia ),
+	m_friction( bodyCinfo.m_friction ),
+	m_awakeListIdx( 0 ),
+	m_isSleeping( false ),
+	m_sleepTime( 0.f ),
+	m_sleepPos( bodyCinfo.m_pos ),
+	m_sleepOri( bodyCinfo.m_ori ),
+	m_nextInIsland( invalidId )
 {
 
 	if ( bodyCinfo.m_motionType == physicsMotionType::DYNAMIC )
@@ -70,7 +80,24 @@ physicsBody::physicsBody( const physicsBodyCinfo& bodyCinfo ) :
 		Assert( false, "Trying to construct invalid body type." );
 	}
 
-	m_collisionFilter = ( bodyCinfo.m_collidable ) ? 0 : 1;
+	m_collidable = bodyCinfo.m_collidable;
+	setCollisionFilter( bodyCinfo.m_collisionCategory, bodyCinfo.m_collisionMask );
+
+	std::vector<Vector4> hull;
+	m_shape->getHullVertices( hull );
+	m_numHullVertices = ( int )hull.size();
+
+	int stride = ( m_numHullVertices + 3 ) & ~3;
+	m_localHull.resize( 2 * stride );
+
+	for ( int i = 0; i < stride; i++ )
+	{
+		const Vector4& vertex = hull[std::min( i, m_numHullVertices - 1 )];
+		m_localHull[i] = vertex( 0 );
+		m_localHull[stride + i] = vertex( 1 );
+	}
+
+	updatePose();
 }
 
 physicsBody::~physicsBody()
@@ -82,21 +109,73 @@ bool physicsBody::containsPoint( const Vector4& point ) const
 {
 	// Convert point: world->local
 	Vector4 local;
-	local.setSub( point, m_pos );
-	local.setRotatedDir( local, -m_ori );
+	getLocalPoint( point, local );
 
 	return m_shape->containsPoint( local );
 }
 
-//#define PREDICTIVE_C
+void physicsBody::updatePose()
+{
+	m_cosOri = cos( m_ori );
+	m_sinOri = sin( m_ori );
+
+	if ( m_numHullVertices == 0 )
+	{
+		m_rotatedBounds = m_shape->getAabb( m_ori );
+		return;
+	}
+
+	int stride = ( int )m_localHull.size() / 2;
+	const Real* localX = &m_localHull[0];
+	const Real* localY = localX + stride;
+
+	// Hulls are a few vertices, 4 wide is enough. Padding repeats the last vertex so it can't widen bounds.
+	// Rotated vertices are only needed for bounds, nothing reads the hull in world space every step
+	__m128 cosRot = _mm_set1_ps( m_cosOri );
+	__m128 sinRot = _mm_set1_ps( m_sinOri );
+	__m128 minX = _mm_set1_ps( std::numeric_limits<Real>::max() );
+	__m128 minY = minX;
+	__m128 maxX = _mm_set1_ps( std::numeric_limits<Real>::lowest() );
+	__m128 maxY = maxX;
+
+	for ( int i = 0; i < stride; i += 4 )
+	{
+		__m128 x = _mm_loadu_ps( localX + i );
+		__m128 y = _mm_loadu_ps( localY + i );
+		__m128 rotatedX = _mm_sub_ps( _mm_mul_ps( cosRot, x ), _mm_mul_ps( sinRot, y ) );
+		__m128 rotatedY = _mm_add_ps( _mm_mul_ps( sinRot, x ), _mm_mul_ps( cosRot, y ) );
+
+		minX = _mm_min_ps( minX, rotatedX );
+		minY = _mm_min_ps( minY, rotatedY );
+		maxX = _mm_max_ps( maxX, rotatedX );
+		maxY = _mm_max_ps( maxY, rotatedY );
+	}
+
+	Real minXs[4], minYs[4], maxXs[4], maxYs[4];
+	_mm_storeu_ps( minXs, minX );
+	_mm_storeu_ps( minYs, minY );
+	_mm_storeu_ps( maxXs, maxX );
+	_mm_storeu_ps( maxYs, maxY );
+
+	m_rotatedBounds = physicsAabb(
+		Vector4( std::max( std::max( maxXs[0], maxXs[1] ), std::max( maxXs[2], maxXs[3] ) ),
+				 std::max( std::max( maxYs[0], maxYs[1] ), std::max( maxYs[2], maxYs[3] ) ) ),
+		Vector4( std::min( std::min( minXs[0], minXs[1] ), std::min( minXs[2], minXs[3] ) ),
+				 std::min( std::min( minYs[0], minYs[1] ), std::min( minYs[2], minYs[3] ) ) ) );
+}
+
 void physicsBody::updateAabb()
 {
-	m_aabb = m_shape->getAabb( m_ori );
-#if defined PREDICTIVE_C
-	m_aabb.expand( m_linearVelocity );
-#else
+	m_aabb = m_rotatedBounds;
 	m_aabb.expand( 0.5f );
-#endif
+	m_aabb.translate( m_pos );
+}
+
+void physicsBody::updatePredictiveAabb( const Real deltaTime, const Real margin )
+{
+	m_aabb = m_rotatedBounds;
+	m_aabb.expand( m_linearVelocity * deltaTime );
+	m_aabb.enlarge( margin );
 	m_aabb.translate( m_pos );
 }
 
@@ -115,11 +194,6 @@ void physicsBody::setDampedVelocity( const Real& damping )
 	setAngularSpeed( getAngularSpeed() * damping );
 }
 
-physicsShape::Type physicsBody::getShapeType() const
-{
-	return m_shape->getType();
-}
-
 void physicsBody::setFromSolverBody( const SolverBody& body )
 {
 	setLinearVelocity( body.v );
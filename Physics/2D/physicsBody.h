@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <physicsObject.h>
 #include <physicsTypes.h>
@@ -34,7 +35,9 @@ public:
 	Real m_inertia;
 	Vector4 m_com;
 	Real m_friction;
-	bool m_collidable;
+	bool m_collidable; // Non-collidable bodies collide with nothing regardless of mask
+	unsigned int m_collisionCategory; // Groups body belongs to, one bit each
+	unsigned int m_collisionMask; // Groups body collides with
 };
 
 struct FreeBody
@@ -63,24 +66,53 @@ public:
 	physicsMotionType getMotionType() const { return m_motionType; }
 	inline bool isStatic() const;
 
+	// Sleeping bodies aren't moved, solved or collided with each other until something wakes their island
+	bool isSleeping() const { return m_isSleeping; }
+
 	// Read-only access to transforms and motion
 	const Vector4& getPosition() const { return m_pos; }
 	const Real getRotation() const { return  m_ori; }
 	const Vector4& getLinearVelocity() const { return m_linearVelocity; }
 	const Real getAngularSpeed() const { return m_angularSpeed; }
 
+	// Cached when world moves body, once per step after integration
+	const Real getCosRotation() const { return m_cosOri; }
+	const Real getSinRotation() const { return m_sinOri; }
+
+	// Built from cached cos and sin
+	inline void getTransform( Transform& transform ) const;
+
+	// World direction and point into body space
+	inline void getLocalDir( const Vector4& dir, Vector4& localOut ) const;
+	inline void getLocalPoint( const Vector4& point, Vector4& localOut ) const;
+
+	// Body space direction into world space
+	inline void getWorldDir( const Vector4& localDir, Vector4& dirOut ) const;
+
+	// Polygon's hull in world space, in shape's hull order, transformed on each call. Circles have none
+	int getNumWorldVertices() const { return m_numHullVertices; }
+	inline Vector4 getWorldVertex( const int idx ) const;
+
 	const Real getMass() const { return m_mass; }
 	const Real getInertia() const { return m_inertia; }
 	const Real getInvMass() const { return m_invMass; }
 	const Real getInvInertia() const { return m_invInertia; }
 
+	// Contacts combine both bodies' coefficients as sqrt( frictionA * frictionB )
+	const Real getFriction() const { return m_friction; }
+
 	bool containsPoint( const Vector4& point ) const;
 
+	// Bodies collide if each one's category is in the other's mask
+	unsigned int getCollisionCategory() const { return m_collisionCategory; }
+	unsigned int getCollisionMask() const { return m_collisionMask; }
+
 private:
 
 	std::string m_name;
 	BodyId m_bodyId;
 	std::shared_ptr<physicsShape> m_shape;
+	physicsShape::Type m_shapeType; // Cached so dispatch doesn't go through shape's vtable
 	physicsMotionType m_motionType;
 	Vector4 m_pos;
 	Real m_ori;
@@ -88,6 +120,7 @@ private:
 	Real m_angularSpeed; // in radians
 	Real m_mass;
 	Real m_inertia;
+	Real m_friction;
 
 private:
 
@@ -95,12 +128,20 @@ private:
 
 	inline void setBodyId( unsigned int bodyId );
 
-	physicsShape::Type getShapeType() const;
+	inline physicsShape::Type getShapeType() const;
 
 	// Internal usage - aabb
 	inline physicsAabb getAabb() const;
+
+	// Recomputes cached cos and sin and rotated bounds from rotation
+	void updatePose();
+
+	// Scales shape's aabb up by half
 	void updateAabb();
 
+	// Sweeps shape's aabb along linear velocity over deltaTime, then grows it by margin on all sides
+	void updatePredictiveAabb( const Real deltaTime, const Real margin );
+
 	// Internal usage - motion type
 	inline void setMotionType( physicsMotionType type );
 
@@ -120,9 +161,20 @@ private:
 	// Internal usage - indices
 	inline void setActiveListIdx( unsigned int idx );
 	inline unsigned int getActiveListIdx() const;
+	inline void setAwakeListIdx( unsigned int idx );
+	inline unsigned int getAwakeListIdx() const;
+
+	// Internal usage - sleeping, going to sleep zeroes velocities and waking up restarts sleep timer.
+	// Timer runs while body stays within tolerances of pose it had when timer was restarted and moves slower than given speeds
+	inline void setSleeping( const bool sleeping );
+	inline void updateSleepTime( const Real deltaTime, const Real linearTolerance, const Real angularTolerance, const Real linearSpeed, const Real angularSpeed );
+	Real getSleepTime() const { return m_sleepTime; }
+	inline void resetSleepTime();
+	BodyId getNextInIsland() const { return m_nextInIsland; }
+	void setNextInIsland( const BodyId bodyId ) { m_nextInIsland = bodyId; }
 
-	// Internal usage - collision filter
-	inline unsigned int getCollisionFilter() const;
+	// Internal usage - collision filter, non-collidable bodies keep an empty mask
+	inline void setCollisionFilter( const unsigned int category, const unsigned int mask );
 
 	// Used by world to update body from solver bodies
 	void setFromSolverBody( const struct SolverBody& body );
@@ -130,10 +182,23 @@ private:
 private:
 
 	physicsAabb m_aabb;
+	Real m_cosOri;
+	Real m_sinOri;
+	physicsAabb m_rotatedBounds; // Shape's bounds at current rotation, around body's origin
+	int m_numHullVertices;
+	std::vector<Real> m_localHull; // All x of hull then all y, each padded to a multiple of 4 by repeating last vertex
 	Real m_invMass;
 	Real m_invInertia;
 	unsigned int m_activeListIdx; // Index of this body in physicsWorld::m_activeBodyIds
-	unsigned int m_collisionFilter;
+	unsigned int m_awakeListIdx; // Index of this body in physicsWorld::m_awakeBodyIds while awake and dynamic
+	bool m_isSleeping;
+	Real m_sleepTime; // How long body has stayed near m_sleepPos and m_sleepOri
+	Vector4 m_sleepPos;
+	Real m_sleepOri;
+	BodyId m_nextInIsland; // Members of a sleeping island are linked in a ring
+	bool m_collidable; // Keeps mask empty whatever filter is set
+	unsigned int m_collisionCategory;
+	unsigned int m_collisionMask;
 
 	friend class physicsWorld;
 	friend class physicsWorldEx;
@@ -14,6 +14,39 @@ inline void physicsBody::setMotionType(physicsMotionType type)
 	}
 }
 
+inline void physicsBody::getTransform( Transform& transform ) const
+{
+	transform.setTransform( m_pos, m_ori, m_cosOri, m_sinOri );
+}
+
+inline void physicsBody::getLocalDir( const Vector4& dir, Vector4& localOut ) const
+{
+	localOut.set( m_cosOri * dir( 0 ) + m_sinOri * dir( 1 ), m_cosOri * dir( 1 ) - m_sinOri * dir( 0 ) );
+}
+
+inline void physicsBody::getLocalPoint( const Vector4& point, Vector4& localOut ) const
+{
+	getLocalDir( point - m_pos, localOut );
+}
+
+inline void physicsBody::getWorldDir( const Vector4& localDir, Vector4& dirOut ) const
+{
+	dirOut.set( m_cosOri * localDir( 0 ) - m_sinOri * localDir( 1 ), m_sinOri * localDir( 0 ) + m_cosOri * localDir( 1 ) );
+}
+
+inline Vector4 physicsBody::getWorldVertex( const int idx ) const
+{
+	Assert( idx >= 0 && idx < m_numHullVertices, "world vertex out of range" );
+	Real x = m_localHull[idx];
+	Real y = m_localHull[m_localHull.size() / 2 + idx];
+	return Vector4( m_pos( 0 ) + m_cosOri * x - m_sinOri * y, m_pos( 1 ) + m_sinOri * x + m_cosOri * y );
+}
+
+inline physicsShape::Type physicsBody::getShapeType() const
+{
+	return m_shapeType;
+}
+
 inline bool physicsBody::isStatic() const
 {
 	return (m_motionType == physicsMotionType::STATIC);
@@ -61,9 +94,47 @@ inline void physicsBody::setBodyId(unsigned int bodyId)
 	m_bodyId = bodyId;
 }
 
-inline unsigned int physicsBody::getCollisionFilter() const
+inline void physicsBody::setSleeping( const bool sleeping )
 {
-	return m_collisionFilter;
+	m_isSleeping = sleeping;
+	resetSleepTime();
+
+	if ( sleeping )
+	{
+		m_linearVelocity.setZero();
+		m_angularSpeed = 0.f;
+	}
+}
+
+inline void physicsBody::updateSleepTime( const Real deltaTime, const Real linearTolerance, const Real angularTolerance, const Real linearSpeed, const Real angularSpeed )
+{
+	// Drift catches slow creep. Resting stacks jitter back and forth faster than they move away, so speeds only
+	// catch bodies passing quickly through where they started, like a swinging pendulum
+	Vector4 drift = m_pos - m_sleepPos;
+	bool isDrifting = ( drift.lengthSquared<2>() > linearTolerance * linearTolerance || fabs( m_ori - m_sleepOri ) > angularTolerance );
+	bool isFast = ( m_linearVelocity.lengthSquared<2>() > linearSpeed * linearSpeed || fabs( m_angularSpeed ) > angularSpeed );
+
+	if ( isDrifting || isFast )
+	{
+		resetSleepTime();
+	}
+	else
+	{
+		m_sleepTime += deltaTime;
+	}
+}
+
+inline void physicsBody::resetSleepTime()
+{
+	m_sleepTime = 0.f;
+	m_sleepPos = m_pos;
+	m_sleepOri = m_ori;
+}
+
+inline void physicsBody::setCollisionFilter( const unsigned int category, const unsigned int mask )
+{
+	m_collisionCategory = category;
+	m_collisionMask = ( m_collidable ) ? mask : 0;
 }
 
 inline void physicsBody::setActiveListIdx( unsigned int idx )
@@ -74,4 +145,14 @@ inline void physicsBody::setActiveListIdx( unsigned int idx )
 inline unsigned int physicsBody::getActiveListIdx() const
 {
 	return m_activeListIdx;
+}
+
+inline void physicsBody::setAwakeListIdx( unsigned int idx )
+{
+	m_awakeListIdx = idx;
+}
+
+inline unsigned int physicsBody::getAwakeListIdx() const
+{
+	return m_awakeListIdx;
 }
\ No newline at end of file
@@ -0,0 +1,1128 @@
+#include <algorithm>
+#include <cstring>
+
+#include <physicsBroadphase.h>
+
+// Base broadphase class functions
+physicsBroadphase::physicsBroadphase() :
+	m_threadPool( nullptr ),
+	m_staticTree( 0.f ),
+	m_updateStamp( 0 )
+{
+
+}
+
+physicsBroadphase::~physicsBroadphase()
+{
+
+}
+
+int physicsBroadphase::getNumThreads() const
+{
+	return m_threadPool ? m_threadPool->getNumThreads() : 1;
+}
+
+bool physicsBroadphase::isUsed( const BodyId bodyId ) const
+{
+	return ( bodyId < m_bodyInfos.size() && m_bodyInfos[bodyId].isUsed );
+}
+
+void physicsBroadphase::addBody( const BroadphaseBody& body )
+{
+	Assert( !isUsed( body.bodyId ), "body added to broadphase twice" );
+
+	if ( body.bodyId >= m_bodyInfos.size() )
+	{
+		BodyInfo unused = { false, false, physicsAabbTree::NULL_NODE };
+		m_bodyInfos.resize( body.bodyId + 1, unused );
+		m_bounds.resize( body.bodyId + 1 );
+		m_categories.resize( body.bodyId + 1, 0 );
+		m_masks.resize( body.bodyId + 1, 0 );
+	}
+
+	BodyInfo& info = m_bodyInfos[body.bodyId];
+	info.isStatic = body.isStatic;
+	info.isUsed = true;
+
+	m_bounds.set( body.bodyId, body.aabb );
+	m_categories[body.bodyId] = body.category;
+	m_masks[body.bodyId] = body.mask;
+
+	if ( body.isStatic )
+	{
+		info.staticProxyId = m_staticTree.createProxy( body.aabb, body.bodyId );
+	}
+	else
+	{
+		addDynamicBody( body.bodyId );
+	}
+}
+
+void physicsBroadphase::removeBody( const BodyId bodyId )
+{
+	Assert( isUsed( bodyId ), "removing body which isn't in broadphase" );
+
+	removePairsOfBody( bodyId );
+
+	BodyInfo& info = m_bodyInfos[bodyId];
+
+	if ( info.isStatic )
+	{
+		m_staticTree.destroyProxy( info.staticProxyId );
+		info.staticProxyId = physicsAabbTree::NULL_NODE;
+	}
+	else
+	{
+		removeDynamicBody( bodyId );
+	}
+
+	info.isUsed = false;
+	m_bounds.setEmpty( bodyId );
+	m_categories[bodyId] = 0;
+	m_masks[bodyId] = 0;
+}
+
+void physicsBroadphase::updateBody( const BodyId bodyId, const physicsAabb& aabb )
+{
+	Assert( isUsed( bodyId ), "updating body which isn't in broadphase" );
+
+	m_bounds.set( bodyId, aabb );
+
+	if ( m_bodyInfos[bodyId].isStatic )
+	{
+		m_staticTree.moveProxy( m_bodyInfos[bodyId].staticProxyId, aabb );
+	}
+	else
+	{
+		updateDynamicBody( bodyId );
+	}
+}
+
+void physicsBroadphase::updatePairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut )
+{
+	addedPairsOut.clear();
+	removedPairsOut.clear();
+	BodyIdPairsUtils::movePairsBtoA( removedPairsOut, m_removedPairs );
+
+	m_updateStamp++;
+
+	updateDynamicPairs( addedPairsOut, removedPairsOut );
+	updateStaticPairs( addedPairsOut, removedPairsOut );
+}
+
+void physicsBroadphase::updateStaticPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut )
+{
+	int numThreads = getNumThreads();
+	m_staticThreadPairs.resize( numThreads );
+
+	auto findPairs = [&]( const int threadIdx )
+	{
+		int start, end;
+		physicsThreadPool::getRange( ( int )m_bodyInfos.size(), threadIdx, numThreads, start, end );
+
+		std::vector<BodyIdPair>& pairs = m_staticThreadPairs[threadIdx];
+		pairs.clear();
+
+		std::vector<BodyId> hits;
+
+		for ( int i = start; i < end; i++ )
+		{
+			if ( !m_bodyInfos[i].isUsed || m_bodyInfos[i].isStatic )
+			{
+				continue;
+			}
+
+			physicsAabb aabb;
+			m_bounds.get( i, aabb );
+
+			hits.clear();
+			m_staticTree.query( aabb, hits );
+
+			for ( auto hit = hits.begin(); hit != hits.end(); hit++ )
+			{
+				if ( checkCollidable( ( BodyId )i, *hit ) )
+				{
+					pairs.push_back( BodyIdPair( ( BodyId )i, *hit ) );
+				}
+			}
+		}
+	};
+
+	if ( numThreads > 1 )
+	{
+		m_threadPool->run( findPairs );
+	}
+	else
+	{
+		findPairs( 0 );
+	}
+
+	std::vector<BodyIdPair> pairs;
+
+	for ( auto iter = m_staticThreadPairs.begin(); iter != m_staticThreadPairs.end(); iter++ )
+	{
+		pairs.insert( pairs.end(), iter->begin(), iter->end() );
+	}
+
+	setPairs( m_staticPairs, pairs, addedPairsOut, removedPairsOut );
+}
+
+void physicsBroadphase::getPairs( std::vector<BodyIdPair>& pairsOut ) const
+{
+	pairsOut.clear();
+
+	const PairSet* pairSets[] = { &m_pairs, &m_staticPairs };
+
+	for ( int i = 0; i < 2; i++ )
+	{
+		for ( int slotIdx = 0; slotIdx < pairSets[i]->getNumSlots(); slotIdx++ )
+		{
+			if ( pairSets[i]->isSlotUsed( slotIdx ) )
+			{
+				pairsOut.push_back( pairSets[i]->getSlotPair( slotIdx ) );
+			}
+		}
+	}
+
+	std::sort( pairsOut.begin(), pairsOut.end(), bodyIdPairLess );
+}
+
+void physicsBroadphase::queryAabb( const physicsAabb& aabb, std::vector<BodyId>& bodyIdsOut ) const
+{
+	// Unused bodies are empty and never hit
+	std::vector<int> hits;
+	m_bounds.query( aabb, hits );
+
+	for ( auto iter = hits.begin(); iter != hits.end(); iter++ )
+	{
+		bodyIdsOut.push_back( static_cast< BodyId >( *iter ) );
+	}
+}
+
+void physicsBroadphase::getBroadphaseBodies( std::vector<BroadphaseBody>& bodiesOut ) const
+{
+	bodiesOut.clear();
+
+	for ( int i = 0; i < ( int )m_bodyInfos.size(); i++ )
+	{
+		if ( !m_bodyInfos[i].isUsed )
+		{
+			continue;
+		}
+
+		BroadphaseBody body( static_cast< BodyId >( i ) );
+		m_bounds.get( i, body.aabb );
+		body.category = m_categories[i];
+		body.mask = m_masks[i];
+		body.isStatic = m_bodyInfos[i].isStatic;
+		bodiesOut.push_back( body );
+	}
+}
+
+void physicsBroadphase::removePairsOfBody( const BodyId bodyId )
+{
+	PairSet* pairSets[] = { &m_pairs, &m_staticPairs };
+
+	for ( int i = 0; i < 2; i++ )
+	{
+		PairSet& pairs = *pairSets[i];
+		size_t numRemoved = m_removedPairs.size();
+
+		for ( int slotIdx = 0; slotIdx < pairs.getNumSlots(); slotIdx++ )
+		{
+			if ( !pairs.isSlotUsed( slotIdx ) )
+			{
+				continue;
+			}
+
+			BodyIdPair pair = pairs.getSlotPair( slotIdx );
+
+			if ( pair.bodyIdA == bodyId || pair.bodyIdB == bodyId )
+			{
+				m_removedPairs.push_back( pair );
+			}
+		}
+
+		// Removal shifts entries, so it can't be done while walking slots
+		for ( size_t j = numRemoved; j < m_removedPairs.size(); j++ )
+		{
+			pairs.remove( m_removedPairs[j] );
+		}
+	}
+}
+
+void physicsBroadphase::setPairs( PairSet& pairs,
+								  const std::vector<BodyIdPair>& currentPairs,
+								  std::vector<BodyIdPair>& addedPairsOut,
+								  std::vector<BodyIdPair>& removedPairsOut )
+{
+	for ( auto iter = currentPairs.begin(); iter != currentPairs.end(); iter++ )
+	{
+		bool inserted;
+		unsigned int& stamp = pairs.insert( *iter, m_updateStamp, &inserted );
+
+		if ( inserted )
+		{
+			addedPairsOut.push_back( *iter );
+		}
+
+		stamp = m_updateStamp;
+	}
+
+	// Pairs which weren't found this update are lost
+	size_t numRemoved = removedPairsOut.size();
+
+	for ( int slotIdx = 0; slotIdx < pairs.getNumSlots(); slotIdx++ )
+	{
+		if ( pairs.isSlotUsed( slotIdx ) && pairs.getSlotValue( slotIdx ) != m_updateStamp )
+		{
+			removedPairsOut.push_back( pairs.getSlotPair( slotIdx ) );
+		}
+	}
+
+	for ( size_t i = numRemoved; i < removedPairsOut.size(); i++ )
+	{
+		pairs.remove( removedPairsOut[i] );
+	}
+}
+
+void physicsBroadphase::applyPairEvents( std::vector<PairEvent>& events,
+										 std::vector<BodyIdPair>& addedPairsOut,
+										 std::vector<BodyIdPair>& removedPairsOut )
+{
+	if ( events.empty() )
+	{
+		return;
+	}
+
+	for ( auto iter = events.begin(); iter != events.end(); iter++ )
+	{
+		bool exists = ( m_pairs.find( iter->pair ) != nullptr );
+
+		if ( iter->isAdded == exists )
+		{
+			continue;
+		}
+
+		// Only first change of a pair records whether it existed before this update
+		m_changedPairs.insert( iter->pair, exists );
+
+		if ( iter->isAdded )
+		{
+			m_pairs.insert( iter->pair, m_updateStamp );
+		}
+		else
+		{
+			m_pairs.remove( iter->pair );
+		}
+	}
+
+	events.clear();
+
+	// Added then removed, or removed then added, cancel out
+	for ( int slotIdx = 0; slotIdx < m_changedPairs.getNumSlots(); slotIdx++ )
+	{
+		if ( !m_changedPairs.isSlotUsed( slotIdx ) )
+		{
+			continue;
+		}
+
+		BodyIdPair pair = m_changedPairs.getSlotPair( slotIdx );
+		bool existed = m_changedPairs.getSlotValue( slotIdx );
+		bool exists = ( m_pairs.find( pair ) != nullptr );
+
+		if ( exists && !existed )
+		{
+			addedPairsOut.push_back( pair );
+		}
+		else if ( !exists && existed )
+		{
+			removedPairsOut.push_back( pair );
+		}
+	}
+
+	m_changedPairs.clear();
+}
+
+// Sweep and prune class functions
+physicsSweepAndPrune::physicsSweepAndPrune() :
+	m_sweepAxis( 0 ),
+	m_needsRebuild( false )
+{
+
+}
+
+physicsSweepAndPrune::~physicsSweepAndPrune()
+{
+
+}
+
+void physicsSweepAndPrune::addDynamicBody( const BodyId bodyId )
+{
+	if ( bodyId >= m_proxies.size() )
+	{
+		m_proxies.resize( bodyId + 1 );
+	}
+
+	// Bodies are often added in bulk, sort everything once on next update
+	m_needsRebuild = true;
+}
+
+void physicsSweepAndPrune::removeDynamicBody( const BodyId bodyId )
+{
+	if ( !m_needsRebuild )
+	{
+		// Close the gaps left by endpoints of removed body
+		for ( int axis = 0; axis < NUM_AXES; axis++ )
+		{
+			std::vector<Endpoint>& endpoints = m_endpoints[axis];
+			int numEndpoints = 0;
+
+			for ( int i = 0; i < ( int )endpoints.size(); i++ )
+			{
+				const Endpoint& endpoint = endpoints[i];
+
+				if ( endpoint.getBodyId() == bodyId )
+				{
+					continue;
+				}
+
+				Proxy& proxy = m_proxies[endpoint.getBodyId()];
+				( endpoint.isMax() ? proxy.max[axis] : proxy.min[axis] ) = numEndpoints;
+				endpoints[numEndpoints] = endpoint;
+				numEndpoints++;
+			}
+
+			endpoints.resize( numEndpoints );
+		}
+	}
+}
+
+void physicsSweepAndPrune::updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut )
+{
+	if ( m_needsRebuild )
+	{
+		rebuild( addedPairsOut, removedPairsOut );
+		m_needsRebuild = false;
+	}
+	else
+	{
+		int numThreads = getNumThreads();
+		m_threadPairs.resize( numThreads );
+
+		for ( auto iter = m_threadPairs.begin(); iter != m_threadPairs.end(); iter++ )
+		{
+			iter->clear();
+		}
+
+		for ( int axis = 0; axis < NUM_AXES; axis++ )
+		{
+			sortAxis( axis, numThreads );
+		}
+
+		// Only pairs whose endpoints swapped can change, their state comes from final endpoint order on both axes,
+		// so it doesn't matter which thread found a swap or in which order
+		for ( auto iter = m_threadPairs.begin(); iter != m_threadPairs.end(); iter++ )
+		{
+			for ( auto pair = iter->begin(); pair != iter->end(); pair++ )
+			{
+				const Proxy& proxyA = m_proxies[pair->bodyIdA];
+				const Proxy& proxyB = m_proxies[pair->bodyIdB];
+
+				PairEvent pairEvent;
+				pairEvent.pair = *pair;
+				pairEvent.isAdded = overlapsOnAxis( proxyA, proxyB, 0 ) && overlapsOnAxis( proxyA, proxyB, 1 );
+				m_events.push_back( pairEvent );
+			}
+		}
+
+		applyPairEvents( m_events, addedPairsOut, removedPairsOut );
+	}
+}
+
+Real physicsSweepAndPrune::getEndpointValue( const Endpoint& endpoint, const int axis ) const
+{
+	BodyId bodyId = endpoint.getBodyId();
+
+	if ( axis == 0 )
+	{
+		return endpoint.isMax() ? m_bounds.getMaxX()[bodyId] : m_bounds.getMinX()[bodyId];
+	}
+
+	return endpoint.isMax() ? m_bounds.getMaxY()[bodyId] : m_bounds.getMinY()[bodyId];
+}
+
+unsigned int physicsSweepAndPrune::getSortKey( const Real value )
+{
+	// Adding zero turns -0 into +0 so both get the same key
+	Real positiveZero = value + 0.f;
+	unsigned int bits;
+	memcpy( &bits, &positiveZero, sizeof( bits ) );
+
+	// Negative floats order reversed by their bits, flip all of them; positive ones only need sign bit set
+	return ( bits & 0x80000000 ) ? ~bits : ( bits | 0x80000000 );
+}
+
+void physicsSweepAndPrune::radixSort( std::vector<SortEntry>& entries, std::vector<SortEntry>& temp )
+{
+	int numEntries = ( int )entries.size();
+	temp.resize( numEntries );
+
+	for ( int shift = 0; shift < 32; shift += 8 )
+	{
+		int counts[256] = {};
+
+		for ( int i = 0; i < numEntries; i++ )
+		{
+			counts[( entries[i].key >> shift ) & 0xff]++;
+		}
+
+		// Skip pass if all keys share this digit
+		if ( numEntries == 0 || counts[( entries[0].key >> shift ) & 0xff] == numEntries )
+		{
+			continue;
+		}
+
+		int offset = 0;
+
+		for ( int digit = 0; digit < 256; digit++ )
+		{
+			int count = counts[digit];
+			counts[digit] = offset;
+			offset += count;
+		}
+
+		for ( int i = 0; i < numEntries; i++ )
+		{
+			temp[counts[( entries[i].key >> shift ) & 0xff]++] = entries[i];
+		}
+
+		entries.swap( temp );
+	}
+}
+
+int physicsSweepAndPrune::chooseSweepAxis() const
+{
+	Real sum[NUM_AXES] = {};
+	Real sumSquared[NUM_AXES] = {};
+	int numBodies = 0;
+
+	const Real* mins[NUM_AXES] = { m_bounds.getMinX(), m_bounds.getMinY() };
+	const Real* maxs[NUM_AXES] = { m_bounds.getMaxX(), m_bounds.getMaxY() };
+
+	for ( int i = 0; i < ( int )m_bodyInfos.size(); i++ )
+	{
+		if ( !m_bodyInfos[i].isUsed || m_bodyInfos[i].isStatic )
+		{
+			continue;
+		}
+
+		for ( int axis = 0; axis < NUM_AXES; axis++ )
+		{
+			Real center = 0.5f * ( mins[axis][i] + maxs[axis][i] );
+			sum[axis] += center;
+			sumSquared[axis] += center * center;
+		}
+
+		numBodies++;
+	}
+
+	if ( numBodies == 0 )
+	{
+		return 0;
+	}
+
+	// Variance times number of bodies, enough to compare axes
+	Real varianceX = sumSquared[0] - sum[0] * sum[0] / numBodies;
+	Real varianceY = sumSquared[1] - sum[1] * sum[1] / numBodies;
+
+	return ( varianceY > varianceX ) ? 1 : 0;
+}
+
+void physicsSweepAndPrune::rebuild( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut )
+{
+	for ( int axis = 0; axis < NUM_AXES; axis++ )
+	{
+		m_sortEntries.clear();
+
+		// All max endpoints go before min endpoints and sort is stable,
+		// so max endpoints stay first at equal values like in endpointLess
+		for ( int isMax = 1; isMax >= 0; isMax-- )
+		{
+			for ( int i = 0; i < ( int )m_bodyInfos.size(); i++ )
+			{
+				if ( !m_bodyInfos[i].isUsed || m_bodyInfos[i].isStatic )
+				{
+					continue;
+				}
+
+				Endpoint endpoint = { 0.f, ( unsigned int )i << 1 | isMax };
+				SortEntry entry = { getSortKey( getEndpointValue( endpoint, axis ) ), endpoint.data };
+				m_sortEntries.push_back( entry );
+			}
+		}
+
+		radixSort( m_sortEntries, m_sortTemp );
+
+		std::vector<Endpoint>& endpoints = m_endpoints[axis];
+		endpoints.resize( m_sortEntries.size() );
+
+		for ( int i = 0; i < ( int )endpoints.size(); i++ )
+		{
+			endpoints[i].data = m_sortEntries[i].data;
+			endpoints[i].value = getEndpointValue( endpoints[i], axis );
+
+			Proxy& proxy = m_proxies[endpoints[i].getBodyId()];
+			( endpoints[i].isMax() ? proxy.max[axis] : proxy.min[axis] ) = i;
+		}
+	}
+
+	m_sweepAxis = chooseSweepAxis();
+
+	// Bounds in order of min endpoints on sweep axis, bodies starting within a body's interval are then a contiguous run
+	const std::vector<Endpoint>& sweepEndpoints = m_endpoints[m_sweepAxis];
+	int numMins = 0;
+
+	m_minRanks.resize( sweepEndpoints.size() + 1 );
+
+	for ( int i = 0; i < ( int )sweepEndpoints.size(); i++ )
+	{
+		m_minRanks[i] = numMins;
+		numMins += sweepEndpoints[i].isMax() ? 0 : 1;
+	}
+
+	m_minRanks[sweepEndpoints.size()] = numMins;
+	m_sweepBounds.resize( numMins );
+	m_sweepBodyIds.resize( numMins );
+
+	for ( int i = 0; i < ( int )sweepEndpoints.size(); i++ )
+	{
+		if ( !sweepEndpoints[i].isMax() )
+		{
+			physicsAabb aabb;
+			m_bounds.get( sweepEndpoints[i].getBodyId(), aabb );
+			m_sweepBounds.set( m_minRanks[i], aabb );
+			m_sweepBodyIds[m_minRanks[i]] = sweepEndpoints[i].getBodyId();
+		}
+	}
+
+	// Sorted sweep axis is split into slabs, one per thread
+	int numThreads = getNumThreads();
+	m_threadPairs.resize( numThreads );
+
+	auto findPairs = [&]( const int threadIdx )
+	{
+		int start, end;
+		physicsThreadPool::getRange( ( int )m_endpoints[m_sweepAxis].size(), threadIdx, numThreads, start, end );
+
+		m_threadPairs[threadIdx].clear();
+		findPairsInSlab( start, end, m_threadPairs[threadIdx] );
+	};
+
+	if ( numThreads > 1 )
+	{
+		m_threadPool->run( findPairs );
+	}
+	else
+	{
+		findPairs( 0 );
+	}
+
+	std::vector<BodyIdPair> pairs;
+
+	for ( auto iter = m_threadPairs.begin(); iter != m_threadPairs.end(); iter++ )
+	{
+		pairs.insert( pairs.end(), iter->begin(), iter->end() );
+	}
+
+	m_events.clear();
+	setPairs( m_pairs, pairs, addedPairsOut, removedPairsOut );
+}
+
+void physicsSweepAndPrune::findPairsInSlab( const int start, const int end, std::vector<BodyIdPair>& pairsOut ) const
+{
+	const std::vector<Endpoint>& endpoints = m_endpoints[m_sweepAxis];
+	std::vector<int> hits;
+
+	for ( int i = start; i < end; i++ )
+	{
+		if ( endpoints[i].isMax() )
+		{
+			continue;
+		}
+
+		BodyId bodyId = endpoints[i].getBodyId();
+		const Proxy& proxy = m_proxies[bodyId];
+
+		// Bodies starting within interval overlap on sweep axis, may run past the slab.
+		// Both axes are tested with wide kernel, sorted values agree with endpoint order right after rebuild
+		physicsAabb aabb;
+		m_bounds.get( bodyId, aabb );
+
+		hits.clear();
+		m_sweepBounds.query( aabb, m_minRanks[i] + 1, m_minRanks[proxy.max[m_sweepAxis]], hits );
+
+		for ( auto hit = hits.begin(); hit != hits.end(); hit++ )
+		{
+			BodyId otherId = m_sweepBodyIds[*hit];
+
+			if ( checkCollidable( bodyId, otherId ) )
+			{
+				pairsOut.push_back( BodyIdPair( bodyId, otherId ) );
+			}
+		}
+	}
+}
+
+void physicsSweepAndPrune::sortAxis( const int axis, const int numThreads )
+{
+	std::vector<Endpoint>& endpoints = m_endpoints[axis];
+	int numEndpoints = ( int )endpoints.size();
+
+	// Each thread insertion sorts its own chunk. Proxies are shared by chunks holding both endpoints of a body,
+	// but a chunk only writes the index of its own endpoint
+	auto sortChunk = [&]( const int threadIdx )
+	{
+		int start, end;
+		physicsThreadPool::getRange( numEndpoints, threadIdx, numThreads, start, end );
+
+		// Pull in latest values
+		for ( int i = start; i < end; i++ )
+		{
+			endpoints[i].value = getEndpointValue( endpoints[i], axis );
+		}
+
+		for ( int i = start + 1; i < end; i++ )
+		{
+			for ( int j = i; j > start && endpointLess( endpoints[j], endpoints[j - 1] ); j-- )
+			{
+				swapDown( axis, j, m_threadPairs[threadIdx] );
+			}
+		}
+	};
+
+	if ( numThreads > 1 )
+	{
+		m_threadPool->run( sortChunk );
+	}
+	else
+	{
+		sortChunk( 0 );
+	}
+
+	// Endpoints crossing chunk boundaries are moved on this thread. Chunks are sorted, so only a prefix
+	// of each chunk moves, up to the first endpoint which isn't below everything before it
+	for ( int threadIdx = 1; threadIdx < numThreads; threadIdx++ )
+	{
+		int start, end;
+		physicsThreadPool::getRange( numEndpoints, threadIdx, numThreads, start, end );
+
+		for ( int i = start; i < end && i > 0 && endpointLess( endpoints[i], endpoints[i - 1] ); i++ )
+		{
+			for ( int j = i; j > 0 && endpointLess( endpoints[j], endpoints[j - 1] ); j-- )
+			{
+				swapDown( axis, j, m_threadPairs[0] );
+			}
+		}
+	}
+}
+
+void physicsSweepAndPrune::swapDown( const int axis, const int index, std::vector<BodyIdPair>& changedPairsOut )
+{
+	std::vector<Endpoint>& endpoints = m_endpoints[axis];
+	Endpoint& moving = endpoints[index];
+	Endpoint& passed = endpoints[index - 1];
+
+	BodyId movingId = moving.getBodyId();
+	BodyId passedId = passed.getBodyId();
+
+	// Min passing max starts or ends overlap on this axis, endpoints of a body with zero extent swap with each other
+	if ( moving.isMax() != passed.isMax() && movingId != passedId && checkCollidable( movingId, passedId ) )
+	{
+		changedPairsOut.push_back( BodyIdPair( movingId, passedId ) );
+	}
+
+	Proxy& proxyMoving = m_proxies[movingId];
+	Proxy& proxyPassed = m_proxies[passedId];
+
+	( moving.isMax() ? proxyMoving.max[axis] : proxyMoving.min[axis] ) = index - 1;
+	( passed.isMax() ? proxyPassed.max[axis] : proxyPassed.min[axis] ) = index;
+
+	std::swap( moving, passed );
+}
+
+bool physicsSweepAndPrune::endpointLess( const Endpoint& endpointA, const Endpoint& endpointB )
+{
+	return endpointA.value < endpointB.value ||
+		   ( endpointA.value == endpointB.value && endpointA.isMax() && !endpointB.isMax() );
+}
+
+bool physicsSweepAndPrune::overlapsOnAxis( const Proxy& proxyA, const Proxy& proxyB, const int axis ) const
+{
+	return ( proxyA.min[axis] < proxyB.max[axis] && proxyB.min[axis] < proxyA.max[axis] );
+}
+
+// Hash grid class functions
+physicsHashGrid::physicsHashGrid( const Real cellSize ) :
+	m_cellSize( cellSize ),
+	m_invCellSize( 1.f / cellSize )
+{
+	Assert( cellSize > 0.f, "hash grid cell size must be positive" );
+}
+
+physicsHashGrid::~physicsHashGrid()
+{
+
+}
+
+void physicsHashGrid::getCellRange( const BodyId bodyId, CellRange& rangeOut ) const
+{
+	rangeOut.minX = ( int )floor( m_bounds.getMinX()[bodyId] * m_invCellSize );
+	rangeOut.minY = ( int )floor( m_bounds.getMinY()[bodyId] * m_invCellSize );
+	rangeOut.maxX = ( int )floor( m_bounds.getMaxX()[bodyId] * m_invCellSize );
+	rangeOut.maxY = ( int )floor( m_bounds.getMaxY()[bodyId] * m_invCellSize );
+}
+
+unsigned int physicsHashGrid::hashCell( const int x, const int y )
+{
+	return ( ( unsigned int )x * 73856093u ) ^ ( ( unsigned int )y * 19349663u );
+}
+
+void physicsHashGrid::updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut )
+{
+	// Put bodies in every cell their aabb touches
+	m_entries.clear();
+
+	m_cellRanges.resize( m_bodyInfos.size() );
+
+	for ( int i = 0; i < ( int )m_bodyInfos.size(); i++ )
+	{
+		if ( !m_bodyInfos[i].isUsed || m_bodyInfos[i].isStatic )
+		{
+			continue;
+		}
+
+		BodyId bodyId = static_cast< BodyId >( i );
+		CellRange& range = m_cellRanges[bodyId];
+		getCellRange( bodyId, range );
+
+		for ( int y = range.minY; y <= range.maxY; y++ )
+		{
+			for ( int x = range.minX; x <= range.maxX; x++ )
+			{
+				CellEntry entry = { x, y, bodyId };
+				m_entries.push_back( entry );
+			}
+		}
+	}
+
+	// Counting sort entries into buckets, table twice the number of entries
+	int numEntries = ( int )m_entries.size();
+	unsigned int numBuckets = 1;
+	while ( numBuckets < 2 * ( unsigned int )numEntries )
+	{
+		numBuckets <<= 1;
+	}
+
+	m_bucketStarts.assign( numBuckets + 1, 0 );
+	m_entryHashes.resize( numEntries );
+
+	for ( int i = 0; i < numEntries; i++ )
+	{
+		unsigned int bucket = hashCell( m_entries[i].x, m_entries[i].y ) & ( numBuckets - 1 );
+		m_entryHashes[i] = bucket;
+		m_bucketStarts[bucket + 1]++;
+	}
+
+	for ( unsigned int i = 0; i < numBuckets; i++ )
+	{
+		m_bucketStarts[i + 1] += m_bucketStarts[i];
+	}
+
+	m_sortedEntries.resize( numEntries );
+
+	for ( int i = 0; i < numEntries; i++ )
+	{
+		// Re-use starts as insertion cursors, shifts them to bucket ends
+		m_sortedEntries[m_bucketStarts[m_entryHashes[i]]++] = m_entries[i];
+	}
+
+	// Buckets are split into contiguous ranges, one per thread
+	int numThreads = getNumThreads();
+	m_threadData.resize( numThreads );
+
+	auto findPairs = [&]( const int threadIdx )
+	{
+		int bucketBegin, bucketEnd;
+		physicsThreadPool::getRange( numBuckets, threadIdx, numThreads, bucketBegin, bucketEnd );
+
+		m_threadData[threadIdx].pairs.clear();
+		findPairsInBuckets( bucketBegin, bucketEnd, m_threadData[threadIdx] );
+	};
+
+	if ( numThreads > 1 )
+	{
+		m_threadPool->run( findPairs );
+	}
+	else
+	{
+		findPairs( 0 );
+	}
+
+	// Merged in thread order so reported order doesn't depend on scheduling
+	std::vector<BodyIdPair> pairs;
+
+	for ( auto iter = m_threadData.begin(); iter != m_threadData.end(); iter++ )
+	{
+		pairs.insert( pairs.end(), iter->pairs.begin(), iter->pairs.end() );
+	}
+
+	setPairs( m_pairs, pairs, addedPairsOut, removedPairsOut );
+}
+
+void physicsHashGrid::findPairsInBuckets( const int bucketBegin, const int bucketEnd, ThreadData& threadData ) const
+{
+	// Test bodies sharing a cell, a pair is only reported from the lowest cell both occupy
+	for ( int bucket = bucketBegin; bucket < bucketEnd; bucket++ )
+	{
+		// Insertion cursors were shifted to bucket ends
+		int entriesStart = ( bucket == 0 ) ? 0 : m_bucketStarts[bucket - 1];
+		int numBucketEntries = m_bucketStarts[bucket] - entriesStart;
+
+		if ( numBucketEntries < 2 )
+		{
+			continue;
+		}
+
+		const CellEntry* entries = &m_sortedEntries[entriesStart];
+
+		physicsAabbSoa& bucketBounds = threadData.bucketBounds;
+		bucketBounds.resize( numBucketEntries );
+
+		for ( int i = 0; i < numBucketEntries; i++ )
+		{
+			physicsAabb aabb;
+			m_bounds.get( entries[i].bodyId, aabb );
+			bucketBounds.set( i, aabb );
+		}
+
+		for ( int i = 0; i < numBucketEntries; i++ )
+		{
+			const CellEntry& entryA = entries[i];
+			const CellRange& rangeA = m_cellRanges[entryA.bodyId];
+
+			physicsAabb aabbA;
+			bucketBounds.get( i, aabbA );
+
+			threadData.bucketHits.clear();
+			bucketBounds.query( aabbA, i + 1, numBucketEntries, threadData.bucketHits );
+
+			for ( auto hit = threadData.bucketHits.begin(); hit != threadData.bucketHits.end(); hit++ )
+			{
+				const CellEntry& entryB = entries[*hit];
+
+				if ( entryA.x != entryB.x || entryA.y != entryB.y )
+				{
+					// Different cells colliding in hash
+					continue;
+				}
+
+				const CellRange& rangeB = m_cellRanges[entryB.bodyId];
+
+				if ( entryA.x != std::max( rangeA.minX, rangeB.minX ) ||
+					 entryA.y != std::max( rangeA.minY, rangeB.minY ) )
+				{
+					continue;
+				}
+
+				if ( checkCollidable( entryA.bodyId, entryB.bodyId ) )
+				{
+					threadData.pairs.push_back( BodyIdPair( entryA.bodyId, entryB.bodyId ) );
+				}
+			}
+		}
+	}
+}
+
+// Aabb tree class functions
+physicsAabbTreeBroadphase::physicsAabbTreeBroadphase( const Real margin ) :
+	m_tree( margin )
+{
+
+}
+
+physicsAabbTreeBroadphase::~physicsAabbTreeBroadphase()
+{
+
+}
+
+void physicsAabbTreeBroadphase::markMoved( const BodyId bodyId )
+{
+	if ( !m_proxies[bodyId].moved )
+	{
+		m_proxies[bodyId].moved = true;
+		m_movedBodies.push_back( bodyId );
+	}
+}
+
+void physicsAabbTreeBroadphase::addDynamicBody( const BodyId bodyId )
+{
+	if ( bodyId >= m_proxies.size() )
+	{
+		Proxy unused;
+		unused.proxyId = physicsAabbTree::NULL_NODE;
+		unused.moved = false;
+		m_proxies.resize( bodyId + 1, unused );
+	}
+
+	physicsAabb aabb;
+	m_bounds.get( bodyId, aabb );
+	m_proxies[bodyId].proxyId = m_tree.createProxy( aabb, bodyId );
+
+	markMoved( bodyId );
+}
+
+void physicsAabbTreeBroadphase::removeDynamicBody( const BodyId bodyId )
+{
+	Proxy& proxy = m_proxies[bodyId];
+	m_tree.destroyProxy( proxy.proxyId );
+	proxy.proxyId = physicsAabbTree::NULL_NODE;
+
+	// Stale entry in m_movedBodies is skipped on update
+	proxy.moved = false;
+}
+
+void physicsAabbTreeBroadphase::updateDynamicBody( const BodyId bodyId )
+{
+	physicsAabb aabb;
+	m_bounds.get( bodyId, aabb );
+
+	if ( m_tree.moveProxy( m_proxies[bodyId].proxyId, aabb ) )
+	{
+		markMoved( bodyId );
+	}
+}
+
+void physicsAabbTreeBroadphase::updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut )
+{
+	// Body could be removed then added again, leaving it in the list twice
+	std::sort( m_movedBodies.begin(), m_movedBodies.end() );
+	m_movedBodies.erase( std::unique( m_movedBodies.begin(), m_movedBodies.end() ), m_movedBodies.end() );
+
+	if ( !m_movedBodies.empty() )
+	{
+		// Pairs of moved bodies are lost once fat aabb's separate
+		for ( int slotIdx = 0; slotIdx < m_pairs.getNumSlots(); slotIdx++ )
+		{
+			if ( !m_pairs.isSlotUsed( slotIdx ) )
+			{
+				continue;
+			}
+
+			BodyIdPair pair = m_pairs.getSlotPair( slotIdx );
+			const Proxy& proxyA = m_proxies[pair.bodyIdA];
+			const Proxy& proxyB = m_proxies[pair.bodyIdB];
+
+			if ( ( proxyA.moved || proxyB.moved ) &&
+				 !m_tree.getFatAabb( proxyA.proxyId ).overlaps( m_tree.getFatAabb( proxyB.proxyId ) ) )
+			{
+				PairEvent event = { pair, false };
+				m_events.push_back( event );
+			}
+		}
+
+		// Moved bodies find new pairs from tree, tree is only read so queries run in parallel
+		int numThreads = getNumThreads();
+		m_threadData.resize( numThreads );
+
+		auto queryMoved = [&]( const int threadIdx )
+		{
+			int start, end;
+			physicsThreadPool::getRange( ( int )m_movedBodies.size(), threadIdx, numThreads, start, end );
+
+			m_threadData[threadIdx].events.clear();
+			queryMovedBodies( start, end, m_threadData[threadIdx] );
+		};
+
+		if ( numThreads > 1 )
+		{
+			m_threadPool->run( queryMoved );
+		}
+		else
+		{
+			queryMoved( 0 );
+		}
+
+		// Merged in thread order so event order doesn't depend on scheduling
+		for ( auto iter = m_threadData.begin(); iter != m_threadData.end(); iter++ )
+		{
+			m_events.insert( m_events.end(), iter->events.begin(), iter->events.end() );
+		}
+
+		applyPairEvents( m_events, addedPairsOut, removedPairsOut );
+
+		for ( auto iter = m_movedBodies.begin(); iter != m_movedBodies.end(); iter++ )
+		{
+			m_proxies[*iter].moved = false;
+		}
+
+		m_movedBodies.clear();
+	}
+}
+
+void physicsAabbTreeBroadphase::queryMovedBodies( const int start, const int end, ThreadData& threadData ) const
+{
+	for ( int i = start; i < end; i++ )
+	{
+		BodyId bodyId = m_movedBodies[i];
+		const Proxy& proxy = m_proxies[bodyId];
+
+		if ( !proxy.moved )
+		{
+			continue;
+		}
+
+		threadData.queryHits.clear();
+		m_tree.query( m_tree.getFatAabb( proxy.proxyId ), threadData.queryHits );
+
+		for ( auto hit = threadData.queryHits.begin(); hit != threadData.queryHits.end(); hit++ )
+		{
+			const Proxy& other = m_proxies[*hit];
+
+			// When both moved, pair is only added by body with lower Id
+			if ( *hit == bodyId || ( other.moved && *hit < bodyId ) )
+			{
+				continue;
+			}
+
+			if ( checkCollidable( bodyId, *hit ) )
+			{
+				PairEvent event = { BodyIdPair( bodyId, *hit ), true };
+				threadData.events.push_back( event );
+			}
+		}
+	}
+}
+
+void physicsAabbTreeBroadphase::queryAabb( const physicsAabb& aabb, std::vector<BodyId>& bodyIdsOut ) const
+{
+	size_t numPrevious = bodyIdsOut.size();
+	m_tree.query( aabb, bodyIdsOut );
+
+	// Tree holds fat aabb's, keep hits on actual aabb's only
+	auto iter = bodyIdsOut.begin() + numPrevious;
+
+	for ( auto hit = iter; hit != bodyIdsOut.end(); hit++ )
+	{
+		if ( m_bounds.overlaps( *hit, aabb ) )
+		{
+			*iter = *hit;
+			iter++;
+		}
+	}
+
+	bodyIdsOut.erase( iter, bodyIdsOut.end() );
+
+	// Static tree isn't enlarged
+	m_staticTree.query( aabb, bodyIdsOut );
+}
@@ -0,0 +1,371 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#include <physicsObject.h>
+#include <physicsTypes.h>
+#include <physicsAabb.h>
+#include <physicsAabbSoa.h>
+#include <physicsAabbTree.h>
+#include <physicsThreadPool.h>
+#include <physicsInternalTypes.h>
+#include <physicsPairMap.h>
+
+// Broadphase representation of a body, holds everything needed to reject pairs
+// without touching physicsBody. Only used to pass bodies in and out, broadphases store bounds as SoA
+struct BroadphaseBody
+{
+	BodyId bodyId;
+	physicsAabb aabb;
+	unsigned int category; // Groups body belongs to, one bit each
+	unsigned int mask; // Groups body collides with
+	bool isStatic;
+
+	BroadphaseBody( const BodyId bodyId = invalidId, const physicsAabb& aabb = physicsAabb() ) :
+		bodyId( bodyId ),
+		aabb( aabb ),
+		category( 1 ),
+		mask( 0xffffffff ),
+		isStatic( false )
+	{
+
+	}
+};
+
+// Base class for broadphases, keeps the set of overlapping pairs between steps
+// and reports pairs which were found and lost since last update.
+// Static bodies are kept apart in a tree which only changes when they are added, moved or removed,
+// derived classes only see dynamic bodies and dynamic bodies are tested against the static tree
+class physicsBroadphase : public physicsObject
+{
+public:
+
+	enum Type
+	{
+		SWEEP_AND_PRUNE = 0,
+		HASH_GRID,
+		AABB_TREE,
+		NUM_BROADPHASES
+	};
+
+public:
+
+	physicsBroadphase();
+
+	virtual ~physicsBroadphase();
+
+	virtual Type getType() const = 0;
+
+	// Bodies are identified by their body Ids
+	void addBody( const BroadphaseBody& body );
+
+	void removeBody( const BodyId bodyId );
+
+	void updateBody( const BodyId bodyId, const physicsAabb& aabb );
+
+	// Reports pairs which started and stopped overlapping since last call, in no particular order
+	void updatePairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut );
+
+	// Appends Ids of bodies whose aabb overlaps aabb, tests all bodies with wide overlap kernel by default
+	virtual void queryAabb( const physicsAabb& aabb, std::vector<BodyId>& bodyIdsOut ) const;
+
+	// Debug access to aabb's currently in broadphase
+	void getBroadphaseBodies( std::vector<BroadphaseBody>& bodiesOut ) const;
+
+	// Sorted set of currently overlapping pairs, including ones with static bodies. Meant for debugging
+	void getPairs( std::vector<BodyIdPair>& pairsOut ) const;
+
+	// Bounds indexed by body Id, unused Ids hold empty aabb's
+	const physicsAabbSoa& getBounds() const { return m_bounds; }
+
+	// Pair finding is split across threads of the pool where possible, null runs on calling thread
+	void setThreadPool( physicsThreadPool* threadPool ) { m_threadPool = threadPool; }
+
+protected:
+
+	struct BodyInfo
+	{
+		bool isStatic;
+		bool isUsed;
+		int staticProxyId; // Leaf in m_staticTree if static
+	};
+
+	// Derived classes track dynamic bodies, bounds are already in m_bounds when called
+	virtual void addDynamicBody( const BodyId /*bodyId*/ ) {}
+
+	virtual void removeDynamicBody( const BodyId /*bodyId*/ ) {}
+
+	virtual void updateDynamicBody( const BodyId /*bodyId*/ ) {}
+
+	// Pair set maps pairs to the last update they were found in
+	typedef physicsPairMap<unsigned int> PairSet;
+
+	// Updates m_pairs, appends pairs found and lost between dynamic bodies
+	virtual void updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut ) = 0;
+
+	// Tests all dynamic bodies against static tree
+	void updateStaticPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut );
+
+	int getNumThreads() const;
+
+	bool isUsed( const BodyId bodyId ) const;
+
+	// Pair collides if each body's category is in the other's mask, only touches filter arrays
+	inline bool checkCollidable( const BodyId bodyIdA, const BodyId bodyIdB ) const;
+
+	// Removes pairs involving body from overlapping pair set, reports them on next update
+	void removePairsOfBody( const BodyId bodyId );
+
+	// Replaces contents of pairs with currentPairs, pairs not found again are removed
+	void setPairs( PairSet& pairs,
+				   const std::vector<BodyIdPair>& currentPairs,
+				   std::vector<BodyIdPair>& addedPairsOut,
+				   std::vector<BodyIdPair>& removedPairsOut );
+
+	struct PairEvent
+	{
+		BodyIdPair pair;
+		bool isAdded;
+	};
+
+	// Applies pair events in order they occurred, pairs ending up in the state they started in aren't reported
+	void applyPairEvents( std::vector<PairEvent>& events,
+						  std::vector<BodyIdPair>& addedPairsOut,
+						  std::vector<BodyIdPair>& removedPairsOut );
+
+	std::vector<BodyInfo> m_bodyInfos; // Indexed by bodyId
+	physicsAabbSoa m_bounds; // Indexed by bodyId
+
+	// Indexed by bodyId, kept apart from m_bodyInfos so filtering reads two small arrays.
+	// Unused Ids have no category and never pass
+	std::vector<unsigned int> m_categories;
+	std::vector<unsigned int> m_masks;
+
+	physicsThreadPool* m_threadPool; // Not owned
+
+	// Static bodies, tight aabb's
+	physicsAabbTree m_staticTree;
+	PairSet m_staticPairs; // Pairs between dynamic and static bodies
+	std::vector<std::vector<BodyIdPair>> m_staticThreadPairs;
+
+	// Pairs between dynamic bodies
+	PairSet m_pairs;
+
+	// Pairs lost due to body removal, reported on next update
+	std::vector<BodyIdPair> m_removedPairs;
+
+	// Pairs changed by applyPairEvents, mapped to whether they existed before
+	physicsPairMap<bool> m_changedPairs;
+
+	unsigned int m_updateStamp; // Incremented every updatePairs
+};
+
+inline bool physicsBroadphase::checkCollidable( const BodyId bodyIdA, const BodyId bodyIdB ) const
+{
+	// Static bodies are only tested against dynamic ones, static pairs needn't be rejected here
+	return ( m_categories[bodyIdA] & m_masks[bodyIdB] ) != 0 && ( m_categories[bodyIdB] & m_masks[bodyIdA] ) != 0;
+}
+
+// Persistent sweep and prune
+// Endpoints are kept sorted between steps on both axes and updated with insertion sort, each thread sorts
+// a chunk of an axis and endpoints crossing chunks are moved after. Pairs whose min and max endpoints swapped
+// are added or removed by their overlap in final order. Full rebuilds radix sort endpoints and sweep
+// along the axis bodies are spread the most, testing each body against the run of bodies starting
+// within its interval with the wide overlap kernel
+class physicsSweepAndPrune : public physicsBroadphase
+{
+public:
+
+	physicsSweepAndPrune();
+
+	virtual ~physicsSweepAndPrune() override;
+
+	virtual Type getType() const override { return physicsBroadphase::SWEEP_AND_PRUNE; }
+
+protected:
+
+	enum { NUM_AXES = 2 };
+
+	struct Endpoint
+	{
+		Real value;
+		unsigned int data; // bodyId << 1 | isMax
+
+		BodyId getBodyId() const { return static_cast< BodyId >( data >> 1 ); }
+		bool isMax() const { return ( data & 1 ) != 0; }
+	};
+
+	struct Proxy
+	{
+		int min[NUM_AXES]; // Index of endpoints in m_endpoints
+		int max[NUM_AXES];
+	};
+
+	// Compact entry sorted on rebuild, key orders like the float value it came from
+	struct SortEntry
+	{
+		unsigned int key;
+		unsigned int data; // Endpoint::data
+	};
+
+	static unsigned int getSortKey( const Real value );
+
+	// Stable LSD radix sort on keys, 8 bits per pass, temp is scratch
+	static void radixSort( std::vector<SortEntry>& entries, std::vector<SortEntry>& temp );
+
+	Real getEndpointValue( const Endpoint& endpoint, const int axis ) const;
+
+	virtual void addDynamicBody( const BodyId bodyId ) override;
+
+	virtual void removeDynamicBody( const BodyId bodyId ) override;
+
+	virtual void updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut ) override;
+
+	// Sorts endpoints from scratch, finds all overlapping pairs
+	void rebuild( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut );
+
+	// Axis along which centers of dynamic bodies vary the most, fewest bodies overlap on it
+	int chooseSweepAxis() const;
+
+	// Finds pairs for bodies whose min endpoint on sweep axis is within endpoints [start, end)
+	void findPairsInSlab( const int start, const int end, std::vector<BodyIdPair>& pairsOut ) const;
+
+	// Re-sorts one axis with insertion sort split across threads, appends pairs which may have changed overlap state
+	// to m_threadPairs
+	void sortAxis( const int axis, const int numThreads );
+
+	// Swaps endpoint with the one below it
+	void swapDown( const int axis, const int index, std::vector<BodyIdPair>& changedPairsOut );
+
+	// At equal values max endpoints go first, so touching bodies don't overlap, same as physicsAabb::overlaps
+	static bool endpointLess( const Endpoint& endpointA, const Endpoint& endpointB );
+
+	// Endpoint orders are compared instead of values to be consistent with swaps
+	bool overlapsOnAxis( const Proxy& proxyA, const Proxy& proxyB, const int axis ) const;
+
+	std::vector<Proxy> m_proxies; // Indexed by bodyId
+	std::vector<Endpoint> m_endpoints[NUM_AXES];
+	std::vector<PairEvent> m_events;
+	std::vector<std::vector<BodyIdPair>> m_threadPairs; // Per-thread output of rebuild and sort
+	std::vector<SortEntry> m_sortEntries;
+	std::vector<SortEntry> m_sortTemp;
+	physicsAabbSoa m_sweepBounds; // Bounds in order of min endpoints on sweep axis, set on rebuild
+	std::vector<BodyId> m_sweepBodyIds; // Body of each entry in m_sweepBounds
+	std::vector<int> m_minRanks; // Number of min endpoints on sweep axis before each endpoint
+	int m_sweepAxis; // Chosen on rebuild
+	bool m_needsRebuild;
+};
+
+// Uniform grid addressed through spatial hash
+// Suited for many bodies of similar size, cell size should be around the size of a typical aabb
+class physicsHashGrid : public physicsBroadphase
+{
+public:
+
+	physicsHashGrid( const Real cellSize );
+
+	virtual ~physicsHashGrid() override;
+
+	virtual Type getType() const override { return physicsBroadphase::HASH_GRID; }
+
+	Real getCellSize() const { return m_cellSize; }
+
+protected:
+
+	virtual void updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut ) override;
+
+	struct CellEntry
+	{
+		int x, y; // Cell coordinates
+		BodyId bodyId;
+	};
+
+	struct CellRange
+	{
+		int minX, minY, maxX, maxY;
+	};
+
+	// Per-thread scratch and output
+	struct ThreadData
+	{
+		physicsAabbSoa bucketBounds;
+		std::vector<int> bucketHits;
+		std::vector<BodyIdPair> pairs;
+	};
+
+	void getCellRange( const BodyId bodyId, CellRange& rangeOut ) const;
+
+	void findPairsInBuckets( const int bucketBegin, const int bucketEnd, ThreadData& threadData ) const;
+
+	static unsigned int hashCell( const int x, const int y );
+
+	Real m_cellSize;
+	Real m_invCellSize;
+
+	std::vector<CellRange> m_cellRanges; // Indexed by bodyId
+
+	// Rebuilt every update, entries are bucketed by hash with counting sort
+	std::vector<CellEntry> m_entries;
+	std::vector<CellEntry> m_sortedEntries;
+	std::vector<unsigned int> m_entryHashes;
+	std::vector<int> m_bucketStarts;
+
+	std::vector<ThreadData> m_threadData;
+};
+
+// Dynamic aabb tree
+// Pairs only change for bodies which escaped their fat aabb, those are re-inserted and queried against the tree.
+// Pairs are kept while fat aabb's overlap
+class physicsAabbTreeBroadphase : public physicsBroadphase
+{
+public:
+
+	physicsAabbTreeBroadphase( const Real margin );
+
+	virtual ~physicsAabbTreeBroadphase() override;
+
+	virtual Type getType() const override { return physicsBroadphase::AABB_TREE; }
+
+	virtual void queryAabb( const physicsAabb& aabb, std::vector<BodyId>& bodyIdsOut ) const override;
+
+	const physicsAabbTree& getTree() const { return m_tree; }
+
+	// Pairs between dynamic bodies are kept exactly while their fat aabb's overlap, meant for debugging
+	const physicsAabb& getFatAabb( const BodyId bodyId ) const { return m_tree.getFatAabb( m_proxies[bodyId].proxyId ); }
+
+protected:
+
+	struct Proxy
+	{
+		int proxyId; // Leaf in m_tree, NULL_NODE if unused
+		bool moved;  // Re-inserted since last update
+	};
+
+	// Per-thread scratch and output
+	struct ThreadData
+	{
+		std::vector<BodyId> queryHits;
+		std::vector<PairEvent> events;
+	};
+
+	virtual void addDynamicBody( const BodyId bodyId ) override;
+
+	virtual void removeDynamicBody( const BodyId bodyId ) override;
+
+	virtual void updateDynamicBody( const BodyId bodyId ) override;
+
+	virtual void updateDynamicPairs( std::vector<BodyIdPair>& addedPairsOut, std::vector<BodyIdPair>& removedPairsOut ) override;
+
+	void markMoved( const BodyId bodyId );
+
+	// Queries tree with moved bodies [start, end), adds events for pairs found
+	void queryMovedBodies( const int start, const int end, ThreadData& threadData ) const;
+
+	physicsAabbTree m_tree;
+
+	std::vector<Proxy> m_proxies; // Indexed by bodyId
+	std::vector<BodyId> m_movedBodies;
+	std::vector<PairEvent> m_events;
+	std::vector<ThreadData> m_threadData;
+};
@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include <physicsCircleBatch.h>
+
+physicsCircleBatch::physicsCircleBatch() :
+	m_size( 0 )
+{
+
+}
+
+physicsCircleBatch::~physicsCircleBatch()
+{
+
+}
+
+void physicsCircleBatch::resize( const int size )
+{
+	// Padded entries past size are kept at zero radius
+	int paddedSize = ( ( size + WIDTH - 1 ) / WIDTH ) * WIDTH;
+	int previousSize = m_size;
+
+	m_posAx.resize( paddedSize, 0.f );
+	m_posAy.resize( paddedSize, 0.f );
+	m_posBx.resize( paddedSize, 0.f );
+	m_posBy.resize( paddedSize, 0.f );
+	m_radiusA.resize( paddedSize, 0.f );
+	m_radiusB.resize( paddedSize, 0.f );
+	m_depth.resize( paddedSize, 0.f );
+	m_normalX.resize( paddedSize, 0.f );
+	m_normalY.resize( paddedSize, 0.f );
+
+	m_size = size;
+
+	for ( int i = size; i < std::min( previousSize, paddedSize ); i++ )
+	{
+		m_radiusA[i] = 0.f;
+		m_radiusB[i] = 0.f;
+	}
+}
+
+void physicsCircleBatch::set( const int index, const Vector4& posA, const Real radiusA, const Vector4& posB, const Real radiusB )
+{
+	Assert( index < m_size, "setting circle pair out of range" );
+
+	m_posAx[index] = posA( 0 );
+	m_posAy[index] = posA( 1 );
+	m_posBx[index] = posB( 0 );
+	m_posBy[index] = posB( 1 );
+	m_radiusA[index] = radiusA;
+	m_radiusB[index] = radiusB;
+}
+
+void physicsCircleBatch::collide( const int start, const int end, std::vector<int>& touchingOut )
+{
+	Assert( start % 4 == 0, "circle batch range doesn't start at a kernel boundary" );
+
+	int i = start;
+
+#if defined( __AVX2__ )
+	for ( ; i < end && i + 8 <= ( int )m_depth.size(); i += 8 )
+	{
+		unsigned int mask = collide8( i );
+
+		for ( int bit = 0; mask != 0; bit++, mask >>= 1 )
+		{
+			if ( ( mask & 1 ) && i + bit < end )
+			{
+				touchingOut.push_back( i + bit );
+			}
+		}
+	}
+#endif
+
+	for ( ; i < end; i += 4 )
+	{
+		unsigned int mask = collide4( i );
+
+		for ( int bit = 0; mask != 0; bit++, mask >>= 1 )
+		{
+			if ( ( mask & 1 ) && i + bit < end )
+			{
+				touchingOut.push_back( i + bit );
+			}
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+// Circle-circle pairs laid out as structure-of-arrays so narrowphase collides several at once.
+// Each pair keeps both centers and radii, collide fills in depth and normal (from A to B) of touching ones.
+// Arrays are padded to a multiple of WIDTH with zero radius pairs which never touch
+class physicsCircleBatch
+{
+public:
+
+	enum { WIDTH = 8 }; // Padding, enough for widest kernel
+
+	physicsCircleBatch();
+
+	~physicsCircleBatch();
+
+	// Newly exposed entries don't touch
+	void resize( const int size );
+
+	void clear() { resize( 0 ); }
+
+	int getSize() const { return m_size; }
+
+	void set( const int index, const Vector4& posA, const Real radiusA, const Vector4& posB, const Real radiusB );
+
+	// Collides pairs [start, start + 4), bit i of mask is set if start + i touches.
+	// Concentric circles don't touch as there's no direction to push them apart in
+	inline unsigned int collide4( const int start );
+
+	// Collides pairs [start, start + 8), falls back to two SSE kernels without AVX2
+	inline unsigned int collide8( const int start );
+
+	// Collides pairs [start, end), appends indices of touching ones.
+	// Kernels store results of whole blocks, start should be a multiple of WIDTH for ranges to be written separately
+	void collide( const int start, const int end, std::vector<int>& touchingOut );
+
+	void collide( std::vector<int>& touchingOut ) { collide( 0, m_size, touchingOut ); }
+
+	// Only valid for touching pairs after collide
+	Real getDepth( const int index ) const { return m_depth[index]; }
+	Vector4 getNormal( const int index ) const { return Vector4( m_normalX[index], m_normalY[index] ); }
+
+	Real getRadiusA( const int index ) const { return m_radiusA[index]; }
+	Real getRadiusB( const int index ) const { return m_radiusB[index]; }
+
+protected:
+
+	int m_size;
+
+	std::vector<Real> m_posAx;
+	std::vector<Real> m_posAy;
+	std::vector<Real> m_posBx;
+	std::vector<Real> m_posBy;
+	std::vector<Real> m_radiusA;
+	std::vector<Real> m_radiusB;
+
+	// Results
+	std::vector<Real> m_depth;
+	std::vector<Real> m_normalX;
+	std::vector<Real> m_normalY;
+};
+
+#include <physicsCircleBatch.inl>
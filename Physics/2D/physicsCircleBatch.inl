@@ -0,0 +1,40 @@
+inline unsigned int physicsCircleBatch::collide4( const int start )
+{
+	__m128 dx = _mm_sub_ps( _mm_loadu_ps( &m_posBx[start] ), _mm_loadu_ps( &m_posAx[start] ) );
+	__m128 dy = _mm_sub_ps( _mm_loadu_ps( &m_posBy[start] ), _mm_loadu_ps( &m_posAy[start] ) );
+	__m128 radiusSum = _mm_add_ps( _mm_loadu_ps( &m_radiusA[start] ), _mm_loadu_ps( &m_radiusB[start] ) );
+
+	__m128 distSq = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) );
+	__m128 touching = _mm_and_ps( _mm_cmplt_ps( distSq, _mm_mul_ps( radiusSum, radiusSum ) ),
+								  _mm_cmpgt_ps( distSq, _mm_setzero_ps() ) );
+
+	// Lanes which don't touch may divide by zero, they're never read
+	__m128 dist = _mm_sqrt_ps( distSq );
+	_mm_storeu_ps( &m_depth[start], _mm_sub_ps( radiusSum, dist ) );
+	_mm_storeu_ps( &m_normalX[start], _mm_div_ps( dx, dist ) );
+	_mm_storeu_ps( &m_normalY[start], _mm_div_ps( dy, dist ) );
+
+	return static_cast< unsigned int >( _mm_movemask_ps( touching ) );
+}
+
+inline unsigned int physicsCircleBatch::collide8( const int start )
+{
+#if defined( __AVX2__ )
+	__m256 dx = _mm256_sub_ps( _mm256_loadu_ps( &m_posBx[start] ), _mm256_loadu_ps( &m_posAx[start] ) );
+	__m256 dy = _mm256_sub_ps( _mm256_loadu_ps( &m_posBy[start] ), _mm256_loadu_ps( &m_posAy[start] ) );
+	__m256 radiusSum = _mm256_add_ps( _mm256_loadu_ps( &m_radiusA[start] ), _mm256_loadu_ps( &m_radiusB[start] ) );
+
+	__m256 distSq = _mm256_add_ps( _mm256_mul_ps( dx, dx ), _mm256_mul_ps( dy, dy ) );
+	__m256 touching = _mm256_and_ps( _mm256_cmp_ps( distSq, _mm256_mul_ps( radiusSum, radiusSum ), _CMP_LT_OQ ),
+									 _mm256_cmp_ps( distSq, _mm256_setzero_ps(), _CMP_GT_OQ ) );
+
+	__m256 dist = _mm256_sqrt_ps( distSq );
+	_mm256_storeu_ps( &m_depth[start], _mm256_sub_ps( radiusSum, dist ) );
+	_mm256_storeu_ps( &m_normalX[start], _mm256_div_ps( dx, dist ) );
+	_mm256_storeu_ps( &m_normalY[start], _mm256_div_ps( dy, dist ) );
+
+	return static_cast< unsigned int >( _mm256_movemask_ps( touching ) );
+#else
+	return collide4( start ) | ( collide4( start + 4 ) << 4 );
+#endif
+}
@@ -10,7 +10,6 @@
 #include <physicsCollider.h>
 
 #include <DebugUtils.h>
-#include <Renderer.h>
 
 const Real g_collisionTolerance = .5f;
 const Real g_convexRadius = 1.f;
@@ -37,7 +36,7 @@ physicsCollider::physicsCollider()
 void physicsCollider::collide( const std::shared_ptr<physicsShape>& shapeA, 
 							   const std::shared_ptr<physicsShape>& shapeB,
 							   const Transform & transformA, const Transform & transformB,
-							   std::vector<ContactPoint>& contacts )
+							   ContactManifold& contacts )
 {
 
 }
@@ -51,7 +50,7 @@ physicsCircleCollider::physicsCircleCollider()
 void physicsCircleCollider::collide( const physicsShape* shapeA,
 									 const physicsShape* shapeB, 
 									 const Transform & transformA, const Transform & transformB, 
-									 std::vector<ContactPoint>& contacts )
+									 ContactManifold& contacts, ColliderCache* cache )
 {
 	Assert( shapeA->getType() == physicsShape::CIRCLE, "non-circle shape sent to circle collider" );
 	Assert( shapeB->getType() == physicsShape::CIRCLE, "non-circle shape sent to circle collider" );
@@ -61,8 +60,6 @@ void physicsCircleCollider::collide( const physicsShape* shapeA,
 
 	Vector4 posA = transformA.getTranslation();
 	Vector4 posB = transformB.getTranslation();
-	Transform rotA; rotA.setRotation( transformA.getRotation() );
-	Transform rotB; rotB.setRotation( transformB.getRotation() );
 
 	Vector4 ab = posB - posA;
 
@@ -94,11 +91,11 @@ void physicsCircleCollider::collide( const physicsShape* shapeA,
 		// TODO: See if we can avoid square rooting
 		norm.normalize<2>();
 
-		Vector4 cpAinA; cpAinA.setTransformedInversePos( rotA, cpA - posA );
-		Vector4 cpBinB; cpBinB.setTransformedInversePos( rotB, cpB - posB );
+		Vector4 cpAinA; cpAinA.setInverseRotatedPos( transformA, cpA - posA );
+		Vector4 cpBinB; cpBinB.setInverseRotatedPos( transformB, cpB - posB );
 		ContactPoint contact( depth, cpAinA, cpBinB, norm ); // AB for separation
 
-		contacts.push_back( contact );
+		contacts.addContact( contact );
 	}
 }
 
@@ -109,12 +106,213 @@ physicsCircleBoxCollider::physicsCircleBoxCollider()
 }
 
 // A: Circle, B: Box
-void physicsCircleBoxCollider::collide( const physicsShape* shapeA, const physicsShape* shapeB, const Transform & transformA, const Transform & transformB, std::vector<ContactPoint>& contacts )
+void physicsCircleBoxCollider::collide( const physicsShape* shapeA, const physicsShape* shapeB, const Transform & transformA, const Transform & transformB, ContactManifold& contacts, ColliderCache* cache )
 {
 	Assert( shapeA->getType() == physicsShape::CIRCLE, "non-circle shape sent to circle-box collider 1st param" );
 	Assert( shapeB->getType() == physicsShape::BOX, "non-box shape sent to circle-box collider 2nd param" );
 
-	// TODO: implement this
+	const physicsCircleShape* circle = static_cast< const physicsCircleShape* >( shapeA );
+	const physicsBoxShape* box = static_cast< const physicsBoxShape* >( shapeB );
+
+	Real radius = circle->getRadius();
+	const Vector4& halfExtents = box->getHalfExtents();
+
+	// Circle center in box space
+	Vector4 center; center.setInverseRotatedPos( transformB, transformA.getTranslation() - transformB.getTranslation() );
+
+	// Closest point on box, normal points from box to circle
+	Vector4 closest;
+	Vector4 normal;
+	Real depth;
+	unsigned int featureId;
+
+	Real clampedX = std::max( -halfExtents( 0 ), std::min( center( 0 ), halfExtents( 0 ) ) );
+	Real clampedY = std::max( -halfExtents( 1 ), std::min( center( 1 ), halfExtents( 1 ) ) );
+
+	if ( clampedX != center( 0 ) || clampedY != center( 1 ) )
+	{
+		// Center outside, closest point is on a face or a corner
+		closest.set( clampedX, clampedY );
+
+		Vector4 diff = center - closest;
+		Real distSq = diff.lengthSquared<2>();
+
+		if ( distSq >= radius * radius || distSq == 0.f )
+		{
+			return;
+		}
+
+		Real dist = sqrt( distSq );
+		normal = diff / dist;
+		depth = radius - dist;
+
+		// Faces +x, +y, -x, -y, corners after
+		bool onX = ( clampedX != center( 0 ) );
+		bool onY = ( clampedY != center( 1 ) );
+
+		if ( onX && onY )
+		{
+			featureId = 4 + ( clampedX > 0.f ? ( clampedY > 0.f ? 1 : 0 ) : ( clampedY > 0.f ? 2 : 3 ) );
+		}
+		else if ( onX )
+		{
+			featureId = ( clampedX > 0.f ) ? 0 : 2;
+		}
+		else
+		{
+			featureId = ( clampedY > 0.f ) ? 1 : 3;
+		}
+	}
+	else
+	{
+		// Center inside, push out through nearest face
+		Real distX = halfExtents( 0 ) - fabs( center( 0 ) );
+		Real distY = halfExtents( 1 ) - fabs( center( 1 ) );
+
+		closest = center;
+
+		if ( distX < distY )
+		{
+			Real sign = ( center( 0 ) < 0.f ) ? -1.f : 1.f;
+			normal.set( sign, 0.f );
+			closest.set( sign * halfExtents( 0 ), center( 1 ) );
+			depth = radius + distX;
+			featureId = ( sign > 0.f ) ? 0 : 2;
+		}
+		else
+		{
+			Real sign = ( center( 1 ) < 0.f ) ? -1.f : 1.f;
+			normal.set( 0.f, sign );
+			closest.set( center( 0 ), sign * halfExtents( 1 ) );
+			depth = radius + distY;
+			featureId = ( sign > 0.f ) ? 1 : 3;
+		}
+	}
+
+	// Back to world orientation, contact normal points from circle to box
+	Vector4 normalWs; normalWs.setRotatedPos( transformB, normal );
+	Vector4 normalAb = normalWs.getNegated();
+
+	Vector4 cpInA; cpInA.setInverseRotatedPos( transformA, normalAb * radius );
+
+	contacts.addContact( ContactPoint( depth, cpInA, closest, normalAb, featureId ) );
+}
+
+// Circle-convex collision agent class functions
+physicsCircleConvexCollider::physicsCircleConvexCollider()
+{
+
+}
+
+// A: Circle, B: Convex
+void physicsCircleConvexCollider::collide( const physicsShape* shapeA, const physicsShape* shapeB, const Transform & transformA, const Transform & transformB, ContactManifold& contacts, ColliderCache* cache )
+{
+	Assert( shapeA->getType() == physicsShape::CIRCLE, "non-circle shape sent to circle-convex collider 1st param" );
+	Assert( shapeB->getType() == physicsShape::CONVEX, "non-convex shape sent to circle-convex collider 2nd param" );
+
+	const physicsCircleShape* circle = static_cast< const physicsCircleShape* >( shapeA );
+	const physicsConvexShape* convex = static_cast< const physicsConvexShape* >( shapeB );
+
+	// Circle is a point rounded by its radius, which already plays the part of its convex radius,
+	// so m_convexRadius isn't added on top. Polygon stays sharp like the support vertices GJK sees
+	Real radius = circle->getRadius();
+
+	const std::vector<Vector4>& vertices = convex->getVertices();
+	const std::vector<int>& connectivity = convex->getConnectivity();
+	int numEdges = ( int )connectivity.size() - 1;
+
+	// Circle center in convex space
+	Vector4 center; center.setInverseRotatedPos( transformB, transformA.getTranslation() - transformB.getTranslation() );
+
+	// Face with largest separation from center, connectivity winds clockwise so outward normal is edge turned counter-clockwise
+	int maxEdge = -1;
+	Real maxSeparation = std::numeric_limits<Real>::lowest();
+	Vector4 maxNormal;
+
+	for ( int i = 0; i < numEdges; i++ )
+	{
+		const Vector4& v0 = vertices[connectivity[i]];
+		const Vector4& v1 = vertices[connectivity[i + 1]];
+
+		Vector4 faceNormal( v0( 1 ) - v1( 1 ), v1( 0 ) - v0( 0 ) );
+
+		if ( faceNormal.isZero() )
+		{
+			// Repeated vertex
+			continue;
+		}
+
+		faceNormal.normalize<2>();
+
+		Real separation = faceNormal.dot<2>( center - v0 );
+
+		if ( separation >= radius )
+		{
+			// Separating axis found
+			return;
+		}
+
+		if ( separation > maxSeparation )
+		{
+			maxSeparation = separation;
+			maxEdge = i;
+			maxNormal = faceNormal;
+		}
+	}
+
+	if ( maxEdge < 0 )
+	{
+		return;
+	}
+
+	// Closest point on polygon, normal points from polygon to circle
+	Vector4 closest;
+	Vector4 normal;
+	Real depth;
+	unsigned int featureId;
+
+	const Vector4& v0 = vertices[connectivity[maxEdge]];
+	const Vector4& v1 = vertices[connectivity[maxEdge + 1]];
+	Vector4 edge = v1 - v0;
+
+	Real u0 = edge.dot<2>( center - v0 );
+	Real u1 = edge.dot<2>( v1 - center );
+
+	if ( maxSeparation > 0.f && ( u0 <= 0.f || u1 <= 0.f ) )
+	{
+		// Center outside and past an end of face, closest point is the vertex there
+		int vertex = ( u0 <= 0.f ) ? maxEdge : ( maxEdge + 1 ) % numEdges;
+		closest = vertices[connectivity[vertex]];
+
+		Vector4 diff = center - closest;
+		Real distSq = diff.lengthSquared<2>();
+
+		if ( distSq >= radius * radius || distSq == 0.f )
+		{
+			return;
+		}
+
+		Real dist = sqrt( distSq );
+		normal = diff / dist;
+		depth = radius - dist;
+		featureId = numEdges + vertex;
+	}
+	else
+	{
+		// Center in front of face, or inside and pushed out through nearest face
+		normal = maxNormal;
+		closest = center - maxNormal * maxSeparation;
+		depth = radius - maxSeparation;
+		featureId = maxEdge;
+	}
+
+	// Back to world orientation, contact normal points from circle to polygon
+	Vector4 normalWs; normalWs.setRotatedPos( transformB, normal );
+	Vector4 normalAb = normalWs.getNegated();
+
+	Vector4 cpInA; cpInA.setInverseRotatedPos( transformA, normalAb * radius );
+
+	contacts.addContact( ContactPoint( depth, cpInA, closest, normalAb, featureId ) );
 }
 
 // Box-box collision agent class functions
@@ -123,12 +321,193 @@ physicsBoxCollider::physicsBoxCollider()
 
 }
 
-void physicsBoxCollider::collide( const physicsShape* shapeA, const physicsShape* shapeB, const Transform & transformA, const Transform & transformB, std::vector<ContactPoint>& contacts )
+void physicsBoxCollider::BoxFrame::set( const physicsBoxShape* box, const Transform& transform )
+{
+	Real cosRot = transform( 0, 0 );
+	Real sinRot = transform( 1, 0 );
+
+	center = transform.getTranslation();
+	axes[0].set( cosRot, sinRot );
+	axes[1].set( -sinRot, cosRot );
+	halfExtents[0] = box->getHalfExtents()( 0 );
+	halfExtents[1] = box->getHalfExtents()( 1 );
+}
+
+Vector4 physicsBoxCollider::BoxFrame::getVertex( const int vertex ) const
+{
+	// +x-y, +x+y, -x+y, -x-y
+	Real signX = ( vertex == 0 || vertex == 1 ) ? 1.f : -1.f;
+	Real signY = ( vertex == 1 || vertex == 2 ) ? 1.f : -1.f;
+
+	return center + axes[0] * ( signX * halfExtents[0] ) + axes[1] * ( signY * halfExtents[1] );
+}
+
+Real physicsBoxCollider::findMaxSeparation( const BoxFrame& boxA, const BoxFrame& boxB, int& faceOut )
+{
+	Vector4 ab = boxB.center - boxA.center;
+	Real maxSeparation = std::numeric_limits<Real>::lowest();
+
+	for ( int face = 0; face < 4; face++ )
+	{
+		Vector4 normal = boxA.getFaceNormal( face );
+
+		// Extent of B towards A along normal
+		Real extentB = boxB.halfExtents[0] * fabs( normal.dot<2>( boxB.axes[0] ) ) +
+					   boxB.halfExtents[1] * fabs( normal.dot<2>( boxB.axes[1] ) );
+
+		Real separation = normal.dot<2>( ab ) - boxA.halfExtents[face & 1] - extentB;
+
+		if ( separation > maxSeparation )
+		{
+			maxSeparation = separation;
+			faceOut = face;
+		}
+	}
+
+	return maxSeparation;
+}
+
+int physicsBoxCollider::findIncidentFace( const BoxFrame& box, const Vector4& normal )
+{
+	int incidentFace = 0;
+	Real minDot = std::numeric_limits<Real>::max();
+
+	for ( int face = 0; face < 4; face++ )
+	{
+		Real dot = box.getFaceNormal( face ).dot<2>( normal );
+
+		if ( dot < minDot )
+		{
+			minDot = dot;
+			incidentFace = face;
+		}
+	}
+
+	return incidentFace;
+}
+
+int physicsBoxCollider::clipSegment( const ClipVertex in[2], ClipVertex out[2], const Vector4& normal, const Real offset, const unsigned int clipId )
+{
+	int numOut = 0;
+
+	Real dist0 = normal.dot<2>( in[0].pos ) - offset;
+	Real dist1 = normal.dot<2>( in[1].pos ) - offset;
+
+	if ( dist0 <= 0.f )
+	{
+		out[numOut++] = in[0];
+	}
+
+	if ( dist1 <= 0.f )
+	{
+		out[numOut++] = in[1];
+	}
+
+	if ( dist0 * dist1 < 0.f )
+	{
+		// Segment crosses plane, vertex on the outside is replaced by intersection
+		out[numOut].pos.setInterpolate( in[0].pos, in[1].pos, dist0 / ( dist0 - dist1 ) );
+		out[numOut].id = clipId;
+		numOut++;
+	}
+
+	return numOut;
+}
+
+void physicsBoxCollider::collide( const physicsShape* shapeA, const physicsShape* shapeB, const Transform & transformA, const Transform & transformB, ContactManifold& contacts, ColliderCache* cache )
 {
 	Assert( shapeA->getType() == physicsShape::BOX, "non-box shape sent to box collider" );
 	Assert( shapeB->getType() == physicsShape::BOX, "non-box shape sent to box collider" );
 
-	// TODO: implement this
+	BoxFrame boxA, boxB;
+	boxA.set( static_cast< const physicsBoxShape* >( shapeA ), transformA );
+	boxB.set( static_cast< const physicsBoxShape* >( shapeB ), transformB );
+
+	int faceA, faceB;
+	Real separationA = findMaxSeparation( boxA, boxB, faceA );
+
+	if ( separationA > 0.f )
+	{
+		return;
+	}
+
+	Real separationB = findMaxSeparation( boxB, boxA, faceB );
+
+	if ( separationB > 0.f )
+	{
+		return;
+	}
+
+	// Prefer A's face unless B's is clearly better, so reference face doesn't flip between steps
+	const Real faceTolerance = 0.1f * g_tolerance;
+	bool flip = ( separationB > separationA + faceTolerance );
+
+	const BoxFrame& reference = flip ? boxB : boxA;
+	const BoxFrame& incident = flip ? boxA : boxB;
+	int referenceFace = flip ? faceB : faceA;
+
+	Vector4 normal = reference.getFaceNormal( referenceFace );
+	Vector4 tangent( -normal( 1 ), normal( 0 ) );
+
+	int incidentFace = findIncidentFace( incident, normal );
+
+	ClipVertex incidentVertices[2];
+	incidentVertices[0].pos = incident.getVertex( incidentFace );
+	incidentVertices[0].id = 0;
+	incidentVertices[1].pos = incident.getVertex( ( incidentFace + 1 ) & 3 );
+	incidentVertices[1].id = 1;
+
+	// Clip incident face against side planes of reference face
+	Vector4 referenceStart = reference.getVertex( referenceFace );
+	Vector4 referenceEnd = reference.getVertex( ( referenceFace + 1 ) & 3 );
+
+	ClipVertex clipped0[2], clipped1[2];
+
+	if ( clipSegment( incidentVertices, clipped0, tangent.getNegated(), -tangent.dot<2>( referenceStart ), 4 ) < 2 )
+	{
+		return;
+	}
+
+	if ( clipSegment( clipped0, clipped1, tangent, tangent.dot<2>( referenceEnd ), 5 ) < 2 )
+	{
+		return;
+	}
+
+	unsigned int faceId = ( flip ? 1u << 24 : 0u ) | ( unsigned int )referenceFace << 16 | ( unsigned int )incidentFace << 8;
+	Real frontOffset = normal.dot<2>( referenceStart );
+
+	// Normal points from A to B
+	Vector4 normalAb = flip ? normal.getNegated() : normal;
+
+	int firstContact = contacts.getNumContacts();
+
+	for ( int i = 0; i < 2; i++ )
+	{
+		Real separation = normal.dot<2>( clipped1[i].pos ) - frontOffset;
+
+		if ( separation > 0.f )
+		{
+			continue;
+		}
+
+		// Incident point is inside reference box, its projection lies on reference face
+		Vector4 onIncident = clipped1[i].pos;
+		Vector4 onReference = onIncident - normal * separation;
+
+		const Vector4& pointA = flip ? onIncident : onReference;
+		const Vector4& pointB = flip ? onReference : onIncident;
+
+		Vector4 cpInA; cpInA.setInverseRotatedPos( transformA, pointA - boxA.center );
+		Vector4 cpInB; cpInB.setInverseRotatedPos( transformB, pointB - boxB.center );
+
+		contacts.addContact( ContactPoint( -separation, cpInA, cpInB, normalAb, faceId | clipped1[i].id ) );
+	}
+
+	// Deepest first for users taking a single contact
+	if ( contacts.getNumContacts() == firstContact + 2 && contacts[firstContact + 1].getDepth() > contacts[firstContact].getDepth() )
+	{
+		std::swap( contacts[firstContact], contacts[firstContact + 1] );
+	}
 }
 
 // Convex-convex collision agent class functions
@@ -142,19 +521,30 @@ void physicsConvexCollider::getSimplexVertex( const Vector4& direction,
 											  const physicsShape* shapeB,
 											  const Transform& transformA,
 											  const Transform& transformB,
-											  SimplexVertex& simplexVertex )
+											  SimplexVertex& simplexVertex,
+											  ColliderCache* cache )
 {
-	Transform rotationA, rotationB;
-	rotationA.setRotation( transformA.getRotation() );
-	rotationB.setRotation( transformB.getRotation() );
-
+	// Rotation parts of transforms only, transposed rather than inverted
 	Vector4 dirLocalA, dirLocalB;
-	dirLocalA.setTransformedInversePos( rotationA, direction );
-	dirLocalB.setTransformedInversePos( rotationB, direction.getNegated() );
+	dirLocalA.setInverseRotatedPos( transformA, direction );
+	dirLocalB.setInverseRotatedPos( transformB, direction.getNegated() );
 
 	Vector4 supportA, supportB;
-	shapeA->getSupportingVertex( dirLocalA, supportA );
-	shapeB->getSupportingVertex( dirLocalB, supportB );
+
+	if ( cache )
+	{
+		shapeA->getSupportingVertexFrom( dirLocalA, cache->supportVertexA, supportA );
+		shapeB->getSupportingVertexFrom( dirLocalB, cache->supportVertexB, supportB );
+		simplexVertex.vertexIdxA = cache->supportVertexA;
+		simplexVertex.vertexIdxB = cache->supportVertexB;
+	}
+	else
+	{
+		shapeA->getSupportingVertex( dirLocalA, supportA );
+		shapeB->getSupportingVertex( dirLocalB, supportB );
+		simplexVertex.vertexIdxA = -1;
+		simplexVertex.vertexIdxB = -1;
+	}
 
 	Assert( supportA.isOk(), "supportA ain't ok" );
 	Assert( supportB.isOk(), "supportB ain't ok" );
@@ -217,7 +607,8 @@ void physicsConvexCollider::collide(
 	const physicsShape* shapeB,
 	const Transform& transformA,
 	const Transform& transformB,
-	std::vector<ContactPoint>& contacts )
+	ContactManifold& contacts,
+	ColliderCache* cache )
 {
     Vector4 posA = transformA.getTranslation();
     Vector4 posB = transformB.getTranslation();
@@ -230,22 +621,56 @@ void physicsConvexCollider::collide(
 	}
 
 	//direction.setNormalized( direction ); // TODO: investigate whether normalization really necessary
+
+	// Support searches climb from where the previous one ended, keep that within this call at least
+	ColliderCache localCache;
+
+	if ( !cache )
+	{
+		cache = &localCache;
+	}
 	
 	// [Simplex vertex index][0=simplex, 1=supportA, 2=supportB]
-	Simplex simplex( 3 );
+	Simplex simplex;
+	Vector4 directions[3]; // Search direction which found each simplex vertex
 
 //	drawArrow( transformA.getTranslation(), direction, RED );
 	//drawArrow( transformB.getTranslation(), direction.getNegated(), BLUE );
 
-	getSimplexVertex( direction, shapeA, shapeB, transformA, transformB, simplex[0] );
-	direction.negate();
-	getSimplexVertex( direction, shapeA, shapeB, transformA, transformB, simplex[1] );
+	if ( cache && cache->hasSimplex )
+	{
+		// Bodies barely moved since last step, last simplex edge starts out close to the closest edge
+		directions[0] = cache->simplexDirections[0];
+		directions[1] = cache->simplexDirections[1];
+	}
+	else
+	{
+		directions[0] = direction;
+		directions[1] = direction.getNegated();
+	}
+
+	getSimplexVertex( directions[0], shapeA, shapeB, transformA, transformB, simplex[0], cache );
+	getSimplexVertex( directions[1], shapeA, shapeB, transformA, transformB, simplex[1], cache );
+
+	if ( simplex[0][0] == simplex[1][0] )
+	{
+		// Cached directions found the same vertex, search the opposite way like a cold start
+		directions[1] = directions[0].getNegated();
+		getSimplexVertex( directions[1], shapeA, shapeB, transformA, transformB, simplex[1], cache );
+	}
 //	drawCross( simplex[0][1], 45.f * g_degToRad, 30.f, RED );
 	//drawCross( simplex[0][2], 45.f * g_degToRad, 30.f, BLUE );
 
 	const Vector4 origin( 0.f, 0.f );
 	
-	physicsCd::calcClosestPointOnLine( simplex[0][0], simplex[1][0], origin, direction );
+	if ( simplex[0][0] == simplex[1][0] )
+	{
+		direction = simplex[0][0];
+	}
+	else
+	{
+		physicsCd::calcClosestPointOnLine( simplex[0][0], simplex[1][0], origin, direction );
+	}
 
 	// TODO: find out appropriate eps
 	// float eps = sqrt(std::numeric_limits<float>::epsilon());
@@ -258,6 +683,7 @@ void physicsConvexCollider::collide(
 		if ( direction.isZero() )
 		{
 			// Origin is on the simplex
+			storeSimplexDirections( directions, cache );
 			return;
 		}
 
@@ -265,7 +691,8 @@ void physicsConvexCollider::collide(
 		//direction.setNormalized( direction );
 
 		// Get third simplex triangle vertex
-		getSimplexVertex( direction, shapeA, shapeB, transformA, transformB, simplex[2] );
+		directions[2] = direction;
+		getSimplexVertex( direction, shapeA, shapeB, transformA, transformB, simplex[2], cache );
 
 #if defined D_GJK_SIMPLEX
 		//DebugUtils::drawSimplex( simplex );
@@ -285,8 +712,14 @@ void physicsConvexCollider::collide(
 			vo.setNegate( simplex[2][0] );
 			bool l20 = ( edge20( 0 )*vo( 1 ) - edge20( 1 )*vo( 0 ) ) > 0;
 
-			if ( l01 == l12 && l12 == l20 )
+			// Flat triangle encloses nothing, vertices can all coincide once simplex collapses onto a vertex
+			bool flat = ( edge01( 0 )*edge12( 1 ) - edge01( 1 )*edge12( 0 ) ) == 0.f;
+
+			if ( l01 == l12 && l12 == l20 && !flat )
 			{
+				// Edge [0], [1] finds the third vertex again next step if bodies barely move
+				storeSimplexDirections( directions, cache );
+
 				break;
 			}
 		}
@@ -296,6 +729,8 @@ void physicsConvexCollider::collide(
 
 		if ( dc - da < eps )
         {
+			storeSimplexDirections( directions, cache );
+
 			// Converged on closest feature on simplex
 			Vector4 L = simplex[1][0] - simplex[0][0];
 
@@ -352,16 +787,14 @@ void physicsConvexCollider::collide(
 
 		if ( closest02.dot<2>( closest02 ) < closest21.dot<2>( closest21 ) )
 		{
-			simplex[1][0] = simplex[2][0];
-			simplex[1][1] = simplex[2][1];
-			simplex[1][2] = simplex[2][2];
+			simplex[1] = simplex[2];
+			directions[1] = directions[2];
 			direction = closest02;
 		}
 		else
 		{
-			simplex[0][0] = simplex[2][0];
-			simplex[0][1] = simplex[2][1];
-			simplex[0][2] = simplex[2][2];
+			simplex[0] = simplex[2];
+			directions[0] = directions[2];
 			direction = closest21;
 		}
 #if 0
@@ -380,34 +813,44 @@ void physicsConvexCollider::collide(
 	DebugUtils::drawMinkowskiDifference( shapeA, shapeB, transformA, transformB );
 #endif
 
+	{
+		// Polytope expansion expects counter-clockwise winding, triangle can come out of GJK in either
+		Vector4 edge01; edge01.setSub( simplex[1][0], simplex[0][0] );
+		Vector4 edge02; edge02.setSub( simplex[2][0], simplex[0][0] );
+
+		if ( edge01( 0 )*edge02( 1 ) - edge01( 1 )*edge02( 0 ) < 0.f )
+		{
+			std::swap( simplex[0], simplex[1] );
+		}
+	}
+
+	Polytope polytope( simplex );
 	SimplexEdge closestEdge;
-	expandingPolytopeAlgorithm( shapeA, shapeB, transformA, transformB, simplex, closestEdge );
 
-	// Determine closest point on simplex edge
-	const size_t szSimplex = simplex.size();
-	int closestIdx = closestEdge.index;
-	auto previousIdx = closestIdx == 0 ? szSimplex - 1 : closestIdx - 1;
-	
-	// Todo: Find out why two same vertices exist in simplex
-	Vector4 L = simplex[closestIdx][0] - simplex[previousIdx][0];
-	//drawArrow( simplex[previousIdx][0], L, PURPLE );
-	//drawCross( simplex[previousIdx][0], 30.f * g_degToRad, 50.f, RED );
-	//drawCross( simplex[closestIdx][0], 30.f * g_degToRad, 50.f, BLUE );
-	
-	if ( L.isZero() )
+	if ( !expandingPolytopeAlgorithm( shapeA, shapeB, transformA, transformB, polytope, closestEdge, cache ) )
 	{
+		// Simplex collapsed onto a point, no edge to take a normal from
 		return;
 	}
+
+	// Determine closest point on simplex edge, edges made of a repeated vertex never get picked
+	int startIdx = closestEdge.start;
+	int endIdx = closestEdge.end;
+
+	Vector4 L = polytope[endIdx][0] - polytope[startIdx][0];
+	//drawArrow( polytope[startIdx][0], L, PURPLE );
+	//drawCross( polytope[startIdx][0], 30.f * g_degToRad, 50.f, RED );
+	//drawCross( polytope[endIdx][0], 30.f * g_degToRad, 50.f, BLUE );
 	
-	Real l = -1.f * simplex[previousIdx][0].dot<2>( L ) / L.dot<2>( L );
+	Real l = -1.f * polytope[startIdx][0].dot<2>( L ) / L.dot<2>( L );
 	
 	Vector4 pointA, pointB;
-	pointA.setInterpolate( simplex[previousIdx][1], simplex[closestIdx][1], l );
-	pointB.setInterpolate( simplex[previousIdx][2], simplex[closestIdx][2], l );
+	pointA.setInterpolate( polytope[startIdx][1], polytope[endIdx][1], l );
+	pointB.setInterpolate( polytope[startIdx][2], polytope[endIdx][2], l );
 	//drawCross( pointA, 30.f * g_degToRad, 50.f, RED );
 	// Must be directed from A to B because penetration
 	Vector4 normal = closestEdge.normal;
-	normal *= closestEdge.distSq;
+	normal *= closestEdge.dist;
 	
 	if ( normal.isZero() )
 	{
@@ -419,151 +862,159 @@ void physicsConvexCollider::collide(
 	//DebugUtils::drawContactNormal( pointA, normal );
 #endif
 	
-	Transform rotationA, rotationB;
-	rotationA.setRotation( transformA.getRotation() );
-	rotationB.setRotation( transformB.getRotation() );
-	
-	Vector4 cpInA; cpInA.setTransformedInversePos( rotationA, pointA - posA );
-	Vector4 cpInB; cpInB.setTransformedInversePos( rotationB, pointB - posB );
-	
-	ContactPoint contact( normal.length<2>(), cpInA, cpInB, normal );
-	
-	contacts.push_back( contact );
+	Vector4 cpInA; cpInA.setInverseRotatedPos( transformA, pointA - posA );
+	Vector4 cpInB; cpInB.setInverseRotatedPos( transformB, pointB - posB );
 	
-	// Detect planar contacts
-	Transform t;
-	const float pt = 15.f * g_degToRad;
-	t.setRotation( pt );
-
-	Vector4 d1, d2;
-	d1.setTransformedPos( t, closestEdge.normal );
-	d2.setTransformedInversePos( t, closestEdge.normal );
+	ContactPoint contact( normal.length<2>(), cpInA, cpInB, normal, getFeatureId( polytope[startIdx], polytope[endIdx] ) );
 	
-	SimplexVertex newSimplexVertex1, newSimplexVertex2;
-	getSimplexVertex( d1, shapeA, shapeB, transformA, transformB, newSimplexVertex1 );
-	getSimplexVertex( d2, shapeA, shapeB, transformA, transformB, newSimplexVertex2 );
-
-	//drawCross( newSimplexVertex1[1], 30.f * g_degToRad, 50.f, BLUE );
-	//drawCross( newSimplexVertex1[2], 45.f * g_degToRad, 50.f, BLUE );
-	//drawArrow( newSimplexVertex1[0] - d2 * 50.f, d2 * 50.f, BLUE );
-	//drawCross( newSimplexVertex2[1], 60.f * g_degToRad, 50.f, RED );
-	//drawCross( newSimplexVertex2[2], 75.f * g_degToRad, 50.f, RED );
-	//drawArrow( newSimplexVertex2[0] - d2 * 50.f, d2 * 50.f, RED );
-	// Determine closest point on simplex edge
-	const size_t szSimplexx = simplex.size();
-	auto ii = closestEdge.index == 0 ? szSimplexx - 1 : closestEdge.index - 1;
-	//drawCross( simplex[ii][0], 45.f * g_degToRad, 50.f, GREEN );
-	//drawCross( simplex[ii][1], 45.f * g_degToRad, 50.f, GREEN );
-	//drawCross( simplex[ii][2], 45.f * g_degToRad, 50.f, GREEN );
-	{
-		// Determine closest point on simplex edge
-		const size_t szSimplex = simplex.size();
-		auto i = closestEdge.index == 0 ? szSimplex - 1 : closestEdge.index - 1;
-
-		// Todo: Find out why two same vertices exist in simplex
-		Vector4 L = newSimplexVertex1[0] - simplex[i][0];
-		//drawArrow( simplex[i][0], L, BLUE );
-		if ( L.isZero() )
-		{
-			return;
-		}
-
-		Real l = -1.f * simplex[i][0].dot<2>( L ) / L.dot<2>( L );
-
-		Vector4 pointA, pointB;
-		pointA.setInterpolate( simplex[i][1], newSimplexVertex1[1], l );
-		pointB.setInterpolate( simplex[i][2], newSimplexVertex1[2], l );
-		//drawCross(pointA, 30.f * g_degToRad, 50.f, BLUE);
-		//drawCross(pointB, 60.f * g_degToRad, 50.f, BLUE);
-	}
+	contacts.addContact( contact );
+}
 
+void physicsConvexCollider::storeSimplexDirections( const Vector4 directions[3], ColliderCache* cache )
+{
+	if ( cache )
 	{
-		// Determine closest point on simplex edge
-		const size_t szSimplex = simplex.size();
-		int i = closestEdge.index == 0 ? szSimplex - 1 : closestEdge.index - 1;
-
-		// Todo: Find out why two same vertices exist in simplex
-		Vector4 L = newSimplexVertex2[0] - simplex[i][0];
-		//drawArrow( simplex[i][0], L, RED );
-		if ( L.isZero() )
-		{
-			return;
-		}
-
-		Real l = -1.f * simplex[i][0].dot<2>( L ) / L.dot<2>( L );
-
-		Vector4 pointA, pointB;
-		pointA.setInterpolate( simplex[i][1], newSimplexVertex2[1], l );
-		pointB.setInterpolate( simplex[i][2], newSimplexVertex2[2], l );
-		//drawCross(pointA, 30.f * g_degToRad, 50.f, RED);
-		//drawCross(pointB, 60.f * g_degToRad, 50.f, RED);
+		cache->simplexDirections[0] = directions[0];
+		cache->simplexDirections[1] = directions[1];
+		cache->hasSimplex = true;
 	}
 }
 
-void physicsConvexCollider::expandingPolytopeAlgorithm(
+bool physicsConvexCollider::expandingPolytopeAlgorithm(
 	const physicsShape* shapeA,
 	const physicsShape* shapeB,
 	const Transform& transformA,
 	const Transform& transformB,
-	Simplex& simplex,
-	SimplexEdge& closestEdge)
+	Polytope& polytope,
+	SimplexEdge& closestEdge,
+	ColliderCache* cache )
 {	
-	//int idx = 0;
+	//DebugUtils::drawSimplex( polytope, RED );
+
+	EdgeHeap heap;
+
+	for ( int i = 0; i < polytope.size(); i++ )
+	{
+		SimplexEdge edge;
+
+		if ( makeEdge( polytope, i, edge ) )
+		{
+			heap.push( edge );
+		}
+	}
 
-	//DebugUtils::drawSimplex( simplex, RED );
+	if ( heap.isEmpty() )
+	{
+		return false;
+	}
 
 	while ( true )
 	{
-		// TODO: investigate not being able to get out of loop in some collisions
-		getClosestEdgeToOrigin( simplex, closestEdge );
+		closestEdge = heap.top();
 
 		SimplexVertex newSimplexVertex;
-		getSimplexVertex( closestEdge.normal, shapeA, shapeB, transformA, transformB, newSimplexVertex );
+		getSimplexVertex( closestEdge.normal, shapeA, shapeB, transformA, transformB, newSimplexVertex, cache );
+
+		// Support found again at an end of the edge means the edge is on the Minkowski difference's hull.
+		// Checked apart from the tolerance so such a vertex never goes in twice
+		if ( newSimplexVertex[0] == polytope[closestEdge.start][0] || newSimplexVertex[0] == polytope[closestEdge.end][0] )
+		{
+			break;
+		}
 
 		Real dist = newSimplexVertex[0].dot<2>( closestEdge.normal );
 		
-		if ( dist - closestEdge.distSq < g_tolerance )
+		if ( dist - closestEdge.dist < g_tolerance )
 		{ 
 			// Convergence, closest edge determined
 			break;
 		}
-		else
+
+		if ( polytope.isFull() )
 		{
-			// Expand simplex
-			Simplex::iterator iter = simplex.begin();
-			simplex.insert( iter + closestEdge.index, newSimplexVertex );
-			//drawText( std::to_string( idx ), newSimplexVertex[0], 1.f );
-			//idx++;
+			// Out of room, closest edge so far is the answer
+			break;
+		}
+
+		// Expand polytope, closest edge is replaced by its two halves
+		heap.pop();
+		int newIdx = polytope.split( closestEdge.start, newSimplexVertex );
+
+		SimplexEdge edge;
+
+		if ( makeEdge( polytope, closestEdge.start, edge ) )
+		{
+			heap.push( edge );
+		}
+
+		if ( makeEdge( polytope, newIdx, edge ) )
+		{
+			heap.push( edge );
+		}
+
+		if ( heap.isEmpty() )
+		{
+			return false;
 		}
 	}
 
 #if defined D_EPA_SIMPLEX
-	DebugUtils::drawSimplex( simplex, BLUE );
+	DebugUtils::drawSimplex( polytope, BLUE );
 #endif
+
+	return true;
 }
 
-void physicsConvexCollider::getClosestEdgeToOrigin( const Simplex& simplex, SimplexEdge& edge )
+unsigned int physicsConvexCollider::getFeatureId( const SimplexVertex& start, const SimplexVertex& end )
 {
-	edge.distSq = std::numeric_limits<Real>::max();
-	int szSimplex = (int)simplex.size();
+	int idx[4] = { start.vertexIdxA, end.vertexIdxA, start.vertexIdxB, end.vertexIdxB };
 
-	for ( int i = 0; i < szSimplex; i++ )
+	for ( int i = 0; i < 4; i++ )
 	{
-		int j = ( i + 1 ) % szSimplex;
+		if ( idx[i] < 0 || idx[i] > 0xff )
+		{
+			return ContactPoint::INVALID_FEATURE_ID;
+		}
+	}
 
-		Vector4 edgeCw = simplex[j][0] - simplex[i][0];
+	return ( std::min( idx[0], idx[1] ) << 24 ) | ( std::max( idx[0], idx[1] ) << 16 ) | ( std::min( idx[2], idx[3] ) << 8 ) | std::max( idx[2], idx[3] );
+}
 
-		// Get vector from origin to edge, which is direction we want to expand to
-		Vector4 n( edgeCw( 1 ), -1.f * edgeCw( 0 ) );
-		n.normalize<2>();
+bool physicsConvexCollider::makeEdge( const Polytope& polytope, const int start, SimplexEdge& edge )
+{
+	int end = polytope.next[start];
 
-		Real len = n.dot<2>( simplex[i][0] );
+	Vector4 edgeCcw = polytope[end][0] - polytope[start][0];
 
-		if ( len < edge.distSq )
-		{
-			edge.distSq = len;
-			edge.normal = n;
-			edge.index = j;
-		}
+	if ( edgeCcw.isZero() )
+	{
+		return false;
 	}
+
+	// Outward normal of counter-clockwise edge, direction we want to expand to
+	edge.start = start;
+	edge.end = end;
+	edge.normal.set( edgeCcw( 1 ), -1.f * edgeCcw( 0 ) );
+	edge.normal.normalize<2>();
+	edge.dist = edge.normal.dot<2>( polytope[start][0] );
+
+	return true;
+}
+
+static bool edgeFurther( const physicsConvexCollider::SimplexEdge& a, const physicsConvexCollider::SimplexEdge& b )
+{
+	return a.dist > b.dist;
+}
+
+void physicsConvexCollider::EdgeHeap::push( const SimplexEdge& edge )
+{
+	Assert( size < Polytope::CAPACITY, "edge heap capacity exceeded" );
+	edges[size++] = edge;
+	std::push_heap( edges, edges + size, edgeFurther );
+}
+
+void physicsConvexCollider::EdgeHeap::pop()
+{
+	std::pop_heap( edges, edges + size, edgeFurther );
+	size--;
 }
\ No newline at end of file
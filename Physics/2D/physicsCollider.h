@@ -6,6 +6,11 @@
 
 #include <vector>
 #include <array>
+#include <algorithm>
+
+class physicsShape;
+class physicsBoxShape;
+class physicsConvexShape;
 
 struct ContactPoint
 {
@@ -15,20 +20,73 @@ private:
 	Vector4 m_posA; // Contact on A seen by A
 	Vector4 m_posB; // Contact on B seen by B
 	Vector4 m_norm; // Point from bodyA to bodyB
+	unsigned int m_featureId; // Identifies features which produced contact, same between steps while they touch
 
 public:
 
+	// Contact can't be matched to last step's, it starts without accumulated impulses
+	static const unsigned int INVALID_FEATURE_ID = 0xffffffff;
+
 	ContactPoint()
-		: m_depth( 0.f ), m_posA(), m_posB(), m_norm() {}
+		: m_depth( 0.f ), m_posA(), m_posB(), m_norm(), m_featureId( 0 ) {}
 
-	ContactPoint( Real depth, const Vector4& posA, const Vector4& posB, const Vector4& norm )
-		: m_depth( depth ), m_posA( posA ), m_posB( posB ), m_norm( norm ) {}
+	ContactPoint( Real depth, const Vector4& posA, const Vector4& posB, const Vector4& norm, const unsigned int featureId = 0 )
+		: m_depth( depth ), m_posA( posA ), m_posB( posB ), m_norm( norm ), m_featureId( featureId ) {}
 
 	inline const Real getDepth() const { return m_depth; }
 	inline const Vector4& getContactA() const { return m_posA; }
 	inline const Vector4& getContactB() const { return m_posB; }
 	inline const Vector4& getNormal() const { return m_norm; }
+	inline unsigned int getFeatureId() const { return m_featureId; }
+
+	// Swaps roles of bodies A and B
+	inline void flip() { std::swap( m_posA, m_posB ); m_norm.negate(); }
+
+};
+
+// Contacts colliders write out for a pair, fixed capacity so it can live on the stack without allocating
+struct ContactManifold
+{
+	enum { MAX_CONTACTS = 2 };
+
+private:
+
+	ContactPoint m_contacts[MAX_CONTACTS];
+	int m_numContacts;
+
+public:
+
+	ContactManifold() : m_numContacts( 0 ) {}
+
+	inline int getNumContacts() const { return m_numContacts; }
+	inline bool isEmpty() const { return m_numContacts == 0; }
+
+	inline ContactPoint& operator[]( const int i ) { return m_contacts[i]; }
+	inline const ContactPoint& operator[]( const int i ) const { return m_contacts[i]; }
+
+	inline void addContact( const ContactPoint& cp )
+	{
+		Assert( m_numContacts < MAX_CONTACTS, "contact manifold overflow" );
+		m_contacts[m_numContacts++] = cp;
+	}
+
+	inline void clear() { m_numContacts = 0; }
+};
+
+// Per pair state kept by colliders between steps, owned by the world's pair cache.
+// Shapes are in the order collider receives them
+struct ColliderCache
+{
+	// Search directions of last GJK simplex edge, supports along them seed next step's simplex.
+	// Supports are searched again rather than reused so every simplex vertex stays on the Minkowski difference's hull
+	Vector4 simplexDirections[2];
+	bool hasSimplex;
+
+	// Hull positions supports on A and B were last found at, convex shapes climb from there on the next query
+	int supportVertexA;
+	int supportVertexB;
 
+	ColliderCache() : hasSimplex( false ), supportVertexA( 0 ), supportVertexB( 0 ) {}
 };
 
 namespace ContactPointUtils
@@ -44,6 +102,7 @@ public:
 	{
 		CIRCLE_CIRCLE = 0,
 		CIRCLE_BOX,
+		CIRCLE_CONVEX,
 		BOX_BOX,
 		CONVEX_CONVEX,
 		NUM_COLLIDERS
@@ -57,7 +116,7 @@ public:
 						 const std::shared_ptr<physicsShape>& shapeB,
 						 const Transform& transformA,
 						 const Transform& transformB,
-						 std::vector<ContactPoint>& contacts );
+						 ContactManifold& contacts );
 };
 
 class physicsCircleCollider : public physicsCollider
@@ -72,7 +131,8 @@ public:
 						 const physicsShape* shapeB,
 						 const Transform& transformA,
 						 const Transform& transformB,
-						 std::vector<ContactPoint>& contacts );
+						 ContactManifold& contacts,
+						 ColliderCache* cache = nullptr );
 };
 
 class physicsCircleBoxCollider : public physicsCollider
@@ -87,9 +147,30 @@ public:
 						 const physicsShape* shapeB,
 						 const Transform& transformA,
 						 const Transform& transformB,
-						 std::vector<ContactPoint>& contacts );
+						 ContactManifold& contacts,
+						 ColliderCache* cache = nullptr );
+};
+
+// Closest feature of polygon to circle center, found from the face of largest separation and its end vertices.
+// One contact, feature Id is the face, or number of faces + vertex if center lies past the end of the face
+class physicsCircleConvexCollider : public physicsCollider
+{
+private:
+
+	physicsCircleConvexCollider();
+
+public:
+
+	static void collide( const physicsShape* shapeA,
+						 const physicsShape* shapeB,
+						 const Transform& transformA,
+						 const Transform& transformB,
+						 ContactManifold& contacts,
+						 ColliderCache* cache = nullptr );
 };
 
+// Separating axis test over the four face normals, incident face is clipped against reference face.
+// Up to two contacts, feature Id packs reference face, incident face and which vertex or side plane made the point
 class physicsBoxCollider : public physicsCollider
 {
 private:
@@ -102,7 +183,40 @@ public:
 						 const physicsShape* shapeB,
 						 const Transform& transformA,
 						 const Transform& transformB,
-						 std::vector<ContactPoint>& contacts );
+						 ContactManifold& contacts,
+						 ColliderCache* cache = nullptr );
+
+	// Box in world space, faces are numbered +x, +y, -x, -y in box space.
+	// Vertices are numbered counter-clockwise from +x-y, face i runs from vertex i to i + 1
+	struct BoxFrame
+	{
+		Vector4 center;
+		Vector4 axes[2];
+		Real halfExtents[2];
+
+		void set( const physicsBoxShape* box, const Transform& transform );
+
+		Vector4 getFaceNormal( const int face ) const { return ( face & 2 ) ? axes[face & 1].getNegated() : axes[face & 1]; }
+
+		Vector4 getVertex( const int vertex ) const;
+	};
+
+protected:
+
+	struct ClipVertex
+	{
+		Vector4 pos;
+		unsigned int id; // Incident vertex, or 4 + side plane if point was clipped
+	};
+
+	// Largest separation of boxB from faces of boxA, positive if separated
+	static Real findMaxSeparation( const BoxFrame& boxA, const BoxFrame& boxB, int& faceOut );
+
+	// Face of box whose normal points most against normal
+	static int findIncidentFace( const BoxFrame& box, const Vector4& normal );
+
+	// Keeps part of segment in on negative side of plane, returns number of vertices out
+	static int clipSegment( const ClipVertex in[2], ClipVertex out[2], const Vector4& normal, const Real offset, const unsigned int clipId );
 };
 
 
@@ -111,23 +225,89 @@ class physicsConvexCollider: public physicsCollider
 {
 public:
 	
-	typedef std::array<Vector4, 3> SimplexVertex; // [0] = vertex, [1] = supportA, [2] = supportB
-	typedef std::vector<SimplexVertex> Simplex;
+	// [0] = vertex, [1] = supportA, [2] = supportB.
+	// Hull positions of the supports identify contact features, -1 if shape has no vertex list
+	struct SimplexVertex : public std::array<Vector4, 3>
+	{
+		int vertexIdxA;
+		int vertexIdxB;
 
+		SimplexVertex() : vertexIdxA( -1 ), vertexIdxB( -1 ) {}
+	};
+
+	typedef std::array<SimplexVertex, 3> Simplex; // GJK triangle
+
+	// EPA vertices stored inline, starts as the GJK triangle and grows up to capacity.
+	// Vertices stay at the index they were added at and are linked counter-clockwise, edge i runs from i to next[i]
+	struct Polytope
+	{
+		enum { CAPACITY = 32 };
+
+		SimplexVertex vertices[CAPACITY];
+		int next[CAPACITY];
+		int numVertices;
+
+		Polytope( const Simplex& simplex ) : numVertices( 3 )
+		{
+			std::copy( simplex.begin(), simplex.end(), vertices );
+			next[0] = 1;
+			next[1] = 2;
+			next[2] = 0;
+		}
+
+		int size() const { return numVertices; }
+		bool isFull() const { return numVertices == CAPACITY; }
+
+		SimplexVertex& operator[]( const int i ) { return vertices[i]; }
+		const SimplexVertex& operator[]( const int i ) const { return vertices[i]; }
+
+		// Inserts vertex between edge's ends, returns its index
+		int split( const int edgeStart, const SimplexVertex& vertex )
+		{
+			Assert( !isFull(), "polytope capacity exceeded" );
+			vertices[numVertices] = vertex;
+			next[numVertices] = next[edgeStart];
+			next[edgeStart] = numVertices;
+			return numVertices++;
+		}
+	};
+
+	// Polytope edge, distance and outward normal are computed once when edge is made
 	struct SimplexEdge
 	{
-		int index;
-		Real distSq;
+		int start;
+		int end;
+		Real dist; // From origin along normal
 		Vector4 normal;
 	};
 
-	// Finds simplex vertex and it's support vertices local to A
+	// Binary min-heap of polytope edges keyed on distance, every edge of the polytope is in it once.
+	// Splitting an edge replaces it with two, so it never holds more edges than polytope has vertices
+	struct EdgeHeap
+	{
+		SimplexEdge edges[Polytope::CAPACITY];
+		int size;
+
+		EdgeHeap() : size( 0 ) {}
+
+		bool isEmpty() const { return size == 0; }
+
+		const SimplexEdge& top() const { return edges[0]; }
+
+		void push( const SimplexEdge& edge );
+
+		void pop();
+	};
+
+	// Finds simplex vertex and it's support vertices local to A.
+	// Support searches start from and update cache's support vertices if given
 	static void getSimplexVertex( const Vector4& direction,
 								  const physicsShape* shapeA,
 								  const physicsShape* shapeB,
 								  const Transform& transformA,
 								  const Transform& transformB,
-								  SimplexVertex& simplexVert );
+								  SimplexVertex& simplexVert,
+								  ColliderCache* cache = nullptr );
 
 private:
 
@@ -135,14 +315,25 @@ private:
 	physicsConvexCollider();
 
 
-	static void expandingPolytopeAlgorithm( const physicsShape* shapeA,
+	// Returns false if polytope has no edge to expand, which happens when all of its vertices coincide
+	static bool expandingPolytopeAlgorithm( const physicsShape* shapeA,
 											const physicsShape* shapeB,
 											const Transform& transformA,
 											const Transform& transformB,
-											Simplex& simplex,
-											struct SimplexEdge& closestEdge );
+											Polytope& polytope,
+											struct SimplexEdge& closestEdge,
+											ColliderCache* cache );
+
+	// Computes edge from start to its next vertex. Returns false if both ends are the same point,
+	// such an edge adds nothing to the polytope's outline and is left out of the heap
+	static bool makeEdge( const Polytope& polytope, const int start, SimplexEdge& edge );
+
+	// Packs hull positions of supports at the ends of closest EPA edge, ends in either order give same id.
+	// Returns invalid id if a shape has no vertex list or too many vertices to pack
+	static unsigned int getFeatureId( const SimplexVertex& start, const SimplexVertex& end );
 
-	static void getClosestEdgeToOrigin( const Simplex& simplex, struct SimplexEdge& edge );
+	// Keeps directions of simplex edge [0], [1] for next step, cache can be null
+	static void storeSimplexDirections( const Vector4 directions[3], ColliderCache* cache );
 
 public:
 
@@ -150,5 +341,6 @@ public:
 						 const physicsShape* shapeB,
 						 const Transform& transformA,
 						 const Transform& transformB,
-						 std::vector<ContactPoint>& contacts );
+						 ContactManifold& contacts,
+						 ColliderCache* cache = nullptr );
 };
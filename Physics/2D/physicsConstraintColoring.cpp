@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include <physicsConstraintColoring.h>
+
+physicsConstraintColoring::physicsConstraintColoring() :
+	m_numColors( 0 ),
+	m_colorStarts( 2, 0 )
+{
+
+}
+
+physicsConstraintColoring::~physicsConstraintColoring()
+{
+
+}
+
+static inline bool isStaticSolverBody( const SolverBody& body )
+{
+	return body.mInv == 0.f && body.iInv == 0.f;
+}
+
+void physicsConstraintColoring::build( const std::vector<ConstrainedPair>& pairs, const std::vector<SolverBody>& bodies )
+{
+	int numPairs = ( int )pairs.size();
+
+	m_pairColors.resize( numPairs );
+	m_pairIndices.resize( numPairs );
+	m_bodyColors.resize( bodies.size(), 0 );
+
+	// Greedy coloring, counting pairs per color
+	int colorCounts[MAX_COLORS + 1] = { 0 };
+
+	for ( int i = 0; i < numPairs; i++ )
+	{
+		const ConstrainedPair& pair = pairs[i];
+		bool isStaticA = isStaticSolverBody( bodies[pair.bodyIdA] );
+		bool isStaticB = isStaticSolverBody( bodies[pair.bodyIdB] );
+
+		unsigned long long usedColors = ( isStaticA ? 0 : m_bodyColors[pair.bodyIdA] ) | ( isStaticB ? 0 : m_bodyColors[pair.bodyIdB] );
+		int color = 0;
+
+		while ( color < MAX_COLORS && ( usedColors & ( 1ull << color ) ) )
+		{
+			color++;
+		}
+
+		if ( color < MAX_COLORS )
+		{
+			unsigned long long colorBit = 1ull << color;
+
+			if ( !isStaticA )
+			{
+				m_bodyColors[pair.bodyIdA] |= colorBit;
+			}
+
+			if ( !isStaticB )
+			{
+				m_bodyColors[pair.bodyIdB] |= colorBit;
+			}
+		}
+
+		m_pairColors[i] = color;
+		colorCounts[color]++;
+	}
+
+	// Colors are used from the lowest, so used ones are already at the front
+	m_numColors = 0;
+
+	while ( m_numColors < MAX_COLORS && colorCounts[m_numColors] > 0 )
+	{
+		m_numColors++;
+	}
+
+	m_colorStarts.resize( MAX_COLORS + 2 );
+	m_colorStarts[0] = 0;
+
+	for ( int color = 0; color < m_numColors; color++ )
+	{
+		m_colorStarts[color + 1] = m_colorStarts[color] + colorCounts[color];
+	}
+
+	m_colorStarts[m_numColors + 1] = m_colorStarts[m_numColors] + colorCounts[OVERFLOW_COLOR];
+
+	// Counting sort keeps pair order inside colors
+	int fill[MAX_COLORS + 1];
+	std::copy( m_colorStarts.begin(), m_colorStarts.begin() + m_numColors + 1, fill );
+
+	for ( int i = 0; i < numPairs; i++ )
+	{
+		int color = m_pairColors[i];
+		int slot = ( color == OVERFLOW_COLOR ) ? m_numColors : color;
+		m_pairIndices[fill[slot]++] = i;
+	}
+
+	// Only touched bodies need clearing
+	for ( int i = 0; i < numPairs; i++ )
+	{
+		m_bodyColors[pairs[i].bodyIdA] = 0;
+		m_bodyColors[pairs[i].bodyIdB] = 0;
+	}
+}
+
+void physicsConstraintColoring::getColorRange( const int colorIdx, int& startOut, int& endOut ) const
+{
+	Assert( colorIdx >= 0 && colorIdx <= m_numColors, "color out of range" );
+
+	startOut = m_colorStarts[colorIdx];
+	endOut = m_colorStarts[colorIdx + 1];
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#include <physicsSolver.h>
+
+// Splits constrained pairs into colors where no two pairs share a dynamic body, so pairs of a color can be solved in parallel.
+// Pairs are colored greedily in order, each takes the lowest color neither of its bodies is in yet. Static bodies are only
+// read by solver and don't conflict. Pairs keep their relative order inside a color, so results only depend on pair order.
+// Pairs which find no free color go to an overflow range, which has to be solved by a single thread after the colors
+class physicsConstraintColoring
+{
+public:
+
+	enum { MAX_COLORS = 64 }; // Bits of a body's color mask
+
+	physicsConstraintColoring();
+
+	~physicsConstraintColoring();
+
+	// Bodies are indexed by body Id, ones with zero inverse mass and inertia count as static
+	void build( const std::vector<ConstrainedPair>& pairs, const std::vector<SolverBody>& bodies );
+
+	// Colors are [0, getNumColors()), range of color getNumColors() is the overflow
+	int getNumColors() const { return m_numColors; }
+
+	bool hasOverflow() const { return m_colorStarts[m_numColors + 1] > m_colorStarts[m_numColors]; }
+
+	// Range of color in getPairIndices()
+	void getColorRange( const int colorIdx, int& startOut, int& endOut ) const;
+
+	// Indices into pairs given to build, grouped by color
+	const std::vector<int>& getPairIndices() const { return m_pairIndices; }
+
+protected:
+
+	enum { OVERFLOW_COLOR = MAX_COLORS };
+
+	int m_numColors;
+	std::vector<int> m_pairColors; // Per pair
+	std::vector<int> m_pairIndices;
+	std::vector<int> m_colorStarts; // MAX_COLORS + 2 entries, used colors are packed to the front and overflow follows them
+	std::vector<unsigned long long> m_bodyColors; // Per body Id, bit is set for colors body is in, cleared after build
+};
@@ -0,0 +1,195 @@
+#include <physicsContactBatch.h>
+#include <physicsConstraintColoring.h>
+
+physicsContactBatch::physicsContactBatch()
+{
+
+}
+
+physicsContactBatch::~physicsContactBatch()
+{
+
+}
+
+void physicsContactBatch::build( const SolverInfo& info,
+								 const physicsConstraintColoring& coloring,
+								 const std::vector<ConstrainedPair>& pairs,
+								 const std::vector<SolverBody>& bodies )
+{
+	const std::vector<int>& pairIndices = coloring.getPairIndices();
+	int numColors = coloring.getNumColors();
+
+	m_blocks.clear();
+	m_colorStarts.clear();
+
+	for ( int colorIdx = 0; colorIdx <= numColors; colorIdx++ )
+	{
+		m_colorStarts.push_back( ( int )m_blocks.size() );
+
+		int start, end;
+		coloring.getColorRange( colorIdx, start, end );
+
+		// Overflow pairs may share bodies with each other
+		int lanesPerBlock = ( colorIdx < numColors ) ? WIDTH : 1;
+
+		for ( int i = start; i < end; i += lanesPerBlock )
+		{
+			// Padding lanes are left zeroed
+			m_blocks.push_back( Block() );
+			Block& block = m_blocks.back();
+
+			for ( int lane = 0; lane < WIDTH; lane++ )
+			{
+				block.pairIdx[lane] = -1;
+			}
+
+			for ( int lane = 0; lane < lanesPerBlock && i + lane < end; lane++ )
+			{
+				int pairIdx = pairIndices[i + lane];
+				setLane( block, lane, pairIdx, info, pairs[pairIdx], bodies );
+			}
+		}
+	}
+
+	m_colorStarts.push_back( ( int )m_blocks.size() );
+}
+
+void physicsContactBatch::setLane( Block& block, const int lane, const int pairIdx, const SolverInfo& info,
+								   const ConstrainedPair& pair, const std::vector<SolverBody>& bodies )
+{
+	const std::vector<Constraint>& constraints = pair.constraints;
+	Assert( constraints.size() <= MAX_ROWS, "contact pair has too many constraints for batch" );
+
+	const SolverBody& bodyA = bodies[pair.bodyIdA];
+	const SolverBody& bodyB = bodies[pair.bodyIdB];
+
+	block.pairIdx[lane] = pairIdx;
+	block.bodyIdA[lane] = pair.bodyIdA;
+	block.bodyIdB[lane] = pair.bodyIdB;
+	block.mInvA[lane] = bodyA.mInv;
+	block.iInvA[lane] = bodyA.iInv;
+	block.mInvB[lane] = bodyB.mInv;
+	block.iInvB[lane] = bodyB.iInv;
+	block.friction[lane] = pair.friction;
+
+	for ( int rowIdx = 0; rowIdx < ( int )constraints.size(); rowIdx++ )
+	{
+		const Constraint& constraint = constraints[rowIdx];
+		const Jacobian& jac = constraint.jac;
+		Row& row = block.rows[rowIdx];
+
+		row.jvAx[lane] = jac.vA( 0 );
+		row.jvAy[lane] = jac.vA( 1 );
+		row.jwA[lane] = jac.wA( 2 );
+		row.jvBx[lane] = jac.vB( 0 );
+		row.jvBy[lane] = jac.vB( 1 );
+		row.jwB[lane] = jac.wB( 2 );
+
+		Real JmJ =
+			jac.vA( 0 ) * bodyA.mInv * jac.vA( 0 ) +
+			jac.vA( 1 ) * bodyA.mInv * jac.vA( 1 ) +
+			jac.wA( 2 ) * bodyA.iInv * jac.wA( 2 ) +
+			jac.vB( 0 ) * bodyB.mInv * jac.vB( 0 ) +
+			jac.vB( 1 ) * bodyB.mInv * jac.vB( 1 ) +
+			jac.wB( 2 ) * bodyB.iInv * jac.wB( 2 );
+
+		// Same part of penetration pushed out per step as scalar contacts
+		row.invEffMass[lane] = ( JmJ > 0.f ) ? 1.f / JmJ : 0.f;
+		row.bias[lane] = 0.2f * constraint.error / info.m_deltaTime;
+		row.accumImp[lane] = constraint.accumImp;
+	}
+}
+
+void physicsContactBatch::getColorRange( const int colorIdx, int& startOut, int& endOut ) const
+{
+	Assert( colorIdx >= 0 && colorIdx <= getNumColors(), "color out of range" );
+
+	startOut = m_colorStarts[colorIdx];
+	endOut = m_colorStarts[colorIdx + 1];
+}
+
+void physicsContactBatch::gather( const Block& block, const std::vector<SolverBody>& bodies, Velocities& velOut ) const
+{
+	for ( int lane = 0; lane < WIDTH; lane++ )
+	{
+		if ( block.pairIdx[lane] < 0 )
+		{
+			velOut.vAx[lane] = velOut.vAy[lane] = velOut.wA[lane] = 0.f;
+			velOut.vBx[lane] = velOut.vBy[lane] = velOut.wB[lane] = 0.f;
+			continue;
+		}
+
+		const SolverBody& bodyA = bodies[block.bodyIdA[lane]];
+		const SolverBody& bodyB = bodies[block.bodyIdB[lane]];
+
+		velOut.vAx[lane] = bodyA.v( 0 );
+		velOut.vAy[lane] = bodyA.v( 1 );
+		velOut.wA[lane] = bodyA.w( 2 );
+		velOut.vBx[lane] = bodyB.v( 0 );
+		velOut.vBy[lane] = bodyB.v( 1 );
+		velOut.wB[lane] = bodyB.w( 2 );
+	}
+}
+
+void physicsContactBatch::scatter( const Block& block, const Velocities& vel, std::vector<SolverBody>& bodies ) const
+{
+	for ( int lane = 0; lane < WIDTH; lane++ )
+	{
+		if ( block.pairIdx[lane] < 0 )
+		{
+			continue;
+		}
+
+		if ( block.mInvA[lane] != 0.f || block.iInvA[lane] != 0.f )
+		{
+			SolverBody& bodyA = bodies[block.bodyIdA[lane]];
+			bodyA.v( 0 ) = vel.vAx[lane];
+			bodyA.v( 1 ) = vel.vAy[lane];
+			bodyA.w( 2 ) = vel.wA[lane];
+		}
+
+		if ( block.mInvB[lane] != 0.f || block.iInvB[lane] != 0.f )
+		{
+			SolverBody& bodyB = bodies[block.bodyIdB[lane]];
+			bodyB.v( 0 ) = vel.vBx[lane];
+			bodyB.v( 1 ) = vel.vBy[lane];
+			bodyB.w( 2 ) = vel.wB[lane];
+		}
+	}
+}
+
+void physicsContactBatch::warmStart( const int blockIdx, std::vector<SolverBody>& bodies )
+{
+	const Block& block = m_blocks[blockIdx];
+	Velocities vel;
+
+	gather( block, bodies, vel );
+	warmStart8( block, vel );
+	scatter( block, vel, bodies );
+}
+
+void physicsContactBatch::solve( const int blockIdx, std::vector<SolverBody>& bodies )
+{
+	Block& block = m_blocks[blockIdx];
+	Velocities vel;
+
+	gather( block, bodies, vel );
+	solve8( block, vel );
+	scatter( block, vel, bodies );
+}
+
+void physicsContactBatch::storeImpulses( std::vector<ConstrainedPair>& pairs ) const
+{
+	for ( auto iter = m_blocks.begin(); iter != m_blocks.end(); iter++ )
+	{
+		for ( int lane = 0; lane < WIDTH && iter->pairIdx[lane] >= 0; lane++ )
+		{
+			std::vector<Constraint>& constraints = pairs[iter->pairIdx[lane]].constraints;
+
+			for ( int rowIdx = 0; rowIdx < ( int )constraints.size(); rowIdx++ )
+			{
+				constraints[rowIdx].accumImp = iter->rows[rowIdx].accumImp[lane];
+			}
+		}
+	}
+}
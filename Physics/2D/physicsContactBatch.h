@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#include <physicsSolver.h>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+class physicsConstraintColoring;
+
+// Contact pairs packed into blocks of WIDTH lanes so solver solves several pairs at once.
+// Lanes of a block come from one color and never share a dynamic body, so impulses of all lanes are applied together.
+// A lane holds a normal then a tangent row per contact point. Jacobians, inverse effective masses and bias are
+// computed once when blocks are built, missing points and padding lanes have zero rows which never produce impulses
+class physicsContactBatch
+{
+public:
+
+	enum { WIDTH = 8 }; // Lanes per block, enough for widest kernel
+	enum { MAX_ROWS = 4 }; // Two points with normal and tangent rows
+
+	physicsContactBatch();
+
+	~physicsContactBatch();
+
+	// Packs pairs color by color, overflow pairs get a block each as they may share bodies.
+	// Pairs have to be contact pairs colored with given coloring
+	void build( const SolverInfo& info,
+				const physicsConstraintColoring& coloring,
+				const std::vector<ConstrainedPair>& pairs,
+				const std::vector<SolverBody>& bodies );
+
+	// Colors are [0, getNumColors()), range of color getNumColors() is the overflow
+	int getNumColors() const { return ( int )m_colorStarts.size() - 2; }
+
+	// Range of color in blocks
+	void getColorRange( const int colorIdx, int& startOut, int& endOut ) const;
+
+	// Applies impulses rows start with
+	void warmStart( const int blockIdx, std::vector<SolverBody>& bodies );
+
+	// One iteration over rows of a block
+	void solve( const int blockIdx, std::vector<SolverBody>& bodies );
+
+	// Copies accumulated impulses back to constraints of pairs given to build
+	void storeImpulses( std::vector<ConstrainedPair>& pairs ) const;
+
+protected:
+
+	struct Row
+	{
+		Real jvAx[WIDTH], jvAy[WIDTH], jwA[WIDTH];
+		Real jvBx[WIDTH], jvBy[WIDTH], jwB[WIDTH];
+		Real invEffMass[WIDTH];
+		Real bias[WIDTH];
+		Real accumImp[WIDTH];
+	};
+
+	struct Block
+	{
+		int pairIdx[WIDTH]; // -1 for padding lanes
+		BodyId bodyIdA[WIDTH];
+		BodyId bodyIdB[WIDTH];
+		Real mInvA[WIDTH], iInvA[WIDTH];
+		Real mInvB[WIDTH], iInvB[WIDTH];
+		Real friction[WIDTH];
+		Row rows[MAX_ROWS];
+	};
+
+	// Body velocities of a block's lanes
+	struct Velocities
+	{
+		Real vAx[WIDTH], vAy[WIDTH], wA[WIDTH];
+		Real vBx[WIDTH], vBy[WIDTH], wB[WIDTH];
+	};
+
+	void setLane( Block& block, const int lane, const int pairIdx, const SolverInfo& info,
+				  const ConstrainedPair& pair, const std::vector<SolverBody>& bodies );
+
+	void gather( const Block& block, const std::vector<SolverBody>& bodies, Velocities& velOut ) const;
+
+	// Static bodies and padding lanes aren't written
+	void scatter( const Block& block, const Velocities& vel, std::vector<SolverBody>& bodies ) const;
+
+	// Lanes [lane, lane + 4) and [lane, lane + 8), 8 wide falls back to two SSE kernels without AVX2
+	inline void warmStart4( const Block& block, const int lane, Velocities& vel ) const;
+	inline void solve4( Block& block, const int lane, Velocities& vel ) const;
+	inline void warmStart8( const Block& block, Velocities& vel ) const;
+	inline void solve8( Block& block, Velocities& vel ) const;
+
+	std::vector<Block> m_blocks;
+	std::vector<int> m_colorStarts; // Block ranges, overflow follows colors
+};
+
+#include <physicsContactBatch.inl>
@@ -0,0 +1,219 @@
+inline void physicsContactBatch::warmStart4( const Block& block, const int lane, Velocities& vel ) const
+{
+	__m128 vAx = _mm_loadu_ps( &vel.vAx[lane] );
+	__m128 vAy = _mm_loadu_ps( &vel.vAy[lane] );
+	__m128 wA = _mm_loadu_ps( &vel.wA[lane] );
+	__m128 vBx = _mm_loadu_ps( &vel.vBx[lane] );
+	__m128 vBy = _mm_loadu_ps( &vel.vBy[lane] );
+	__m128 wB = _mm_loadu_ps( &vel.wB[lane] );
+
+	__m128 mInvA = _mm_loadu_ps( &block.mInvA[lane] );
+	__m128 iInvA = _mm_loadu_ps( &block.iInvA[lane] );
+	__m128 mInvB = _mm_loadu_ps( &block.mInvB[lane] );
+	__m128 iInvB = _mm_loadu_ps( &block.iInvB[lane] );
+
+	for ( int rowIdx = 0; rowIdx < MAX_ROWS; rowIdx++ )
+	{
+		const Row& row = block.rows[rowIdx];
+		__m128 impulse = _mm_loadu_ps( &row.accumImp[lane] );
+		__m128 impulseA = _mm_mul_ps( impulse, mInvA );
+		__m128 impulseB = _mm_mul_ps( impulse, mInvB );
+
+		vAx = _mm_add_ps( vAx, _mm_mul_ps( _mm_loadu_ps( &row.jvAx[lane] ), impulseA ) );
+		vAy = _mm_add_ps( vAy, _mm_mul_ps( _mm_loadu_ps( &row.jvAy[lane] ), impulseA ) );
+		wA = _mm_add_ps( wA, _mm_mul_ps( _mm_loadu_ps( &row.jwA[lane] ), _mm_mul_ps( impulse, iInvA ) ) );
+		vBx = _mm_add_ps( vBx, _mm_mul_ps( _mm_loadu_ps( &row.jvBx[lane] ), impulseB ) );
+		vBy = _mm_add_ps( vBy, _mm_mul_ps( _mm_loadu_ps( &row.jvBy[lane] ), impulseB ) );
+		wB = _mm_add_ps( wB, _mm_mul_ps( _mm_loadu_ps( &row.jwB[lane] ), _mm_mul_ps( impulse, iInvB ) ) );
+	}
+
+	_mm_storeu_ps( &vel.vAx[lane], vAx );
+	_mm_storeu_ps( &vel.vAy[lane], vAy );
+	_mm_storeu_ps( &vel.wA[lane], wA );
+	_mm_storeu_ps( &vel.vBx[lane], vBx );
+	_mm_storeu_ps( &vel.vBy[lane], vBy );
+	_mm_storeu_ps( &vel.wB[lane], wB );
+}
+
+inline void physicsContactBatch::solve4( Block& block, const int lane, Velocities& vel ) const
+{
+	__m128 vAx = _mm_loadu_ps( &vel.vAx[lane] );
+	__m128 vAy = _mm_loadu_ps( &vel.vAy[lane] );
+	__m128 wA = _mm_loadu_ps( &vel.wA[lane] );
+	__m128 vBx = _mm_loadu_ps( &vel.vBx[lane] );
+	__m128 vBy = _mm_loadu_ps( &vel.vBy[lane] );
+	__m128 wB = _mm_loadu_ps( &vel.wB[lane] );
+
+	__m128 mInvA = _mm_loadu_ps( &block.mInvA[lane] );
+	__m128 iInvA = _mm_loadu_ps( &block.iInvA[lane] );
+	__m128 mInvB = _mm_loadu_ps( &block.mInvB[lane] );
+	__m128 iInvB = _mm_loadu_ps( &block.iInvB[lane] );
+	__m128 friction = _mm_loadu_ps( &block.friction[lane] );
+	__m128 normalImp = _mm_setzero_ps();
+
+	for ( int rowIdx = 0; rowIdx < MAX_ROWS; rowIdx++ )
+	{
+		Row& row = block.rows[rowIdx];
+
+		__m128 jvAx = _mm_loadu_ps( &row.jvAx[lane] );
+		__m128 jvAy = _mm_loadu_ps( &row.jvAy[lane] );
+		__m128 jwA = _mm_loadu_ps( &row.jwA[lane] );
+		__m128 jvBx = _mm_loadu_ps( &row.jvBx[lane] );
+		__m128 jvBy = _mm_loadu_ps( &row.jvBy[lane] );
+		__m128 jwB = _mm_loadu_ps( &row.jwB[lane] );
+
+		__m128 jv = _mm_add_ps( _mm_add_ps( _mm_mul_ps( jvAx, vAx ), _mm_mul_ps( jvAy, vAy ) ), _mm_mul_ps( jwA, wA ) );
+		jv = _mm_add_ps( jv, _mm_add_ps( _mm_add_ps( _mm_mul_ps( jvBx, vBx ), _mm_mul_ps( jvBy, vBy ) ), _mm_mul_ps( jwB, wB ) ) );
+
+		__m128 impulse = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &row.bias[lane] ), jv ), _mm_loadu_ps( &row.invEffMass[lane] ) );
+		__m128 accumImp = _mm_loadu_ps( &row.accumImp[lane] );
+		__m128 newImp = _mm_add_ps( accumImp, impulse );
+
+		if ( rowIdx % 2 == 0 )
+		{
+			// Normal, can only push
+			newImp = _mm_max_ps( newImp, _mm_setzero_ps() );
+			normalImp = newImp;
+		}
+		else
+		{
+			// Tangent, inside friction cone of normal impulse solved just before
+			__m128 maxImp = _mm_mul_ps( friction, normalImp );
+			newImp = _mm_max_ps( _mm_sub_ps( _mm_setzero_ps(), maxImp ), _mm_min_ps( newImp, maxImp ) );
+		}
+
+		impulse = _mm_sub_ps( newImp, accumImp );
+		_mm_storeu_ps( &row.accumImp[lane], newImp );
+
+		__m128 impulseA = _mm_mul_ps( impulse, mInvA );
+		__m128 impulseB = _mm_mul_ps( impulse, mInvB );
+
+		vAx = _mm_add_ps( vAx, _mm_mul_ps( jvAx, impulseA ) );
+		vAy = _mm_add_ps( vAy, _mm_mul_ps( jvAy, impulseA ) );
+		wA = _mm_add_ps( wA, _mm_mul_ps( jwA, _mm_mul_ps( impulse, iInvA ) ) );
+		vBx = _mm_add_ps( vBx, _mm_mul_ps( jvBx, impulseB ) );
+		vBy = _mm_add_ps( vBy, _mm_mul_ps( jvBy, impulseB ) );
+		wB = _mm_add_ps( wB, _mm_mul_ps( jwB, _mm_mul_ps( impulse, iInvB ) ) );
+	}
+
+	_mm_storeu_ps( &vel.vAx[lane], vAx );
+	_mm_storeu_ps( &vel.vAy[lane], vAy );
+	_mm_storeu_ps( &vel.wA[lane], wA );
+	_mm_storeu_ps( &vel.vBx[lane], vBx );
+	_mm_storeu_ps( &vel.vBy[lane], vBy );
+	_mm_storeu_ps( &vel.wB[lane], wB );
+}
+
+inline void physicsContactBatch::warmStart8( const Block& block, Velocities& vel ) const
+{
+#if defined( __AVX2__ )
+	__m256 vAx = _mm256_loadu_ps( vel.vAx );
+	__m256 vAy = _mm256_loadu_ps( vel.vAy );
+	__m256 wA = _mm256_loadu_ps( vel.wA );
+	__m256 vBx = _mm256_loadu_ps( vel.vBx );
+	__m256 vBy = _mm256_loadu_ps( vel.vBy );
+	__m256 wB = _mm256_loadu_ps( vel.wB );
+
+	__m256 mInvA = _mm256_loadu_ps( block.mInvA );
+	__m256 iInvA = _mm256_loadu_ps( block.iInvA );
+	__m256 mInvB = _mm256_loadu_ps( block.mInvB );
+	__m256 iInvB = _mm256_loadu_ps( block.iInvB );
+
+	for ( int rowIdx = 0; rowIdx < MAX_ROWS; rowIdx++ )
+	{
+		const Row& row = block.rows[rowIdx];
+		__m256 impulse = _mm256_loadu_ps( row.accumImp );
+		__m256 impulseA = _mm256_mul_ps( impulse, mInvA );
+		__m256 impulseB = _mm256_mul_ps( impulse, mInvB );
+
+		vAx = _mm256_add_ps( vAx, _mm256_mul_ps( _mm256_loadu_ps( row.jvAx ), impulseA ) );
+		vAy = _mm256_add_ps( vAy, _mm256_mul_ps( _mm256_loadu_ps( row.jvAy ), impulseA ) );
+		wA = _mm256_add_ps( wA, _mm256_mul_ps( _mm256_loadu_ps( row.jwA ), _mm256_mul_ps( impulse, iInvA ) ) );
+		vBx = _mm256_add_ps( vBx, _mm256_mul_ps( _mm256_loadu_ps( row.jvBx ), impulseB ) );
+		vBy = _mm256_add_ps( vBy, _mm256_mul_ps( _mm256_loadu_ps( row.jvBy ), impulseB ) );
+		wB = _mm256_add_ps( wB, _mm256_mul_ps( _mm256_loadu_ps( row.jwB ), _mm256_mul_ps( impulse, iInvB ) ) );
+	}
+
+	_mm256_storeu_ps( vel.vAx, vAx );
+	_mm256_storeu_ps( vel.vAy, vAy );
+	_mm256_storeu_ps( vel.wA, wA );
+	_mm256_storeu_ps( vel.vBx, vBx );
+	_mm256_storeu_ps( vel.vBy, vBy );
+	_mm256_storeu_ps( vel.wB, wB );
+#else
+	warmStart4( block, 0, vel );
+	warmStart4( block, 4, vel );
+#endif
+}
+
+inline void physicsContactBatch::solve8( Block& block, Velocities& vel ) const
+{
+#if defined( __AVX2__ )
+	__m256 vAx = _mm256_loadu_ps( vel.vAx );
+	__m256 vAy = _mm256_loadu_ps( vel.vAy );
+	__m256 wA = _mm256_loadu_ps( vel.wA );
+	__m256 vBx = _mm256_loadu_ps( vel.vBx );
+	__m256 vBy = _mm256_loadu_ps( vel.vBy );
+	__m256 wB = _mm256_loadu_ps( vel.wB );
+
+	__m256 mInvA = _mm256_loadu_ps( block.mInvA );
+	__m256 iInvA = _mm256_loadu_ps( block.iInvA );
+	__m256 mInvB = _mm256_loadu_ps( block.mInvB );
+	__m256 iInvB = _mm256_loadu_ps( block.iInvB );
+	__m256 friction = _mm256_loadu_ps( block.friction );
+	__m256 normalImp = _mm256_setzero_ps();
+
+	for ( int rowIdx = 0; rowIdx < MAX_ROWS; rowIdx++ )
+	{
+		Row& row = block.rows[rowIdx];
+
+		__m256 jvAx = _mm256_loadu_ps( row.jvAx );
+		__m256 jvAy = _mm256_loadu_ps( row.jvAy );
+		__m256 jwA = _mm256_loadu_ps( row.jwA );
+		__m256 jvBx = _mm256_loadu_ps( row.jvBx );
+		__m256 jvBy = _mm256_loadu_ps( row.jvBy );
+		__m256 jwB = _mm256_loadu_ps( row.jwB );
+
+		__m256 jv = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( jvAx, vAx ), _mm256_mul_ps( jvAy, vAy ) ), _mm256_mul_ps( jwA, wA ) );
+		jv = _mm256_add_ps( jv, _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( jvBx, vBx ), _mm256_mul_ps( jvBy, vBy ) ), _mm256_mul_ps( jwB, wB ) ) );
+
+		__m256 impulse = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( row.bias ), jv ), _mm256_loadu_ps( row.invEffMass ) );
+		__m256 accumImp = _mm256_loadu_ps( row.accumImp );
+		__m256 newImp = _mm256_add_ps( accumImp, impulse );
+
+		if ( rowIdx % 2 == 0 )
+		{
+			newImp = _mm256_max_ps( newImp, _mm256_setzero_ps() );
+			normalImp = newImp;
+		}
+		else
+		{
+			__m256 maxImp = _mm256_mul_ps( friction, normalImp );
+			newImp = _mm256_max_ps( _mm256_sub_ps( _mm256_setzero_ps(), maxImp ), _mm256_min_ps( newImp, maxImp ) );
+		}
+
+		impulse = _mm256_sub_ps( newImp, accumImp );
+		_mm256_storeu_ps( row.accumImp, newImp );
+
+		__m256 impulseA = _mm256_mul_ps( impulse, mInvA );
+		__m256 impulseB = _mm256_mul_ps( impulse, mInvB );
+
+		vAx = _mm256_add_ps( vAx, _mm256_mul_ps( jvAx, impulseA ) );
+		vAy = _mm256_add_ps( vAy, _mm256_mul_ps( jvAy, impulseA ) );
+		wA = _mm256_add_ps( wA, _mm256_mul_ps( jwA, _mm256_mul_ps( impulse, iInvA ) ) );
+		vBx = _mm256_add_ps( vBx, _mm256_mul_ps( jvBx, impulseB ) );
+		vBy = _mm256_add_ps( vBy, _mm256_mul_ps( jvBy, impulseB ) );
+		wB = _mm256_add_ps( wB, _mm256_mul_ps( jwB, _mm256_mul_ps( impulse, iInvB ) ) );
+	}
+
+	_mm256_storeu_ps( vel.vAx, vAx );
+	_mm256_storeu_ps( vel.vAy, vAy );
+	_mm256_storeu_ps( vel.wA, wA );
+	_mm256_storeu_ps( vel.vBx, vBx );
+	_mm256_storeu_ps( vel.vBy, vBy );
+	_mm256_storeu_ps( vel.wB, wB );
+#else
+	solve4( block, 0, vel );
+	solve4( block, 4, vel );
+#endif
+}
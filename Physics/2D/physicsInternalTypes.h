@@ -105,17 +105,17 @@ namespace BodyIdPairsUtils
 	}
 };
 
-BodyIdPair::BodyIdPair( const BodyId a, const BodyId b )
+inline BodyIdPair::BodyIdPair( const BodyId a, const BodyId b )
 {
     set( a, b );
 }
 
-BodyIdPair::BodyIdPair( const BodyIdPair& other )
+inline BodyIdPair::BodyIdPair( const BodyIdPair& other )
 {
     set( other );
 }
 
-void BodyIdPair::set( const BodyId a, const BodyId b )
+inline void BodyIdPair::set( const BodyId a, const BodyId b )
 {
     if ( a != invalidId && b != invalidId )
     {
@@ -126,22 +126,22 @@ void BodyIdPair::set( const BodyId a, const BodyId b )
     bodyIdB = (a > b) ? b : a;
 }
 
-void BodyIdPair::set( const BodyIdPair& other )
+inline void BodyIdPair::set( const BodyIdPair& other )
 {
     set( other.bodyIdA, other.bodyIdB );
 }
 
-bool operator == ( const BodyIdPair& pairA, const BodyIdPair& pairB )
+inline bool operator == ( const BodyIdPair& pairA, const BodyIdPair& pairB )
 {
     return (pairA.bodyIdA == pairB.bodyIdA && pairA.bodyIdB == pairB.bodyIdB);
 }
 
-bool operator != ( const BodyIdPair& pairA, const BodyIdPair& pairB )
+inline bool operator != ( const BodyIdPair& pairA, const BodyIdPair& pairB )
 {
     return !(pairA == pairB);
 }
 
-bool operator < ( const BodyIdPair& pairA, const BodyIdPair& pairB )
+inline bool operator < ( const BodyIdPair& pairA, const BodyIdPair& pairB )
 {
     //	return ( ( ( pairA.bodyIdA << 16 ) | pairA.bodyIdB ) < ( ( pairB.bodyIdA << 16 ) | pairB.bodyIdB ) );
     if ( pairA.bodyIdA < pairB.bodyIdA )
@@ -157,12 +157,12 @@ bool operator < ( const BodyIdPair& pairA, const BodyIdPair& pairB )
     return false;
 }
 
-bool operator > ( const BodyIdPair& pairA, const BodyIdPair& pairB )
+inline bool operator > ( const BodyIdPair& pairA, const BodyIdPair& pairB )
 {
     return !(pairA < pairB);
 }
 
-bool bodyIdPairLess( const BodyIdPair& pairA, const BodyIdPair& pairB )
+inline bool bodyIdPairLess( const BodyIdPair& pairA, const BodyIdPair& pairB )
 {
     return pairA < pairB;
 }
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <Base.h>
+
+#include <physicsTypes.h>
+#include <physicsInternalTypes.h>
+
+// Open addressing hash map keyed on body Id pairs, values are stored in place in a slot array parallel to keys.
+// Pairs are packed into 32 bits and probed linearly, removal shifts following entries back instead of
+// leaving tombstones. Probing and iterating only read the packed keys until a used slot is found. Find, insert and remove are O(1) on average and nothing needs to be kept sorted.
+// Iterate with slot indices, order follows hashes and stays the same for the same sequence of operations
+template <typename T>
+class physicsPairMap
+{
+public:
+
+	physicsPairMap();
+
+	~physicsPairMap();
+
+	int getSize() const { return m_size; }
+
+	bool isEmpty() const { return m_size == 0; }
+
+	// Returns null if pair isn't in map
+	inline T* find( const BodyIdPair& pair );
+
+	inline const T* find( const BodyIdPair& pair ) const;
+
+	// Returns value of pair, value is only copied in if pair wasn't in map yet
+	inline T& insert( const BodyIdPair& pair, const T& value, bool* insertedOut = nullptr );
+
+	// Returns false if pair wasn't in map.
+	// Removing moves other entries, don't remove while iterating slots
+	inline bool remove( const BodyIdPair& pair );
+
+	// Keeps capacity
+	void clear();
+
+	// Slots [0, getNumSlots()) hold entries where isSlotUsed
+	int getNumSlots() const { return ( int )m_keys.size(); }
+
+	bool isSlotUsed( const int slotIdx ) const { return m_keys[slotIdx] != EMPTY_KEY; }
+
+	inline BodyIdPair getSlotPair( const int slotIdx ) const;
+
+	T& getSlotValue( const int slotIdx ) { return m_values[slotIdx].value; }
+
+	const T& getSlotValue( const int slotIdx ) const { return m_values[slotIdx].value; }
+
+protected:
+
+	enum { MIN_SLOTS = 16 };
+
+	// Two invalid Ids never form a pair
+	static const unsigned int EMPTY_KEY = 0xffffffff;
+
+	// Wrapped so vector<bool> specialization doesn't kick in
+	struct Value
+	{
+		T value;
+	};
+
+	static inline unsigned int packPair( const BodyIdPair& pair );
+
+	inline unsigned int getHomeSlot( const unsigned int key ) const;
+
+	// Slot holding key, or empty slot where it would go
+	inline int findSlot( const unsigned int key ) const;
+
+	// Doubles slot count and re-inserts all entries
+	void grow();
+
+	std::vector<unsigned int> m_keys; // bodyIdA << 16 | bodyIdB, power of two sized, at most half full
+	std::vector<Value> m_values;
+	int m_size;
+};
+
+#include <physicsPairMap.inl>
@@ -0,0 +1,170 @@
+template <typename T>
+physicsPairMap<T>::physicsPairMap() :
+	m_size( 0 )
+{
+
+}
+
+template <typename T>
+physicsPairMap<T>::~physicsPairMap()
+{
+
+}
+
+template <typename T>
+inline unsigned int physicsPairMap<T>::packPair( const BodyIdPair& pair )
+{
+	return ( static_cast< unsigned int >( pair.bodyIdA ) << 16 ) | pair.bodyIdB;
+}
+
+template <typename T>
+inline unsigned int physicsPairMap<T>::getHomeSlot( const unsigned int key ) const
+{
+	// Fibonacci hashing, high bits are folded down into the index bits
+	unsigned int hash = key * 2654435769u;
+	return ( hash ^ ( hash >> 16 ) ) & ( unsigned int )( m_keys.size() - 1 );
+}
+
+template <typename T>
+inline int physicsPairMap<T>::findSlot( const unsigned int key ) const
+{
+	unsigned int mask = ( unsigned int )( m_keys.size() - 1 );
+	unsigned int slotIdx = getHomeSlot( key );
+
+	// Never full, so probing always hits an empty slot
+	while ( m_keys[slotIdx] != key && m_keys[slotIdx] != EMPTY_KEY )
+	{
+		slotIdx = ( slotIdx + 1 ) & mask;
+	}
+
+	return ( int )slotIdx;
+}
+
+template <typename T>
+inline T* physicsPairMap<T>::find( const BodyIdPair& pair )
+{
+	if ( m_size == 0 )
+	{
+		return nullptr;
+	}
+
+	unsigned int key = packPair( pair );
+	int slotIdx = findSlot( key );
+
+	return ( m_keys[slotIdx] == key ) ? &m_values[slotIdx].value : nullptr;
+}
+
+template <typename T>
+inline const T* physicsPairMap<T>::find( const BodyIdPair& pair ) const
+{
+	return const_cast< physicsPairMap<T>* >( this )->find( pair );
+}
+
+template <typename T>
+inline T& physicsPairMap<T>::insert( const BodyIdPair& pair, const T& value, bool* insertedOut )
+{
+	if ( ( m_size + 1 ) * 2 > ( int )m_keys.size() )
+	{
+		grow();
+	}
+
+	unsigned int key = packPair( pair );
+	int slotIdx = findSlot( key );
+
+	bool inserted = ( m_keys[slotIdx] == EMPTY_KEY );
+
+	if ( inserted )
+	{
+		m_keys[slotIdx] = key;
+		m_values[slotIdx].value = value;
+		m_size++;
+	}
+
+	if ( insertedOut )
+	{
+		*insertedOut = inserted;
+	}
+
+	return m_values[slotIdx].value;
+}
+
+template <typename T>
+inline bool physicsPairMap<T>::remove( const BodyIdPair& pair )
+{
+	if ( m_size == 0 )
+	{
+		return false;
+	}
+
+	unsigned int mask = ( unsigned int )( m_keys.size() - 1 );
+	unsigned int holeIdx = ( unsigned int )findSlot( packPair( pair ) );
+
+	if ( m_keys[holeIdx] == EMPTY_KEY )
+	{
+		return false;
+	}
+
+	// Shift back entries whose probe sequence passes through the hole, so lookups never stop early
+	for ( unsigned int slotIdx = ( holeIdx + 1 ) & mask; m_keys[slotIdx] != EMPTY_KEY; slotIdx = ( slotIdx + 1 ) & mask )
+	{
+		unsigned int homeIdx = getHomeSlot( m_keys[slotIdx] );
+
+		if ( ( ( slotIdx - homeIdx ) & mask ) >= ( ( slotIdx - holeIdx ) & mask ) )
+		{
+			m_keys[holeIdx] = m_keys[slotIdx];
+			m_values[holeIdx] = m_values[slotIdx];
+			holeIdx = slotIdx;
+		}
+	}
+
+	m_keys[holeIdx] = EMPTY_KEY;
+	m_size--;
+
+	return true;
+}
+
+template <typename T>
+void physicsPairMap<T>::clear()
+{
+	if ( m_size == 0 )
+	{
+		return;
+	}
+
+	for ( auto iter = m_keys.begin(); iter != m_keys.end(); iter++ )
+	{
+		*iter = EMPTY_KEY;
+	}
+
+	m_size = 0;
+}
+
+template <typename T>
+inline BodyIdPair physicsPairMap<T>::getSlotPair( const int slotIdx ) const
+{
+	unsigned int key = m_keys[slotIdx];
+	return BodyIdPair( static_cast< BodyId >( key >> 16 ), static_cast< BodyId >( key & 0xffff ) );
+}
+
+template <typename T>
+void physicsPairMap<T>::grow()
+{
+	std::vector<unsigned int> oldKeys;
+	std::vector<Value> oldValues;
+	oldKeys.swap( m_keys );
+	oldValues.swap( m_values );
+
+	size_t numSlots = oldKeys.empty() ? MIN_SLOTS : oldKeys.size() * 2;
+	m_keys.resize( numSlots, ( unsigned int )EMPTY_KEY );
+	m_values.resize( numSlots );
+
+	for ( size_t i = 0; i < oldKeys.size(); i++ )
+	{
+		if ( oldKeys[i] != EMPTY_KEY )
+		{
+			int slotIdx = findSlot( oldKeys[i] );
+			m_keys[slotIdx] = oldKeys[i];
+			m_values[slotIdx] = oldValues[i];
+		}
+	}
+}
@@ -9,8 +9,6 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
-#include <Renderer.h>
-
 const Real g_density = 1.f;
 
 //#define D_PRINT_VERTICES
@@ -137,55 +135,51 @@ bool physicsBoxShape::containsPoint( const Vector4& point ) const
 
 void physicsBoxShape::getSupportingVertex( const Vector4& direction, Vector4& point ) const
 {
-	Vector4 dirNw( -m_halfExtents( 0 ), m_halfExtents( 1 ) );
-	Vector4 dirSw( -m_halfExtents( 0 ), -m_halfExtents( 1 ) );
-	Vector4 dirSe( m_halfExtents( 0 ), -m_halfExtents( 1 ) );
-	Vector4 dirNe( m_halfExtents( 0 ), m_halfExtents( 1 ) );
-
-	Real currMax = std::numeric_limits<Real>::lowest();
-	Real potentialMaxDot;
-
-	potentialMaxDot = direction.dot<2>( dirNw );
-	if ( potentialMaxDot > currMax )
-	{
-		currMax = potentialMaxDot;
-		point = dirNw;
-	}
+	// Corner on the side of each axis the direction points to, ties go to -x and -y like the corner scan did
+	point.set( ( direction( 0 ) > 0.f ) ? m_halfExtents( 0 ) : -m_halfExtents( 0 ),
+			   ( direction( 1 ) > 0.f ) ? m_halfExtents( 1 ) : -m_halfExtents( 1 ) );
+}
 
-	potentialMaxDot = direction.dot<2>( dirSw );
-	if ( potentialMaxDot > currMax )
-	{
-		currMax = potentialMaxDot;
-		point = dirSw;
-	}
+void physicsBoxShape::getSupportingVertexFrom( const Vector4& direction, int& vertexIdx, Vector4& point ) const
+{
+	getSupportingVertex( direction, point );
 
-	potentialMaxDot = direction.dot<2>( dirSe );
-	if ( potentialMaxDot > currMax )
+	// Hull goes (+,+), (+,-), (-,-), (-,+)
+	if ( point( 0 ) > 0.f )
 	{
-		currMax = potentialMaxDot;
-		point = dirSe;
+		vertexIdx = ( point( 1 ) > 0.f ) ? 0 : 1;
 	}
-
-	potentialMaxDot = direction.dot<2>( dirNe );
-	if ( potentialMaxDot > currMax )
+	else
 	{
-		currMax = potentialMaxDot;
-		point = dirNe;
+		vertexIdx = ( point( 1 ) > 0.f ) ? 3 : 2;
 	}
 }
 
 physicsAabb physicsBoxShape::getAabb( const Real rot ) const
 {
-	// ERROR: this shouldn't have to convert to radians
-	Real radians = rot * ( Real )M_PI / 180.0f;
-	Real w = 2.0f * m_halfExtents( 0 ) * cos( radians ) + 2.0f * m_halfExtents( 1 ) * sin( radians );
-	Real h = 2.0f * m_halfExtents( 0 ) * sin( radians ) + 2.0f * m_halfExtents( 1 ) * cos( radians );
+	// Rotation is in radians, extents along both axes grow with either sign of cos and sin
+	Real cosRot = fabs( cos( rot ) );
+	Real sinRot = fabs( sin( rot ) );
+	Real w = 2.0f * m_halfExtents( 0 ) * cosRot + 2.0f * m_halfExtents( 1 ) * sinRot;
+	Real h = 2.0f * m_halfExtents( 0 ) * sinRot + 2.0f * m_halfExtents( 1 ) * cosRot;
 
 	return physicsAabb(
 		Vector4( w / 2.0f, h / 2.0f ),
 		Vector4( -w / 2.0f, -h / 2.0f ) );
 }
 
+void physicsBoxShape::getHullVertices( std::vector<Vector4>& verticesOut ) const
+{
+	Real hx = m_halfExtents( 0 );
+	Real hy = m_halfExtents( 1 );
+
+	verticesOut.clear();
+	verticesOut.push_back( Vector4( hx, hy ) );
+	verticesOut.push_back( Vector4( hx, -hy ) );
+	verticesOut.push_back( Vector4( -hx, -hy ) );
+	verticesOut.push_back( Vector4( -hx, hy ) );
+}
+
 // Convex shape class functions
 std::shared_ptr<physicsShape> physicsConvexShape::create( const std::vector<Vector4>& vertices, const Real radius )
 {
@@ -194,20 +188,21 @@ std::shared_ptr<physicsShape> physicsConvexShape::create( const std::vector<Vect
 
 physicsConvexShape::physicsConvexShape( const std::vector<Vector4>& vertices, const Real radius )
 { 
-	// Get unsorted list of vertices, establish connections to treat as convex
+	// Get unsorted list of vertices, establish connections to treat as convex.
+	// Connectivity is the strictly convex hull, duplicate, collinear and interior vertices stay out of it
 
-	// TODO: Bug where code will fail if two same vertices exist in vertices array
 	int numVertices = ( int )vertices.size();
 
 	// TODO: APPLY CONVEX RADIUS
 	m_vertices.assign( vertices.begin(), vertices.end() );
 
-	// Determine connectivity
-	unsigned int xMinIdx = 0;
+	// Determine connectivity, starting from leftmost vertex. Lowest of those is a corner even if left side is vertical
+	int xMinIdx = 0;
 
 	for ( int i = 1; i < numVertices; i++ )
 	{
-		if ( m_vertices[xMinIdx]( 0 ) > m_vertices[i]( 0 ) )
+		if ( m_vertices[xMinIdx]( 0 ) > m_vertices[i]( 0 ) ||
+			 ( m_vertices[xMinIdx]( 0 ) == m_vertices[i]( 0 ) && m_vertices[xMinIdx]( 1 ) > m_vertices[i]( 1 ) ) )
 		{
 			xMinIdx = i;
 		}
@@ -216,17 +211,15 @@ physicsConvexShape::physicsConvexShape( const std::vector<Vector4>& vertices, co
 	m_connectivity.push_back( xMinIdx );
 
 	int nodeCurrent = xMinIdx;
-	int nodeNext = -1;
-
-	Vector4 edgeCurrent;
-	edgeCurrent.set( 0.0f, 1.0f );
 
 	std::vector<bool> flags;
 	flags.resize( numVertices, false );
 
+	// Gift wrap clockwise, every vertex ends up right of or on each hull edge
 	for ( int i = 0; i < numVertices; i++ )
 	{
-		Real cosCurrent = -1.0f;
+		int nodeNext = -1;
+		Vector4 edgeNext;
 
 		for ( int j = 0; j < numVertices; j++ )
 		{
@@ -238,19 +231,45 @@ physicsConvexShape::physicsConvexShape( const std::vector<Vector4>& vertices, co
 			Vector4 edgePotential;
 			edgePotential.setSub( m_vertices[j], m_vertices[nodeCurrent] );
 
-			Real cosPotential = edgeCurrent.dot<2>( edgePotential ) / ( edgeCurrent.length<2>() * edgePotential.length<2>() );
+			// Duplicate of current vertex
+			if ( edgePotential.lengthSquared<2>() == 0.f )
+			{
+				continue;
+			}
+
+			if ( nodeNext < 0 )
+			{
+				nodeNext = j;
+				edgeNext = edgePotential;
+				continue;
+			}
+
+			// Scaled by lengths so tolerance doesn't depend on shape's size. On the line of the edge so far only a further vertex is taken,
+			// duplicates keep the lowest index, so closing edge ends at xMinIdx
+			Real cross = edgeNext( 0 ) * edgePotential( 1 ) - edgeNext( 1 ) * edgePotential( 0 );
+			Real tolerance = 1e-5f * sqrt( edgeNext.lengthSquared<2>() * edgePotential.lengthSquared<2>() );
 
-			if ( cosPotential > cosCurrent )
+			if ( cross > tolerance || ( cross > -tolerance && edgePotential.lengthSquared<2>() > edgeNext.lengthSquared<2>() ) )
 			{
 				nodeNext = j;
-				cosCurrent = cosPotential;
+				edgeNext = edgePotential;
 			}
 		}
 
+		if ( nodeNext < 0 )
+		{
+			// All vertices are the same point
+			break;
+		}
+
 		flags[nodeNext] = true;
 		m_connectivity.push_back( nodeNext );
-		edgeCurrent.setSub( m_vertices[nodeNext], m_vertices[nodeCurrent] );
 		nodeCurrent = nodeNext;
+
+		if ( nodeNext == xMinIdx )
+		{
+			break;
+		}
 	}
 }
 
@@ -313,23 +332,41 @@ bool physicsConvexShape::containsPoint( const Vector4& point ) const
 
 void physicsConvexShape::getSupportingVertex( const Vector4& direction, Vector4& point ) const
 {
-	Real dotMax = std::numeric_limits<Real>::lowest();
-	Real potentialMaxDot;
-
-	auto numVertices = m_vertices.size();
-
-	Vector4 dirNorm = direction.getNormalized<2>();
+	int vertexIdx = 0;
+	getSupportingVertexFrom( direction, vertexIdx, point );
+}
 
-	for ( auto i = 0; i < numVertices; i++ )
+void physicsConvexShape::getSupportingVertexFrom( const Vector4& direction, int& vertexIdx, Vector4& point ) const
+{
+	// Last connectivity entry closes the loop
+	int numHullVertices = ( int )m_connectivity.size() - 1;
+	int current = ( vertexIdx >= 0 && vertexIdx < numHullVertices ) ? vertexIdx : 0;
+	Real currentDot = direction.dot<2>( m_vertices[m_connectivity[current]] );
+
+	// Going around a convex hull, dot with direction rises from the lowest vertex to the supporting one both ways,
+	// so walk the way which improves until the next vertex doesn't. Constructor leaves collinear vertices out of the hull,
+	// a run of them across the direction would stop the walk at the lowest side
+	int step = 1;
+	int next = ( current + 1 ) % numHullVertices;
+	Real nextDot = direction.dot<2>( m_vertices[m_connectivity[next]] );
+
+	if ( nextDot <= currentDot )
 	{
-		potentialMaxDot = dirNorm.dot<2>( m_vertices[i] );
+		step = numHullVertices - 1;
+		next = ( current + step ) % numHullVertices;
+		nextDot = direction.dot<2>( m_vertices[m_connectivity[next]] );
+	}
 
-		if ( potentialMaxDot > dotMax )
-		{
-			dotMax = potentialMaxDot;
-			point = m_vertices[i];
-		}
+	while ( nextDot > currentDot )
+	{
+		current = next;
+		currentDot = nextDot;
+		next = ( current + step ) % numHullVertices;
+		nextDot = direction.dot<2>( m_vertices[m_connectivity[next]] );
 	}
+
+	vertexIdx = current;
+	point = m_vertices[m_connectivity[current]];
 }
 
 physicsAabb physicsConvexShape::getAabb( const Real rot ) const
@@ -352,6 +389,16 @@ physicsAabb physicsConvexShape::getAabb( const Real rot ) const
 	return physicsAabb( Vector4( xmax, ymax ), Vector4( xmin, ymin ) );
 }
 
+void physicsConvexShape::getHullVertices( std::vector<Vector4>& verticesOut ) const
+{
+	verticesOut.clear();
+
+	for ( int i = 0; i < ( int )m_connectivity.size() - 1; i++ )
+	{
+		verticesOut.push_back( m_vertices[m_connectivity[i]] );
+	}
+}
+
 bool physicsConvexShape::getAdjacentVertices( const Vector4& vertex, Vector4& va, Vector4& vb )
 {
 	auto numVertices = m_vertices.size();
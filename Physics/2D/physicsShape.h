@@ -39,7 +39,14 @@ public:
 
     virtual void getSupportingVertex(const Vector4& direction, Vector4& point) const = 0;
 
+	// Search starts at vertexIdx, which is left at the supporting vertex so a nearby direction can start there next.
+	// Shapes without a vertex list set it to -1, they have no features to tell contacts apart by
+	virtual void getSupportingVertexFrom( const Vector4& direction, int& vertexIdx, Vector4& point ) const { getSupportingVertex( direction, point ); vertexIdx = -1; }
+
     virtual physicsAabb getAabb(const Real rot) const = 0;
+
+	// Polygon's outline in hull order, bodies keep a world space copy. Shapes without vertices leave it empty
+	virtual void getHullVertices( std::vector<Vector4>& verticesOut ) const { verticesOut.clear(); }
 };
 
 // Circle shape
@@ -91,8 +98,14 @@ public:
 
 	virtual void getSupportingVertex( const Vector4& direction, Vector4& point ) const override;
 
+	// Nothing to search, vertexIdx is set to the corner's position in getHullVertices
+	virtual void getSupportingVertexFrom( const Vector4& direction, int& vertexIdx, Vector4& point ) const override;
+
 	virtual physicsAabb getAabb( const Real rot ) const override;
 
+	// Corners going clockwise from +x+y, same winding as convex shapes' connectivity
+	virtual void getHullVertices( std::vector<Vector4>& verticesOut ) const override;
+
 	const Vector4& getHalfExtents() const { return m_halfExtents; }
     
 protected:
@@ -121,18 +134,20 @@ public:
 
     virtual void getSupportingVertex(const Vector4& direction, Vector4& point) const override;
 
+	// Hill climbs along hull, vertexIdx is a position in connectivity
+	virtual void getSupportingVertexFrom( const Vector4& direction, int& vertexIdx, Vector4& point ) const override;
+
     virtual physicsAabb getAabb(const Real rot) const override;
 
+	// Vertices in connectivity order without the closing entry, so positions match getSupportingVertexFrom's
+	virtual void getHullVertices( std::vector<Vector4>& verticesOut ) const override;
+
 	bool getAdjacentVertices( const Vector4& vertex, Vector4& va, Vector4& vb );
 
 	const std::vector<Vector4>& getVertices() const { return m_vertices; }
 
 	const std::vector<int>& getConnectivity() const { return m_connectivity; }
 
-public:
-
-	static const unsigned int maxVertices = 20;
-
 protected:
 
 	// Vertices passed can be unsorted
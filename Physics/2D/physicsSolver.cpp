@@ -1,11 +1,13 @@
 #include <algorithm>
+#include <limits>
 
 #include <Base.h>
 #include <physicsTypes.h>
 #include <physicsBody.h>
 #include <physicsSolver.h>
-
-#include <DebugUtils.h>
+#include <physicsConstraintColoring.h>
+#include <physicsContactBatch.h>
+#include <physicsThreadPool.h>
 
 /*
 { // Add friction
@@ -40,91 +42,324 @@ void SolverBody::setFromBody( const physicsBody& body )
 	iInv = body.getInvInertia();
 }
 
-void solveConstrainedPairs( const SolverInfo& info, 
-							bool isContact,
-							std::vector<ConstrainedPair>& solvePairs,
-							std::vector<SolverBody>& updatedBodiesOut )
+// Static bodies are shared by pairs solved in parallel, so they're only read
+static inline void applyImpulse( const SolverRow& row, const Real impulse, std::vector<SolverBody>& updatedBodiesOut )
 {
-	for ( auto pairIdx = 0; pairIdx < solvePairs.size(); pairIdx++ )
+	if ( row.isDynamicA )
 	{
-		ConstrainedPair& pair = solvePairs[ pairIdx ];
+		SolverBody& bodyA = updatedBodiesOut[ row.bodyIdA ];
+		bodyA.v( 0 ) += row.mjvAx * impulse;
+		bodyA.v( 1 ) += row.mjvAy * impulse;
+		bodyA.w( 2 ) += row.mjwA * impulse;
+	}
 
-		SolverBody& bodyA = updatedBodiesOut[ pair.bodyIdA ];
-		SolverBody& bodyB = updatedBodiesOut[ pair.bodyIdB ];
-		std::vector<Constraint>& constraints = pair.constraints;
+	if ( row.isDynamicB )
+	{
+		SolverBody& bodyB = updatedBodiesOut[ row.bodyIdB ];
+		bodyB.v( 0 ) += row.mjvBx * impulse;
+		bodyB.v( 1 ) += row.mjvBy * impulse;
+		bodyB.w( 2 ) += row.mjwB * impulse;
+	}
+}
 
-		for ( auto constraintIdx = 0; constraintIdx < constraints.size(); constraintIdx++ )
+// Applies impulses rows start with, iterations then only correct for what changed since last step
+static void warmStartRows( const SolverRow* rows, const int start, const int end, std::vector<SolverBody>& updatedBodiesOut )
+{
+	for ( int rowIdx = start; rowIdx < end; rowIdx++ )
+	{
+		applyImpulse( rows[ rowIdx ], rows[ rowIdx ].accumImp, updatedBodiesOut );
+	}
+}
+
+static void solveRows( SolverRow* rows, const int start, const int end, std::vector<SolverBody>& updatedBodiesOut )
+{
+	for ( int rowIdx = start; rowIdx < end; rowIdx++ )
+	{
+		SolverRow& row = rows[ rowIdx ];
+		const SolverBody& bodyA = updatedBodiesOut[ row.bodyIdA ];
+		const SolverBody& bodyB = updatedBodiesOut[ row.bodyIdB ];
+
+		Real Jv =
+			row.jvAx * bodyA.v( 0 ) + row.jvAy * bodyA.v( 1 ) + row.jwA * bodyA.w( 2 ) +
+			row.jvBx * bodyB.v( 0 ) + row.jvBy * bodyB.v( 1 ) + row.jwB * bodyB.w( 2 );
+
+		// Catches nan or infinite velocity of either body
+		Assert( isfinite( Jv ), "invalid velocity in solver" );
+
+		Real impulse = ( row.bias - Jv ) * row.invEffMass;
+
+		// Tangent bounds follow normal impulse solved just before
+		Real boundScale = ( row.normalRowIdx < 0 ) ? 1.f : rows[ row.normalRowIdx ].accumImp;
+		Real newImpulse = std::max( row.minImp * boundScale, std::min( row.accumImp + impulse, row.maxImp * boundScale ) );
+
+		impulse = newImpulse - row.accumImp;
+		row.accumImp = newImpulse;
+
+		applyImpulse( row, impulse, updatedBodiesOut );
+	}
+}
+
+physicsSolver::physicsSolver() :
+	m_threadPool( nullptr ),
+	m_coloring( new physicsConstraintColoring ),
+	m_contactBatch( new physicsContactBatch ),
+	m_isParallel( false ),
+	m_isWide( false )
+{
+
+}
+
+physicsSolver::~physicsSolver()
+{
+	delete m_coloring;
+	delete m_contactBatch;
+}
+
+void physicsSolver::solveConstraints(
+	const SolverInfo& info,
+	bool isContact,
+	std::vector<ConstrainedPair>& constrainedPairs,
+	std::vector<SolverBody>& solverBodies )
+{
+	// Wide contacts prepare their own blocks
+	bool isWide = isContact && m_isWide;
+
+	if ( !isWide )
+	{
+		prepareRows( info, isContact, constrainedPairs, solverBodies );
+	}
+
+	if ( m_isParallel || isWide )
+	{
+		solveColored( info, isContact, constrainedPairs, solverBodies );
+	}
+	else
+	{
+		int numRows = ( int )m_rows.size();
+
+		if ( isContact )
 		{
-			Constraint& constraint = constraints[ constraintIdx ];
+			warmStartRows( m_rows.data(), 0, numRows, solverBodies );
+		}
 
-			Vector4 rA_world = constraint.rA.getRotatedDir( bodyA.ori ); // TODO: replace with transform
-			Vector4 rB_world = constraint.rB.getRotatedDir( bodyB.ori );
+		// Solve constraints, put satisfying velocities in solver bodies
+		for ( int i = 0; i < info.m_numIter; i++ )
+		{
+			solveRows( m_rows.data(), 0, numRows, solverBodies );
+		}
+	}
 
-			const Jacobian& jac = constraint.jac;
+	// Joints don't carry impulses between steps
+	if ( isContact && !isWide )
+	{
+		storeImpulses( constrainedPairs );
+	}
+}
 
-			Vector4 vab = bodyA.v + bodyA.w.cross( rA_world ) - bodyB.v - bodyB.w.cross( rB_world );
+void physicsSolver::prepareRows(
+	const SolverInfo& info,
+	bool isContact,
+	const std::vector<ConstrainedPair>& constrainedPairs,
+	const std::vector<SolverBody>& solverBodies )
+{
+	m_rows.clear();
+	m_pairRowStarts.clear();
 
-			Real Jv = vab.dot<2>(jac.vA);
+	// Contacts only push out part of penetration per step, warm started impulses already carry last step's push
+	const Real biasFactor = isContact ? 0.2f : 1.f;
+	const Real unbounded = std::numeric_limits<Real>::max();
 
-			Real JmJ =
-				jac.vA( 0 ) * bodyA.mInv * jac.vA( 0 ) +
-				jac.vA( 1 ) * bodyA.mInv * jac.vA( 1 ) +
-				jac.wA( 2 ) * bodyA.iInv * jac.wA( 2 ) +
-				jac.vB( 0 ) * bodyB.mInv * jac.vB( 0 ) +
-				jac.vB( 1 ) * bodyB.mInv * jac.vB( 1 ) +
-				jac.wB( 2 ) * bodyB.iInv * jac.wB( 2 );
+	for ( auto pairIdx = 0; pairIdx < constrainedPairs.size(); pairIdx++ )
+	{
+		const ConstrainedPair& pair = constrainedPairs[ pairIdx ];
+		const SolverBody& bodyA = solverBodies[ pair.bodyIdA ];
+		const SolverBody& bodyB = solverBodies[ pair.bodyIdB ];
+		const std::vector<Constraint>& constraints = pair.constraints;
 
-			Real bias = isContact ? 1.0f : 1.f;
+		m_pairRowStarts.push_back( ( int )m_rows.size() );
 
-			Real impulse = -1.f * ( Jv - bias*( constraint.error / info.m_deltaTime ) ) / JmJ;
+		for ( auto constraintIdx = 0; constraintIdx < constraints.size(); constraintIdx++ )
+		{
+			const Constraint& constraint = constraints[ constraintIdx ];
+			const Jacobian& jac = constraint.jac;
+			SolverRow row;
 
-			Assert( !isinf( impulse ), "infinite impulse in solver" );
-			Assert( !isnan( impulse ), "nan impulse in solver" );
+			row.bodyIdA = pair.bodyIdA;
+			row.bodyIdB = pair.bodyIdB;
+			row.isDynamicA = ( bodyA.mInv != 0.f || bodyA.iInv != 0.f );
+			row.isDynamicB = ( bodyB.mInv != 0.f || bodyB.iInv != 0.f );
 
-			if ( isContact )
-			{ 
-				Real newImpulse = std::max( pair.accumImp + impulse, 0.f );
-				impulse = newImpulse - pair.accumImp;
-				pair.accumImp = newImpulse;
-			}
+			row.jvAx = jac.vA( 0 );
+			row.jvAy = jac.vA( 1 );
+			row.jwA = jac.wA( 2 );
+			row.jvBx = jac.vB( 0 );
+			row.jvBy = jac.vB( 1 );
+			row.jwB = jac.wB( 2 );
+
+			row.mjvAx = row.jvAx * bodyA.mInv;
+			row.mjvAy = row.jvAy * bodyA.mInv;
+			row.mjwA = row.jwA * bodyA.iInv;
+			row.mjvBx = row.jvBx * bodyB.mInv;
+			row.mjvBy = row.jvBy * bodyB.mInv;
+			row.mjwB = row.jwB * bodyB.iInv;
 
-			// Impulse applied @ contact point
-//			if ( isContact )
-			if ( false )
+			Real JmJ =
+				row.jvAx * row.mjvAx + row.jvAy * row.mjvAy + row.jwA * row.mjwA +
+				row.jvBx * row.mjvBx + row.jvBy * row.mjvBy + row.jwB * row.mjwB;
+
+			// Rows between bodies which can't move don't apply anything
+			row.invEffMass = ( JmJ > 0.f ) ? 1.f / JmJ : 0.f;
+			row.bias = biasFactor * constraint.error / info.m_deltaTime;
+			row.accumImp = constraint.accumImp;
+			row.normalRowIdx = -1;
+
+			if ( !isContact )
+			{
+				row.minImp = -unbounded;
+				row.maxImp = unbounded;
+			}
+			else if ( constraintIdx % 2 == 0 )
+			{
+				// Normal, can only push
+				row.minImp = 0.f;
+				row.maxImp = unbounded;
+			}
+			else
 			{
-				drawArrow( bodyA.pos + rA_world, jac.vA * impulse * 0.01f, RED );
-				drawArrow( bodyB.pos + rB_world, jac.vB * impulse * 0.01f, BLUE );
-				drawArrow( bodyA.pos, rA_world, RED );
-				drawArrow( bodyB.pos, rB_world, BLUE );
+				// Tangent, inside friction cone of normal impulse
+				row.minImp = -pair.friction;
+				row.maxImp = pair.friction;
+				row.normalRowIdx = ( int )m_rows.size() - 1;
 			}
 
-			bodyA.v += jac.vA * impulse * bodyA.mInv;
-			bodyB.v += jac.vB * impulse * bodyB.mInv;
-			bodyA.w += jac.wA * impulse * bodyA.iInv;
-			bodyB.w += jac.wB * impulse * bodyB.iInv;
-
-			// TODO: clean-up these sanity checks
-			Assert( !bodyA.v.isInf(), "bodyA has infinite linear velocity in solver" );
-			Assert( !bodyB.v.isInf(), "bodyB has infinite linear velocity in solver" );
-			Assert( !bodyA.v.isNan(), "bodyA has nan linear velocity in solver" );
-			Assert( !bodyB.v.isNan(), "bodyB has nan linear velocity in solver" );
-			Assert( !bodyA.w.isInf(), "bodyA has infinite angular velocity in solver" );
-			Assert( !bodyB.w.isInf(), "bodyB has infinite angular velocity in solver" );
-			Assert( !bodyA.w.isNan(), "bodyA has nan angular velocity in solver" );
-			Assert( !bodyB.w.isNan(), "bodyB has nan angular velocity in solver" );
+			m_rows.push_back( row );
 		}
 	}
+
+	m_pairRowStarts.push_back( ( int )m_rows.size() );
 }
 
-void physicsSolver::solveConstraints(
+void physicsSolver::storeImpulses( std::vector<ConstrainedPair>& constrainedPairs ) const
+{
+	for ( auto pairIdx = 0; pairIdx < constrainedPairs.size(); pairIdx++ )
+	{
+		std::vector<Constraint>& constraints = constrainedPairs[ pairIdx ].constraints;
+		int rowStart = m_pairRowStarts[ pairIdx ];
+
+		for ( auto constraintIdx = 0; constraintIdx < constraints.size(); constraintIdx++ )
+		{
+			constraints[ constraintIdx ].accumImp = m_rows[ rowStart + constraintIdx ].accumImp;
+		}
+	}
+}
+
+void physicsSolver::solveColored(
 	const SolverInfo& info,
 	bool isContact,
 	std::vector<ConstrainedPair>& constrainedPairs,
 	std::vector<SolverBody>& solverBodies )
 {
-	// Solve constraints, put satisfying velocities in solver bodies
-	for ( int i = 0; i < info.m_numIter; i++ )
+	m_coloring->build( constrainedPairs, solverBodies );
+
+	// Wide contacts go through blocks of pairs instead of pairs, blocks have the same colors
+	bool isWide = isContact && m_isWide;
+
+	if ( isWide )
 	{
-		solveConstrainedPairs( info, isContact, constrainedPairs, solverBodies );
+		m_contactBatch->build( info, *m_coloring, constrainedPairs, solverBodies );
 	}
-}
\ No newline at end of file
+
+	int numThreads = ( m_isParallel && m_threadPool ) ? m_threadPool->getNumThreads() : 1;
+	const std::vector<int>& pairIndices = m_coloring->getPairIndices();
+	physicsThreadBarrier barrier( numThreads );
+
+	// Every thread goes through all colors, pairs of a color are split between threads and colors are separated by barriers.
+	// Pass -1 is the warm start of contacts
+	auto solve = [&]( const int threadIdx )
+	{
+		int numColors = m_coloring->getNumColors();
+
+		for ( int pass = isContact ? -1 : 0; pass < info.m_numIter; pass++ )
+		{
+			for ( int colorIdx = 0; colorIdx <= numColors; colorIdx++ )
+			{
+				int colorStart, colorEnd;
+
+				if ( isWide )
+				{
+					m_contactBatch->getColorRange( colorIdx, colorStart, colorEnd );
+				}
+				else
+				{
+					m_coloring->getColorRange( colorIdx, colorStart, colorEnd );
+				}
+
+				if ( colorStart == colorEnd )
+				{
+					continue;
+				}
+
+				// Overflow pairs can share bodies, first thread solves them in order
+				int start = colorStart;
+				int end = colorEnd;
+
+				if ( colorIdx < numColors )
+				{
+					physicsThreadPool::getRange( colorEnd - colorStart, threadIdx, numThreads, start, end );
+					start += colorStart;
+					end += colorStart;
+				}
+				else if ( threadIdx != 0 )
+				{
+					end = start;
+				}
+
+				for ( int i = start; i < end; i++ )
+				{
+					if ( isWide )
+					{
+						if ( pass < 0 )
+						{
+							m_contactBatch->warmStart( i, solverBodies );
+						}
+						else
+						{
+							m_contactBatch->solve( i, solverBodies );
+						}
+
+						continue;
+					}
+
+					int pairIdx = pairIndices[i];
+					int rowStart = m_pairRowStarts[pairIdx];
+					int rowEnd = m_pairRowStarts[pairIdx + 1];
+
+					if ( pass < 0 )
+					{
+						warmStartRows( m_rows.data(), rowStart, rowEnd, solverBodies );
+					}
+					else
+					{
+						solveRows( m_rows.data(), rowStart, rowEnd, solverBodies );
+					}
+				}
+
+				barrier.wait();
+			}
+		}
+	};
+
+	if ( numThreads > 1 && !constrainedPairs.empty() )
+	{
+		m_threadPool->run( solve );
+	}
+	else
+	{
+		solve( 0 );
+	}
+
+	if ( isWide )
+	{
+		m_contactBatch->storeImpulses( constrainedPairs );
+	}
+}
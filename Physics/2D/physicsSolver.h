@@ -3,6 +3,8 @@
 #include <vector>
 #include <physicsInternalTypes.h>
 
+class physicsBody;
+
 struct Jacobian
 {
 	Vector4 vA, wA, vB, wB;
@@ -13,21 +15,26 @@ struct Constraint
 	Vector4 rA, rB; // Constrained points viewed from local
 	Real error;
 	Jacobian jac;
+	Real accumImp; // Summed over iterations, contacts start from impulse cached last step
+
+	Constraint() : error( 0.f ), accumImp( 0.f ) {}
 };
 
+// Contact pairs hold normal then tangent constraint for each contact point,
+// tangent impulse is bounded by friction times normal impulse of the same point
 struct ConstrainedPair : public BodyIdPair
 {
 	std::vector<Constraint> constraints;
-	Real accumImp;
+	Real friction;
 
 	ConstrainedPair( const BodyId a = invalidId, const BodyId b = invalidId ) : 
-		BodyIdPair( a, b ), accumImp(0.f) 
+		BodyIdPair( a, b ), friction( 0.f )
 	{
 
 	}
 
 	ConstrainedPair( const BodyIdPair& other ) : 
-		BodyIdPair( other ), accumImp(0.f)
+		BodyIdPair( other ), friction( 0.f )
 	{
 
 	}
@@ -51,9 +58,43 @@ struct SolverBody
 	void setFromBody( const physicsBody& body );
 };
 
+// Constraint as iterations see it, everything that stays the same while solving is worked out once by the prepare pass.
+// Solving a row is then a dot product, a clamp and scaled adds
+struct SolverRow
+{
+	BodyId bodyIdA, bodyIdB;
+	Real jvAx, jvAy, jwA; // Jacobian
+	Real jvBx, jvBy, jwB;
+	Real mjvAx, mjvAy, mjwA; // Jacobian scaled by inverse mass and inertia, velocity change per unit of impulse
+	Real mjvBx, mjvBy, mjwB;
+	Real invEffMass;
+	Real bias; // Velocity pushing out error
+	Real minImp, maxImp; // Bounds of accumulated impulse, tangent rows scale them by impulse of their normal row
+	int normalRowIdx; // -1 unless tangent
+	bool isDynamicA, isDynamicB; // Static bodies are only read
+	Real accumImp;
+};
+
+class physicsThreadPool;
+class physicsConstraintColoring;
+class physicsContactBatch;
+
 class physicsSolver
 {
 public:
+	physicsSolver();
+	~physicsSolver();
+
+	// Not owned, parallel mode splits colors across its threads
+	void setThreadPool( physicsThreadPool* threadPool ) { m_threadPool = threadPool; }
+
+	// Parallel mode solves pairs color by color instead of in given order,
+	// results are the same for any number of threads
+	void setParallel( const bool isParallel ) { m_isParallel = isParallel; }
+
+	// Wide mode solves contacts several pairs at once in SIMD lanes, in color order like parallel mode
+	void setWide( const bool isWide ) { m_isWide = isWide; }
+
 	// Accept array of constrained pairs and solver bodies,
     // store constraint-solved velocities in solver bodies
 	void solveConstraints( 
@@ -62,4 +103,31 @@ public:
 		std::vector<ConstrainedPair>& constrainedPairs,
 		std::vector<SolverBody>& solverBodies 
 	);
+
+protected:
+	// Fills rows of constraints in pair order, m_pairRowStarts[i] is the first row of pair i
+	void prepareRows(
+		const SolverInfo& info,
+		bool isContact,
+		const std::vector<ConstrainedPair>& constrainedPairs,
+		const std::vector<SolverBody>& solverBodies
+	);
+
+	// Copies accumulated impulses of rows back to constraints they came from
+	void storeImpulses( std::vector<ConstrainedPair>& constrainedPairs ) const;
+
+	void solveColored(
+		const SolverInfo& info,
+		bool isContact,
+		std::vector<ConstrainedPair>& constrainedPairs,
+		std::vector<SolverBody>& solverBodies
+	);
+
+	physicsThreadPool* m_threadPool;
+	physicsConstraintColoring* m_coloring;
+	physicsContactBatch* m_contactBatch;
+	std::vector<SolverRow> m_rows;
+	std::vector<int> m_pairRowStarts;
+	bool m_isParallel;
+	bool m_isWide;
 };
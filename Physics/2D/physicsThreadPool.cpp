@@ -0,0 +1,119 @@
+#include <Base.h>
+
+#include <physicsThreadPool.h>
+
+physicsThreadPool::physicsThreadPool( const int numThreads ) :
+	m_numThreads( numThreads < 1 ? 1 : numThreads ),
+	m_task( nullptr ),
+	m_generation( 0 ),
+	m_numFinished( 0 ),
+	m_quit( false )
+{
+	for ( int i = 1; i < m_numThreads; i++ )
+	{
+		m_workers.push_back( std::thread( &physicsThreadPool::workerLoop, this, i ) );
+	}
+}
+
+physicsThreadPool::~physicsThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_quit = true;
+	}
+
+	m_startCondition.notify_all();
+
+	for ( auto iter = m_workers.begin(); iter != m_workers.end(); iter++ )
+	{
+		iter->join();
+	}
+}
+
+void physicsThreadPool::run( const std::function<void( const int threadIdx )>& task )
+{
+	if ( m_workers.empty() )
+	{
+		task( 0 );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_task = &task;
+		m_numFinished = 0;
+		m_generation++;
+	}
+
+	m_startCondition.notify_all();
+
+	task( 0 );
+
+	std::unique_lock<std::mutex> lock( m_mutex );
+	m_finishCondition.wait( lock, [this] { return m_numFinished == ( int )m_workers.size(); } );
+	m_task = nullptr;
+}
+
+void physicsThreadPool::getRange( const int size, const int threadIdx, const int numThreads, int& startOut, int& endOut )
+{
+	startOut = ( int )( ( long long )size * threadIdx / numThreads );
+	endOut = ( int )( ( long long )size * ( threadIdx + 1 ) / numThreads );
+}
+
+void physicsThreadPool::workerLoop( const int threadIdx )
+{
+	unsigned int lastGeneration = 0;
+
+	while ( true )
+	{
+		const std::function<void( const int threadIdx )>* task;
+
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_startCondition.wait( lock, [&] { return m_quit || m_generation != lastGeneration; } );
+
+			if ( m_quit )
+			{
+				return;
+			}
+
+			lastGeneration = m_generation;
+			task = m_task;
+		}
+
+		( *task )( threadIdx );
+
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_numFinished++;
+		}
+
+		m_finishCondition.notify_one();
+	}
+}
+
+physicsThreadBarrier::physicsThreadBarrier( const int numThreads ) :
+	m_numThreads( numThreads ),
+	m_numArrived( 0 ),
+	m_generation( 0 )
+{
+
+}
+
+void physicsThreadBarrier::wait()
+{
+	unsigned int generation = m_generation.load( std::memory_order_acquire );
+
+	if ( m_numArrived.fetch_add( 1, std::memory_order_acq_rel ) == m_numThreads - 1 )
+	{
+		// Reset before releasing others, they may arrive at next phase right away
+		m_numArrived.store( 0, std::memory_order_relaxed );
+		m_generation.fetch_add( 1, std::memory_order_release );
+		return;
+	}
+
+	while ( m_generation.load( std::memory_order_acquire ) == generation )
+	{
+		std::this_thread::yield();
+	}
+}
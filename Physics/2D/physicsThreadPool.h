@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+// Persistent worker threads for data parallel parts of the step.
+// Every run executes the task once per thread with its thread index, the calling thread takes index 0.
+// Work is split by thread index so results can be merged in thread order, independent of scheduling
+class physicsThreadPool
+{
+public:
+
+	// numThreads includes the calling thread, 1 runs everything on the calling thread
+	physicsThreadPool( const int numThreads );
+
+	~physicsThreadPool();
+
+	int getNumThreads() const { return m_numThreads; }
+
+	// Returns once task finished on all threads
+	void run( const std::function<void( const int threadIdx )>& task );
+
+	// Splits [0, size) evenly, range of thread threadIdx out of numThreads
+	static void getRange( const int size, const int threadIdx, const int numThreads, int& startOut, int& endOut );
+
+protected:
+
+	void workerLoop( const int threadIdx );
+
+	int m_numThreads;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_finishCondition;
+
+	const std::function<void( const int threadIdx )>* m_task;
+	unsigned int m_generation; // Incremented for every run, workers wait for it to change
+	int m_numFinished;
+	bool m_quit;
+};
+
+// Lets threads of a run wait for each other between dependent phases, without going back to the pool.
+// Waiting threads spin, so it's meant for short phases of a task all pool threads are running
+class physicsThreadBarrier
+{
+public:
+
+	physicsThreadBarrier( const int numThreads );
+
+	// Returns once numThreads threads called it, then barrier can be waited on again
+	void wait();
+
+protected:
+
+	int m_numThreads;
+	std::atomic<int> m_numArrived;
+	std::atomic<unsigned int> m_generation; // Incremented when last thread arrives
+};
@@ -2,51 +2,22 @@
 #include <physicsWorld.h>
 #include <Renderer.h>
 
+#include <sstream>
+
 static void drawCircleShape( const physicsCircleShape* shape, const Vector4& position )
 {
 	drawCircle( position, shape->getRadius() );
 }
 
-static void drawBoxShape( const physicsBoxShape* shape, const Vector4& position, const Real rotation )
+// Boxes and convex shapes, outline is body's local hull placed by its cached cos and sin
+static void drawPolygonShape( const physicsBody& body )
 {
-	const Vector4& he = shape->getHalfExtents();
-	// TODO: Replace with multiplication by transformation matrix
-	Vector4 posNe, posNw, posSe, posSw;
-	posNe.setRotatedDir( he, rotation );
-	posNe.setAdd( posNe, position );
-
-	posNw.setNegate( he, 0 );
-	posNw.setRotatedDir( posNw, rotation );
-	posNw.setAdd( posNw, position );
-
-	posSe.setNegate( he, 1 );
-	posSe.setRotatedDir( posSe, rotation );
-	posSe.setAdd( posSe, position );
-
-	posSw.setNegate( he );
-	posSw.setRotatedDir( posSw, rotation );
-	posSw.setAdd( posSw, position );
-
-	drawLine( posNe, posNw );
-	drawLine( posNw, posSw );
-	drawLine( posSw, posSe );
-	drawLine( posSe, posNe );
-}
-
-static void drawConvexShape( const physicsConvexShape* shape, const Vector4& position, const Real rotation )
-{
-	const std::vector<Vector4> vertices = shape->getVertices();
-	const std::vector<int>& connectivity = shape->getConnectivity();
-
-	int numConnectivity = ( int ) connectivity.size();
+	int numVertices = body.getNumWorldVertices();
 
-	for ( int i = 1; i < numConnectivity; i++ )
+	for ( int i = 0; i < numVertices; i++ )
 	{
-		Vector4 dirV0; dirV0.setRotatedDir( vertices[connectivity[i - 1]], rotation );
-		Vector4 v0; v0.setAdd( position, dirV0 );
-
-		Vector4 dirV1; dirV1.setRotatedDir( vertices[connectivity[i]], rotation );
-		Vector4 v1; v1.setAdd( position, dirV1 );
+		Vector4 v0 = body.getWorldVertex( i );
+		Vector4 v1 = body.getWorldVertex( ( i + 1 ) % numVertices );
 
 		drawLine( v0, v1 );
 
@@ -54,11 +25,6 @@ static void drawConvexShape( const physicsConvexShape* shape, const Vector4& pos
 		std::stringstream ss;
 		ss << v0;
 		drawText( ss.str(), v0 );
-
-		ss.str( "" );
-
-		ss << v1;
-		drawText( ss.str(), v1 );
 #endif
 	}
 }
@@ -66,7 +32,7 @@ static void drawConvexShape( const physicsConvexShape* shape, const Vector4& pos
 static void drawBodyTransform( const physicsBody& body )
 {
 	// Add arrow marking position and orientation of body
-	drawArrow( body.getPosition(), Vector4( 0.f, 10.f ).getRotatedDir( body.getRotation() ) );
+	drawArrow( body.getPosition(), Vector4( -10.f * body.getSinRotation(), 10.f * body.getCosRotation() ) );
 
 	Vector4 offset( 5.f, 5.f );
 	drawText( std::to_string( body.getBodyId() ), body.getPosition() + offset );
@@ -74,13 +40,31 @@ static void drawBodyTransform( const physicsBody& body )
 
 void physicsViewer::viewBroadphase( const physicsWorld* world )
 {
-	const std::vector<BroadphaseBody>& broadphaseBodies = world->getBroadphaseBodies();
+	std::vector<BroadphaseBody> broadphaseBodies;
+	world->getBroadphaseBodies( broadphaseBodies );
+
+	if ( broadphaseBodies.empty() )
+	{
+		return;
+	}
+
+	physicsAabb bounds = broadphaseBodies[0].aabb;
 
 	for ( auto iter = broadphaseBodies.begin(); iter != broadphaseBodies.end(); iter++ )
 	{
 		const physicsAabb& aabb = iter->aabb;
 		drawBox( aabb.m_max, aabb.m_min, RED );
+
+		bounds.includeAabb( aabb );
 	}
+
+	// Pair churn of last step above everything
+	const BroadphaseStats& stats = world->getBroadphaseStats();
+
+	std::stringstream ss;
+	ss << "pairs " << stats.numPairs << ", added " << stats.numAddedPairs << ", removed " << stats.numRemovedPairs
+	   << ", lost contact caches " << stats.numLostContactCaches;
+	drawText( ss.str(), Vector4( bounds.m_min( 0 ), bounds.m_max( 1 ) + 20.f ) );
 }
 
 void physicsViewer::viewShapes( const physicsWorld* world )
@@ -106,14 +90,8 @@ void physicsViewer::viewShapes( const physicsWorld* world )
 			);
 			break;
 		case physicsShape::BOX:
-			drawBoxShape( static_cast< const physicsBoxShape* >( shape ),
-				body.getPosition(), body.getRotation() 
-			);
-			break;
 		case physicsConvexShape::CONVEX:
-			drawConvexShape( static_cast< const physicsConvexShape* >( shape ),
-				body.getPosition(), body.getRotation() 
-			);
+			drawPolygonShape( body );
 			break;
 		}
 	}
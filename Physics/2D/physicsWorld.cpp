@@ -1,4 +1,5 @@
 #include <vector>
+#include <algorithm>
 
 #include <Base.h>
 #include <physicsObject.h>
@@ -15,171 +16,187 @@ class physicsWorldEx : public physicsWorld
 {
 public:
 
+	// Collider always receives shapes in order typeA, typeB, pairs in reverse order are flipped
 	void registerColliderFunc( physicsShape::Type typeA, physicsShape::Type typeB, ColliderFuncPtr func )
 	{
 		m_dispatchTable[typeA][typeB] = func;
 		m_dispatchTable[typeB][typeA] = func;
-	}
-
-	ColliderFuncPtr getCollisionFunc( const physicsBody& bodyA, const physicsBody& bodyB )
-	{
-		physicsShape::Type typeA = bodyA.getShapeType();
-		physicsShape::Type typeB = bodyB.getShapeType();
-		return m_dispatchTable[typeA][typeB];;
+		m_dispatchFlipped[typeA][typeB] = false;
+		m_dispatchFlipped[typeB][typeA] = ( typeA != typeB );
 	}
 
 	void collide();
 
-	// Accept array of indexed AABB's, return pairs which overlap
-	void collideAabbs( const std::vector<BroadphaseBody>& broadphaseBodies,
-		std::vector<BodyIdPair>& broadPhasePassedPairsOut );
+	// Registers body's current aabb and filtering info to broadphase
+	void addToBroadphase( physicsBody& body );
 
-	bool checkCollidable( BodyId bodyIdA, BodyId bodyIdB )
-	{
-		const physicsBody& bodyA = m_bodies[bodyIdA];
-		const physicsBody& bodyB = m_bodies[bodyIdB];
+	// Updates body's aabb as configured, predictive or scaled
+	void updateAabb( physicsBody& body );
 
-		if ( bodyA.getCollisionFilter() == bodyB.getCollisionFilter() )
-		{
-			return true;
-		}
+	// Runs narrowphase on all broadphase pairs, creates contact constraints
+	void collideCachedPairs();
 
-		return false;
-	}
+	// Sorts cached pairs into narrowphase buckets and circle batch
+	void bucketCachedPairs();
+
+	// Contact generation, runs on all threads and only reads cached pairs apart from their collider caches.
+	// Each thread takes its share of every bucket and outputs pairs which touch or stopped touching
+	void generateContacts();
+
+	// Collides thread's share of circle batch with SIMD kernel
+	void collideCircleBatch( const int threadIdx, const int numThreads, NarrowphaseOutput& output );
 
-	void mergeCollidableStreams(
-		const std::vector<BodyIdPair>& cachedPairs,
-		const std::vector<BodyIdPair>& newPairs );
+	// Collides thread's share of one bucket through its collider function
+	void collideBucket( physicsShape::Type typeA, physicsShape::Type typeB, const int threadIdx, const int numThreads, NarrowphaseOutput& output );
+
+	// Serial, updates manifolds from thread outputs and creates contact constraints
+	void mergeContacts();
 
 	void solve();
 
 	void updateJointConstraints();
+
+	// Dynamic bodies which are awake, solver and integration only go through these
+	void addToAwakeList( physicsBody& body );
+	void removeFromAwakeList( physicsBody& body );
+
+	// Static body moved or went away, bodies resting on it have to react
+	void wakeBodiesOverlapping( const physicsAabb& aabb );
+
+	// Bodies jointed to a static body don't share its island, moving it has to wake them directly
+	void wakeJointedBodies( BodyId bodyId );
+
+	// Advances sleep timers of awake bodies, then puts islands which rested long enough to sleep.
+	// Islands are bodies connected by this step's contacts and joints, static bodies don't connect them
+	void updateSleep();
+
+	BodyId findIslandRoot( BodyId bodyId );
 };
 
+// Static and sleeping bodies don't move, pairs of them need no narrowphase or solving
+static inline bool isResting( const physicsBody& body )
+{
+	return body.isStatic() || body.isSleeping();
+}
+
 void physicsWorldEx::collide()
 {
 	// Find new pairs in broadphase, delete caches for lost broadphase pairs
 
-	// Update broadphase AABB's
-	m_broadphaseBodies.clear(); // TODO: don't clear this, just overwrite the contents
-	for ( auto i = 0; i < m_activeBodyIds.size(); i++ )
+	// Update broadphase AABB's, static bodies are updated when moved through setPosition and sleeping ones don't move
+	for ( auto i = 0; i < m_awakeBodyIds.size(); i++ )
 	{
-		int activeBodyId = m_activeBodyIds[i];
-		physicsBody& body = m_bodies[activeBodyId];
+		physicsBody& body = m_bodies[m_awakeBodyIds[i]];
 
-		body.updateAabb(); // TODO: only update if aabb is dirty, don't update for static bodies
+		updateAabb( body );
 
-		BroadphaseBody bpBody( body.getBodyId(), body.getAabb() );
-		m_broadphaseBodies.push_back( bpBody ); // TODO: don't push_back this, just overwrite the contents
+		m_broadphase->updateBody( body.getBodyId(), body.getAabb() );
 	}
 
-	std::vector<BodyIdPair> bpPassedPairs;
-	collideAabbs( m_broadphaseBodies, bpPassedPairs );
+	m_broadphase->updatePairs( m_newPairs, m_lostPairs );
+
+	m_broadphaseStats.numAddedPairs = ( int )m_newPairs.size();
+	m_broadphaseStats.numRemovedPairs = ( int )m_lostPairs.size();
+	m_broadphaseStats.numLostContactCaches = 0;
+
+	// Remove collision caches for which we lose broadphase pair, lost pairs go first
+	// as a pair can be lost and found again within one update
+	for ( auto iter = m_lostPairs.begin(); iter != m_lostPairs.end(); iter++ )
+	{
+		const CachedPair* cachedPair = m_cachedPairs.find( *iter );
+
+		if ( cachedPair && cachedPair->numPoints > 0 )
+		{
+			m_broadphaseStats.numLostContactCaches++;
+		}
 
-	std::sort( bpPassedPairs.begin(), bpPassedPairs.end(), bodyIdPairLess );
-	std::sort( m_existingPairs.begin(), m_existingPairs.end(), bodyIdPairLess );
-	std::vector<BodyIdPair> bpLostPairs, bpRemainedPairs;
-	BodyIdPairsUtils::classifyPairSets( m_existingPairs, bpPassedPairs, bpLostPairs, bpRemainedPairs, m_newPairs );
+		m_cachedPairs.remove( *iter );
+	}
 
-	// Remove collision caches for which we lose broadphase pair
-	BodyIdPairsUtils::deletePairsBfromA( m_cachedPairs, bpLostPairs );
-	BodyIdPairsUtils::deletePairsBfromA( m_existingPairs, bpLostPairs );
+	for ( auto iter = m_newPairs.begin(); iter != m_newPairs.end(); iter++ )
+	{
+		m_cachedPairs.insert( *iter, CachedPair( *iter, m_bodies[iter->bodyIdA].getShapeType(), m_bodies[iter->bodyIdB].getShapeType() ) );
+	}
 
-	mergeCollidableStreams( m_existingPairs, m_newPairs );
+	m_broadphaseStats.numPairs = m_cachedPairs.getSize();
 
-	BodyIdPairsUtils::movePairsBtoA( m_existingPairs, m_newPairs );
+	collideCachedPairs();
 }
 
-struct aabbIndex
+void physicsWorldEx::addToBroadphase( physicsBody& body )
 {
-	int m_idx;
-	Vector4 m_part;
+	updateAabb( body );
 
-	aabbIndex( int idx, const Vector4& part ) : m_idx( idx ), m_part( part ) {}
-};
+	BroadphaseBody bpBody( body.getBodyId(), body.getAabb() );
+	bpBody.category = body.getCollisionCategory();
+	bpBody.mask = body.getCollisionMask();
+	bpBody.isStatic = body.isStatic();
 
-static bool xless( const aabbIndex& aabbIdx1, const aabbIndex& aabbIdx2 )
-{
-	return aabbIdx1.m_part( 0 ) < aabbIdx2.m_part( 0 );
+	m_broadphase->addBody( bpBody );
 }
 
-static bool yless( const aabbIndex& aabbIdx1, const aabbIndex& aabbIdx2 )
+void physicsWorldEx::updateAabb( physicsBody& body )
 {
-	return aabbIdx1.m_part( 1 ) < aabbIdx2.m_part( 1 );
+	if ( m_predictiveAabbs )
+	{
+		body.updatePredictiveAabb( m_solverInfo.m_deltaTime, m_predictiveAabbMargin );
+	}
+	else
+	{
+		body.updateAabb();
+	}
 }
 
-void physicsWorldEx::collideAabbs( const std::vector<BroadphaseBody>& broadphaseBodies,
-								   std::vector<BodyIdPair>& broadPhasePassedPairsOut )
+void CachedPair::updateManifold( const ContactManifold& contacts )
 {
-	// Do 1D sweep & prune, add pairs which have overlapping AABB's
-	std::vector<aabbIndex> aabbIndices; // TODO: don't keep reconstructing this vector, store it and re-use
-
-	int numBpBodies = ( int )broadphaseBodies.size();
-
-	for ( int i = 0; i < numBpBodies; i++ )
+	// Most broadphase pairs don't touch
+	if ( contacts.isEmpty() )
 	{
-		const BroadphaseBody& bpBody = broadphaseBodies[i];
-
-		aabbIndex idxMin( bpBody.bodyId, bpBody.aabb.m_min );
-		aabbIndex idxMax( bpBody.bodyId, bpBody.aabb.m_max );
-		aabbIndices.push_back( idxMin );
-		aabbIndices.push_back( idxMax );
+		numPoints = 0;
+		return;
 	}
 
-	std::sort( aabbIndices.begin(), aabbIndices.end(), xless );
+	ManifoldPoint newPoints[ContactManifold::MAX_CONTACTS];
 
-	std::vector<bool> flags( numBpBodies, false );
-
-	for ( int i = 0; i < ( int )aabbIndices.size(); i++ )
+	for ( int i = 0; i < contacts.getNumContacts(); i++ )
 	{
-		if ( aabbIndices[i].m_idx == -1 ) continue;
-
-		std::fill( flags.begin(), flags.end(), false );
+		newPoints[i].contact = contacts[i];
 
-		for ( int j = i + 1; j < ( int )aabbIndices.size(); j++ )
+		// Nothing to match by, starts from zero impulses
+		if ( contacts[i].getFeatureId() == ContactPoint::INVALID_FEATURE_ID )
 		{
-			if ( aabbIndices[j].m_idx == -1 ) continue;
+			continue;
+		}
 
-			if ( aabbIndices[i].m_idx == aabbIndices[j].m_idx )
+		for ( int j = 0; j < numPoints; j++ )
+		{
+			if ( points[j].contact.getFeatureId() == contacts[i].getFeatureId() )
 			{
-				aabbIndices[i].m_idx = -1;
-				aabbIndices[j].m_idx = -1;
+				newPoints[i].normalImpulse = points[j].normalImpulse;
+				newPoints[i].tangentImpulse = points[j].tangentImpulse;
 				break;
 			}
+		}
+	}
 
-			if ( flags[aabbIndices[j].m_idx] ) continue;
-
-			const physicsBody& bodyA = m_bodies[aabbIndices[i].m_idx];
-			const physicsBody& bodyB = m_bodies[aabbIndices[j].m_idx];
-
-			if ( bodyA.isStatic() && bodyB.isStatic() ) continue;
-
-			if ( !checkCollidable( bodyA.getBodyId(), bodyB.getBodyId() ) ) continue;
-
-			physicsAabb aabbA = bodyA.getAabb();
-			physicsAabb aabbB = bodyB.getAabb();
-
-			if ( aabbA.overlaps( aabbB ) )
-			{
-				BodyIdPair pair( bodyA.getBodyId(), bodyB.getBodyId() );
-
-				broadPhasePassedPairsOut.push_back( pair );
+	numPoints = contacts.getNumContacts();
 
-				flags[bodyB.getBodyId()] = true;
-			}
-		}
+	for ( int i = 0; i < numPoints; i++ )
+	{
+		points[i] = newPoints[i];
 	}
 }
 
-void setAsContact( Constraint& constraint, const ContactPoint& contact, const Real rotA, const Real rotB )
+// Arms are rotated by bodies' cached cos and sin
+void setAsContact( Constraint& constraint, const ContactPoint& contact, const physicsBody& bodyA, const physicsBody& bodyB )
 {
 	constraint.rA = contact.getContactA();
 	constraint.rB = contact.getContactB();
 	constraint.error = contact.getDepth();
 
 	Vector4 norm = contact.getNormal(); norm.normalize<2>();
-	const Vector4& rA_ws = constraint.rA.getRotatedDir( rotA );
-	const Vector4& rB_ws = constraint.rB.getRotatedDir( rotB );
+	Vector4 rA_ws; bodyA.getWorldDir( constraint.rA, rA_ws );
+	Vector4 rB_ws; bodyB.getWorldDir( constraint.rB, rB_ws );
 
 	constraint.jac.vA = norm.getNegated();
 	constraint.jac.vB = norm;
@@ -187,231 +204,426 @@ void setAsContact( Constraint& constraint, const ContactPoint& contact, const Re
 	constraint.jac.wB = rB_ws.cross( constraint.jac.vB );
 }
 
-void setAsFriction( Constraint& constraint, const ContactPoint& contact, const Real rotA, const Real rotB )
+void setAsFriction( Constraint& constraint, const ContactPoint& contact, const physicsBody& bodyA, const physicsBody& bodyB )
 {
 	constraint.rA = contact.getContactA();
 	constraint.rB = contact.getContactB();
 	constraint.error = 0.f;
 
-	Transform tangential; tangential.setRotation( 90.f * g_degToRad );
-	Transform tA; tA.setRotation( rotA );
-	Transform tB; tB.setRotation( rotB );
-
 	Vector4 norm = contact.getNormal(); norm.normalize<2>();
-	Vector4 rA_ws; rA_ws.setTransformedPos( tA, constraint.rA );
-	Vector4 rB_ws; rB_ws.setTransformedPos( tB, constraint.rB );
+	Vector4 rA_ws; bodyA.getWorldDir( constraint.rA, rA_ws );
+	Vector4 rB_ws; bodyB.getWorldDir( constraint.rB, rB_ws );
 
-	constraint.jac.vA.setTransformedPos( tangential, norm.getNegated() );
+	// Negated normal turned by 90 degrees
+	constraint.jac.vA.set( norm( 1 ), -norm( 0 ) );
 	constraint.jac.vB = constraint.jac.vA.getNegated();
 	constraint.jac.wA = rA_ws.cross( constraint.jac.vA );
 	constraint.jac.wB = rB_ws.cross( constraint.jac.vB );
 }
 
-void physicsWorldEx::mergeCollidableStreams( const std::vector<BodyIdPair>& existingPairs,
-											 const std::vector<BodyIdPair>& newPairs )
+void physicsWorldEx::bucketCachedPairs()
 {
-	auto iterExisting = existingPairs.begin();
-	auto iterNew = newPairs.begin();
-	auto iterCached = m_cachedPairs.begin();
+	for ( int typeA = 0; typeA < physicsShape::NUM_SHAPES; typeA++ )
+	{
+		for ( int typeB = 0; typeB < physicsShape::NUM_SHAPES; typeB++ )
+		{
+			m_narrowphaseBuckets[typeA][typeB].clear();
+		}
+	}
 
-	std::vector<CachedPair> pairsCachedThisFrame;
+	m_circleBatchSlots.clear();
+	m_circlesWithPoints.clear();
+	m_restingTouchingSlots.clear();
 
-	while ( true )
+	// Enough for all pairs, trimmed to circle pairs after
+	m_circleBatch.resize( m_cachedPairs.getSize() );
+
+	for ( int slotIdx = 0; slotIdx < m_cachedPairs.getNumSlots(); slotIdx++ )
 	{
-		if ( iterExisting == existingPairs.end() && iterNew == newPairs.end() )
+		if ( !m_cachedPairs.isSlotUsed( slotIdx ) )
 		{
-			break;
+			continue;
 		}
 
-		BodyIdPair currentPair;
+		const CachedPair& cachedPair = m_cachedPairs.getSlotValue( slotIdx );
+		physicsShape::Type typeA = cachedPair.shapeTypeA;
+		physicsShape::Type typeB = cachedPair.shapeTypeB;
 
-		if ( iterExisting != existingPairs.end() && iterNew != newPairs.end() )
-		{
-			Assert( *iterExisting != *iterNew, "can't have same pairs both existing and new" );
+		const physicsBody& bodyA = m_bodies[cachedPair.bodyIdA];
+		const physicsBody& bodyB = m_bodies[cachedPair.bodyIdB];
 
-			if ( *iterExisting < *iterNew )
+		if ( isResting( bodyA ) && isResting( bodyB ) )
+		{
+			// Contacts cached when the island fell asleep still hold, merge picks them up if it wakes
+			if ( cachedPair.numPoints > 0 )
 			{
-				currentPair = *iterExisting;
-				iterExisting++;
+				m_restingTouchingSlots.push_back( slotIdx );
 			}
-			else
+
+			continue;
+		}
+
+		if ( typeA == physicsShape::CIRCLE && typeB == physicsShape::CIRCLE )
+		{
+			// Gathered while the slot is at hand, so batch doesn't need another pass over pair map
+			int batchIdx = ( int )m_circleBatchSlots.size();
+
+			m_circleBatch.set( batchIdx,
+							   bodyA.getPosition(), static_cast< const physicsCircleShape* >( bodyA.getShape() )->getRadius(),
+							   bodyB.getPosition(), static_cast< const physicsCircleShape* >( bodyB.getShape() )->getRadius() );
+
+			m_circleBatchSlots.push_back( slotIdx );
+
+			if ( cachedPair.numPoints > 0 )
 			{
-				currentPair = *iterNew;
-				iterNew++;
+				m_circlesWithPoints.push_back( batchIdx );
 			}
 		}
 		else
 		{
-			if ( iterExisting != existingPairs.end() )
-			{
-				currentPair = *iterExisting;
-				iterExisting++;
-			}
-			else
-			{
-				currentPair = *iterNew;
-				iterNew++;
-			}
+			m_narrowphaseBuckets[typeA][typeB].push_back( slotIdx );
 		}
+	}
 
-		const physicsBody& bodyA = m_bodies[currentPair.bodyIdA];
-		const physicsBody& bodyB = m_bodies[currentPair.bodyIdB];
-		Transform transformA( bodyA.getPosition(), bodyA.getRotation() );
-		Transform transformB( bodyB.getPosition(), bodyB.getRotation() );
+	m_circleBatch.resize( ( int )m_circleBatchSlots.size() );
+}
+
+void physicsWorldEx::collideCircleBatch( const int threadIdx, const int numThreads, NarrowphaseOutput& output )
+{
+	// Split by whole kernel widths, so no two threads store results of the same lanes
+	int numBlocks = ( m_circleBatch.getSize() + physicsCircleBatch::WIDTH - 1 ) / physicsCircleBatch::WIDTH;
+	int startBlock, endBlock;
+	physicsThreadPool::getRange( numBlocks, threadIdx, numThreads, startBlock, endBlock );
 
-		ColliderFuncPtr colliderFuncPtr = getCollisionFunc( bodyA, bodyB );
+	int start = startBlock * physicsCircleBatch::WIDTH;
+	int end = std::min( endBlock * physicsCircleBatch::WIDTH, m_circleBatch.getSize() );
 
-		std::vector<ContactPoint> contacts;
-		colliderFuncPtr( bodyA.getShape(), bodyB.getShape(), transformA, transformB, contacts );
+	std::vector<int>& touchingCircles = output.touchingCircles;
+	touchingCircles.clear();
+	m_circleBatch.collide( start, end, touchingCircles );
 
-		bool canUseCache = false;
+	// Pairs which stopped touching drop their contact, both lists are ascending.
+	// Pairs which didn't touch last step either aren't output at all
+	auto touchingIter = touchingCircles.begin();
+	auto withPointsIter = std::lower_bound( m_circlesWithPoints.begin(), m_circlesWithPoints.end(), start );
 
-		if ( iterCached != m_cachedPairs.end() )
+	for ( ; withPointsIter != m_circlesWithPoints.end() && *withPointsIter < end; withPointsIter++ )
+	{
+		while ( touchingIter != touchingCircles.end() && *touchingIter < *withPointsIter )
 		{
-			if ( currentPair == *iterCached )
-			{
-				canUseCache = true;
+			touchingIter++;
+		}
 
-				// Clean up cache
-				
-			}
+		if ( touchingIter == touchingCircles.end() || *touchingIter != *withPointsIter )
+		{
+			output.slots.push_back( m_circleBatchSlots[*withPointsIter] );
+			output.manifolds.push_back( ContactManifold() );
 		}
+	}
+
+	for ( auto iter = touchingCircles.begin(); iter != touchingCircles.end(); iter++ )
+	{
+		int batchIdx = *iter;
+		const CachedPair& cachedPair = m_cachedPairs.getSlotValue( m_circleBatchSlots[batchIdx] );
+
+		const physicsBody& bodyA = m_bodies[cachedPair.bodyIdA];
+		const physicsBody& bodyB = m_bodies[cachedPair.bodyIdB];
+
+		Vector4 norm = m_circleBatch.getNormal( batchIdx );
+
+		// Same contact as physicsCircleCollider, deepest points of each circle seen by its body
+		Vector4 cpAinA; bodyA.getLocalDir( norm * m_circleBatch.getRadiusA( batchIdx ), cpAinA );
+		Vector4 cpBinB; bodyB.getLocalDir( norm.getNegated() * m_circleBatch.getRadiusB( batchIdx ), cpBinB );
+
+		output.slots.push_back( m_circleBatchSlots[batchIdx] );
+		output.manifolds.push_back( ContactManifold() );
+		output.manifolds.back().addContact( ContactPoint( m_circleBatch.getDepth( batchIdx ), cpAinA, cpBinB, norm ) );
+	}
+}
+
+void physicsWorldEx::collideBucket( physicsShape::Type typeA, physicsShape::Type typeB, const int threadIdx, const int numThreads, NarrowphaseOutput& output )
+{
+	const std::vector<int>& bucket = m_narrowphaseBuckets[typeA][typeB];
+
+	int start, end;
+	physicsThreadPool::getRange( ( int )bucket.size(), threadIdx, numThreads, start, end );
+
+	if ( start == end )
+	{
+		return;
+	}
+
+	// Same collider for whole bucket
+	ColliderFuncPtr colliderFuncPtr = m_dispatchTable[typeA][typeB];
+	bool flipped = m_dispatchFlipped[typeA][typeB];
+
+	ContactManifold contacts;
+
+	for ( int i = start; i < end; i++ )
+	{
+		// Collider cache is only written by the thread colliding its pair
+		CachedPair& cachedPair = m_cachedPairs.getSlotValue( bucket[i] );
+
+		const physicsBody& bodyA = m_bodies[cachedPair.bodyIdA];
+		const physicsBody& bodyB = m_bodies[cachedPair.bodyIdB];
+
+		// From cached cos and sin, colliders only read transforms' matrices
+		Transform transformA; bodyA.getTransform( transformA );
+		Transform transformB; bodyB.getTransform( transformB );
 
-		if ( canUseCache )
+		contacts.clear();
+
+		if ( flipped )
 		{
-			if ( contacts.size() > 0 )
+			colliderFuncPtr( bodyB.getShape(), bodyA.getShape(), transformB, transformA, contacts, &cachedPair.colliderCache );
+
+			for ( int j = 0; j < contacts.getNumContacts(); j++ )
 			{
-				iterCached->addContact( contacts[0] );
+				contacts[j].flip();
+			}
+		}
+		else
+		{
+			colliderFuncPtr( bodyA.getShape(), bodyB.getShape(), transformA, transformB, contacts, &cachedPair.colliderCache );
+		}
 
-				// Add new contact constraint
-				ConstrainedPair constrainedPair( currentPair );
+		// Non-touching pairs only need merging if they lose points
+		if ( !contacts.isEmpty() || cachedPair.numPoints > 0 )
+		{
+			output.slots.push_back( bucket[i] );
+			output.manifolds.push_back( contacts );
+		}
+	}
+}
 
-				constrainedPair.accumImp = iterCached->accumImp;  // re-use impulse
-				//drawText( std::to_string( constrainedPair.accumImp ), Vector3( 50.f, 50.f ) );
+void physicsWorldEx::generateContacts()
+{
+	int numThreads = m_threadPool->getNumThreads();
 
-				Constraint contactA;
-				//setAsContact( constraint0, iterCached->cpA, bodyA.getRotation(), bodyB.getRotation() );
-				setAsContact( contactA, contacts[0], bodyA.getRotation(), bodyB.getRotation() );
-				constrainedPair.constraints.push_back( contactA );
+	m_narrowphaseOutputs.resize( numThreads );
 
-				Constraint frictionA;
-				setAsFriction( frictionA, contacts[0], bodyA.getRotation(), bodyB.getRotation() );
-				constrainedPair.constraints.push_back( frictionA );
+	auto generate = [this, numThreads]( const int threadIdx )
+	{
+		NarrowphaseOutput& output = m_narrowphaseOutputs[threadIdx];
+		output.slots.clear();
+		output.manifolds.clear();
 
-				if ( false )
-				//if ( iterCached->numContacts == 2 )
-				{
-					Constraint constraint1;
-					setAsContact( constraint1, iterCached->cpB, bodyA.getRotation(), bodyB.getRotation() );
-					constrainedPair.constraints.push_back( constraint1 );
-				}
+		collideCircleBatch( threadIdx, numThreads, output );
 
-				m_contactSolvePairs.push_back( constrainedPair );
+		for ( int typeA = 0; typeA < physicsShape::NUM_SHAPES; typeA++ )
+		{
+			for ( int typeB = 0; typeB < physicsShape::NUM_SHAPES; typeB++ )
+			{
+				collideBucket( ( physicsShape::Type )typeA, ( physicsShape::Type )typeB, threadIdx, numThreads, output );
 			}
-
-			iterCached++;
 		}
-		else
+	};
+
+	if ( numThreads > 1 )
+	{
+		m_threadPool->run( generate );
+	}
+	else
+	{
+		generate( 0 );
+	}
+}
+
+void physicsWorldEx::mergeContacts()
+{
+	// Every output pair belongs to one thread, so merge order doesn't change results
+	m_touchingSlots.clear();
+
+	for ( auto output = m_narrowphaseOutputs.begin(); output != m_narrowphaseOutputs.end(); output++ )
+	{
+		for ( int i = 0; i < ( int )output->slots.size(); i++ )
 		{
-			if ( contacts.size() > 0 )
+			CachedPair& cachedPair = m_cachedPairs.getSlotValue( output->slots[i] );
+			cachedPair.updateManifold( output->manifolds[i] );
+
+			if ( cachedPair.numPoints > 0 )
 			{
-				CachedPair cachedPair( currentPair );
-				cachedPair.addContact( contacts[0] );
-				pairsCachedThisFrame.push_back( cachedPair );
+				m_touchingSlots.push_back( output->slots[i] );
+			}
+		}
+	}
+
+	// Awake bodies touching sleeping ones wake their islands
+	bool wokeIslands = false;
 
-				// Add new contact constraint
-				ConstrainedPair constrainedPair( currentPair );
+	for ( auto iter = m_touchingSlots.begin(); iter != m_touchingSlots.end(); iter++ )
+	{
+		const CachedPair& cachedPair = m_cachedPairs.getSlotValue( *iter );
+
+		if ( m_bodies[cachedPair.bodyIdA].isSleeping() || m_bodies[cachedPair.bodyIdB].isSleeping() )
+		{
+			wakeBody( cachedPair.bodyIdA );
+			wakeBody( cachedPair.bodyIdB );
+			wokeIslands = true;
+		}
+	}
 
-				Constraint constraint;
-				setAsContact( constraint, contacts[0], bodyA.getRotation(), bodyB.getRotation() );
-				constrainedPair.constraints.push_back( constraint );
+	if ( wokeIslands )
+	{
+		// Contacts inside woken islands and against static bodies weren't generated this step, cached ones still hold.
+		// Touching dynamic bodies share an island, so waking the other side is only a safeguard
+		for ( auto iter = m_restingTouchingSlots.begin(); iter != m_restingTouchingSlots.end(); iter++ )
+		{
+			const CachedPair& cachedPair = m_cachedPairs.getSlotValue( *iter );
 
-				m_contactSolvePairs.push_back( constrainedPair );
+			if ( !isResting( m_bodies[cachedPair.bodyIdA] ) || !isResting( m_bodies[cachedPair.bodyIdB] ) )
+			{
+				wakeBody( cachedPair.bodyIdA );
+				wakeBody( cachedPair.bodyIdB );
+				m_touchingSlots.push_back( *iter );
 			}
 		}
 	}
 
-	BodyIdPairsUtils::movePairsBtoA( m_cachedPairs, pairsCachedThisFrame );
-	std::sort( m_cachedPairs.begin(), m_cachedPairs.end(), bodyIdPairLess );
+	// Constraints are built in slot order, so solver sees pairs in the same order however they were split
+	std::sort( m_touchingSlots.begin(), m_touchingSlots.end() );
+
+	for ( auto iter = m_touchingSlots.begin(); iter != m_touchingSlots.end(); iter++ )
+	{
+		const CachedPair& cachedPair = m_cachedPairs.getSlotValue( *iter );
+		const BodyIdPair& currentPair = cachedPair;
+
+		const physicsBody& bodyA = m_bodies[currentPair.bodyIdA];
+		const physicsBody& bodyB = m_bodies[currentPair.bodyIdB];
+
+		// Add new contact constraints, impulses are warm started from manifold
+		ConstrainedPair constrainedPair( currentPair );
+		constrainedPair.friction = sqrt( bodyA.getFriction() * bodyB.getFriction() );
+
+		for ( int i = 0; i < cachedPair.numPoints; i++ )
+		{
+			const ManifoldPoint& point = cachedPair.points[i];
+
+			Constraint contact;
+			setAsContact( contact, point.contact, bodyA, bodyB );
+			contact.accumImp = point.normalImpulse;
+			constrainedPair.constraints.push_back( contact );
+
+			Constraint friction;
+			setAsFriction( friction, point.contact, bodyA, bodyB );
+			friction.accumImp = point.tangentImpulse;
+			constrainedPair.constraints.push_back( friction );
+		}
+
+		m_contactSolvePairs.push_back( constrainedPair );
+	}
 }
 
-void physicsWorldEx::solve()
+void physicsWorldEx::collideCachedPairs()
 {
-	int numActiveBodies = ( int )m_activeBodyIds.size();
+	bucketCachedPairs();
+
+	generateContacts();
 
-	m_solverBodies.resize( numActiveBodies );
+	mergeContacts();
+}
 
-	for ( int i = 0; i < numActiveBodies; i++ )
+void physicsWorldEx::solve()
+{
+	// Indexed by body Id, only awake bodies and static bodies in constraints are filled
+	m_solverBodies.resize( m_bodies.size() );
+
+	for ( int i = 0; i < ( int )m_awakeBodyIds.size(); i++ )
 	{
-		int activeBodyId = m_activeBodyIds[i];
-		physicsBody& body = m_bodies[activeBodyId];
+		physicsBody& body = m_bodies[m_awakeBodyIds[i]];
 
 		// Apply gravity
-		if ( !body.isStatic() )
+		const Vector4& currLinVel = body.getLinearVelocity();
+		body.setLinearVelocity( currLinVel + m_gravity * m_solverInfo.m_deltaTime );
+
+		// Prepare solver bodies
+		m_solverBodies[body.getBodyId()].setFromBody( body );
+	}
+
+	// Joints of sleeping islands are left out
+	m_awakeJointPairs.clear();
+
+	for ( auto iter = m_jointSolvePairs.begin(); iter != m_jointSolvePairs.end(); iter++ )
+	{
+		if ( !isResting( m_bodies[iter->bodyIdA] ) || !isResting( m_bodies[iter->bodyIdB] ) )
 		{
-			const Vector4& currLinVel = body.getLinearVelocity();
-			body.setLinearVelocity( currLinVel + m_gravity * m_solverInfo.m_deltaTime );
+			m_awakeJointPairs.push_back( *iter );
 		}
+	}
 
-		// Prepare solver bodies
-		m_solverBodies[i].setFromBody( body );
+	std::vector<ConstrainedPair>* solvePairLists[] = { &m_contactSolvePairs, &m_awakeJointPairs };
+
+	for ( int listIdx = 0; listIdx < 2; listIdx++ )
+	{
+		for ( auto iter = solvePairLists[listIdx]->begin(); iter != solvePairLists[listIdx]->end(); iter++ )
+		{
+			const physicsBody& bodyA = m_bodies[iter->bodyIdA];
+			const physicsBody& bodyB = m_bodies[iter->bodyIdB];
+
+			if ( bodyA.isStatic() )
+			{
+				m_solverBodies[iter->bodyIdA].setFromBody( bodyA );
+			}
+
+			if ( bodyB.isStatic() )
+			{
+				m_solverBodies[iter->bodyIdB].setFromBody( bodyB );
+			}
+		}
 	}
 
 	updateJointConstraints();
 
 	// Solve constraints
 	m_solver->solveConstraints( m_solverInfo, true, m_contactSolvePairs, m_solverBodies );
-	m_solver->solveConstraints( m_solverInfo, false, m_jointSolvePairs, m_solverBodies );
+	m_solver->solveConstraints( m_solverInfo, false, m_awakeJointPairs, m_solverBodies );
 
-	// Store contact impulses
+	// Store contact impulses in manifolds for next step, constraints are in the same order as manifold points
+	for ( auto iter = m_contactSolvePairs.begin(); iter != m_contactSolvePairs.end(); iter++ )
 	{
-		auto contactIter = m_contactSolvePairs.begin();
-		auto cacheIter = m_cachedPairs.begin();
+		CachedPair* cachedPair = m_cachedPairs.find( *iter );
+		Assert( cachedPair, "contact constraint without collision cache" );
 
-		while ( contactIter != m_contactSolvePairs.end() )
+		for ( int i = 0; i < cachedPair->numPoints; i++ )
 		{
-			if ( *contactIter == *cacheIter )
-			{
-				cacheIter->accumImp = contactIter->accumImp;
-				contactIter++;
-			}
-
-			cacheIter++;
+			cachedPair->points[i].normalImpulse = iter->constraints[2 * i].accumImp;
+			cachedPair->points[i].tangentImpulse = iter->constraints[2 * i + 1].accumImp;
 		}
 	}
 
-	m_contactSolvePairs.clear();
-
 	// Update body velocities
-	for ( int activeBodyIdsIdx = 0; activeBodyIdsIdx < ( int ) m_solverBodies.size(); activeBodyIdsIdx++ )
+	for ( int i = 0; i < ( int )m_awakeBodyIds.size(); i++ )
 	{
-		const SolverBody& solverBody = m_solverBodies[activeBodyIdsIdx];
-		physicsBody& body = m_bodies[activeBodyIdsIdx];
-		body.setFromSolverBody( solverBody );
+		physicsBody& body = m_bodies[m_awakeBodyIds[i]];
+		body.setFromSolverBody( m_solverBodies[body.getBodyId()] );
 	}
 
 	// Integrate time
-	for ( int i = 0; i < ( int )m_activeBodyIds.size(); i++ )
+	for ( int i = 0; i < ( int )m_awakeBodyIds.size(); i++ )
 	{
-		int activeBodyId = m_activeBodyIds[i];
-		physicsBody& body = m_bodies[activeBodyId];
+		physicsBody& body = m_bodies[m_awakeBodyIds[i]];
 
-		if ( !body.isStatic() )
-		{
-			const Vector4& linVel = body.getLinearVelocity();
-			const Vector4& pos = body.getPosition();
-			body.setPosition( pos + linVel * m_solverInfo.m_deltaTime );
+		const Vector4& linVel = body.getLinearVelocity();
+		const Vector4& pos = body.getPosition();
+		body.setPosition( pos + linVel * m_solverInfo.m_deltaTime );
 
-			const Real& w = body.getAngularSpeed();
-			const Real& rot = body.getRotation();
-			body.setRotation( rot + w * m_solverInfo.m_deltaTime );
-		}
+		const Real& w = body.getAngularSpeed();
+		const Real& rot = body.getRotation();
+		body.setRotation( rot + w * m_solverInfo.m_deltaTime );
+
+		// Colliders, aabb's and queries use pose cached here until next step
+		body.updatePose();
 	}
+
+	// Islands come from this step's constraints
+	updateSleep();
+
+	m_contactSolvePairs.clear();
 }
 
 void physicsWorldEx::updateJointConstraints()
 {
-	for ( auto iterJoint = m_jointSolvePairs.begin(); iterJoint != m_jointSolvePairs.end(); iterJoint++ )
+	for ( auto iterJoint = m_awakeJointPairs.begin(); iterJoint != m_awakeJointPairs.end(); iterJoint++ )
 	{
 		const physicsBody& bodyA = m_bodies[iterJoint->bodyIdA];
 		const physicsBody& bodyB = m_bodies[iterJoint->bodyIdB];
@@ -439,13 +651,177 @@ void physicsWorldEx::updateJointConstraints()
 	}
 }
 
+void physicsWorldEx::addToAwakeList( physicsBody& body )
+{
+	body.setAwakeListIdx( ( unsigned int )m_awakeBodyIds.size() );
+	m_awakeBodyIds.push_back( body.getBodyId() );
+}
+
+void physicsWorldEx::removeFromAwakeList( physicsBody& body )
+{
+	unsigned int awakeListIdx = body.getAwakeListIdx();
+	BodyId lastBodyId = m_awakeBodyIds.back();
+
+	m_awakeBodyIds[awakeListIdx] = lastBodyId;
+	m_bodies[lastBodyId].setAwakeListIdx( awakeListIdx );
+	m_awakeBodyIds.pop_back();
+}
+
+void physicsWorldEx::wakeBodiesOverlapping( const physicsAabb& aabb )
+{
+	std::vector<BodyId> bodyIds;
+	m_broadphase->queryAabb( aabb, bodyIds );
+
+	for ( auto iter = bodyIds.begin(); iter != bodyIds.end(); iter++ )
+	{
+		wakeBody( *iter );
+	}
+}
+
+void physicsWorldEx::wakeJointedBodies( BodyId bodyId )
+{
+	for ( auto iter = m_jointSolvePairs.begin(); iter != m_jointSolvePairs.end(); iter++ )
+	{
+		if ( iter->bodyIdA == bodyId )
+		{
+			wakeBody( iter->bodyIdB );
+		}
+		else if ( iter->bodyIdB == bodyId )
+		{
+			wakeBody( iter->bodyIdA );
+		}
+	}
+}
+
+BodyId physicsWorldEx::findIslandRoot( BodyId bodyId )
+{
+	while ( m_islandParents[bodyId] != bodyId )
+	{
+		// Path halving
+		m_islandParents[bodyId] = m_islandParents[m_islandParents[bodyId]];
+		bodyId = m_islandParents[bodyId];
+	}
+
+	return bodyId;
+}
+
+void physicsWorldEx::updateSleep()
+{
+	if ( !m_allowSleeping )
+	{
+		return;
+	}
+
+	m_islandParents.resize( m_bodies.size() );
+	m_islandSleepTimes.resize( m_bodies.size() );
+	m_islandHeads.resize( m_bodies.size() );
+
+	for ( auto iter = m_awakeBodyIds.begin(); iter != m_awakeBodyIds.end(); iter++ )
+	{
+		physicsBody& body = m_bodies[*iter];
+		body.updateSleepTime( m_solverInfo.m_deltaTime, m_sleepLinearTolerance, m_sleepAngularTolerance, m_sleepLinearSpeed, m_sleepAngularSpeed );
+
+		m_islandParents[*iter] = *iter;
+		m_islandSleepTimes[*iter] = body.getSleepTime();
+		m_islandHeads[*iter] = invalidId;
+	}
+
+	// Static bodies would tie everything resting on them into one island, sleeping ones can't be in this step's pairs
+	std::vector<ConstrainedPair>* solvePairLists[] = { &m_contactSolvePairs, &m_awakeJointPairs };
+
+	for ( int listIdx = 0; listIdx < 2; listIdx++ )
+	{
+		for ( auto iter = solvePairLists[listIdx]->begin(); iter != solvePairLists[listIdx]->end(); iter++ )
+		{
+			if ( isResting( m_bodies[iter->bodyIdA] ) || isResting( m_bodies[iter->bodyIdB] ) )
+			{
+				continue;
+			}
+
+			BodyId rootA = findIslandRoot( iter->bodyIdA );
+			BodyId rootB = findIslandRoot( iter->bodyIdB );
+
+			if ( rootA != rootB )
+			{
+				m_islandParents[rootA] = rootB;
+			}
+		}
+	}
+
+	// Island can sleep once its least rested body can
+	for ( auto iter = m_awakeBodyIds.begin(); iter != m_awakeBodyIds.end(); iter++ )
+	{
+		BodyId root = findIslandRoot( *iter );
+		m_islandSleepTimes[root] = std::min( m_islandSleepTimes[root], m_islandSleepTimes[*iter] );
+	}
+
+	// Members of sleeping islands are linked in a ring, waking any of them walks it.
+	// Removing swaps the last awake body in, so index only moves on for bodies which stay awake
+	for ( int i = 0; i < ( int )m_awakeBodyIds.size(); )
+	{
+		BodyId bodyId = m_awakeBodyIds[i];
+		BodyId root = findIslandRoot( bodyId );
+
+		if ( m_islandSleepTimes[root] < m_timeToSleep )
+		{
+			i++;
+			continue;
+		}
+
+		physicsBody& body = m_bodies[bodyId];
+		body.setSleeping( true );
+
+		if ( m_islandHeads[root] == invalidId )
+		{
+			m_islandHeads[root] = bodyId;
+			body.setNextInIsland( bodyId );
+		}
+		else
+		{
+			physicsBody& head = m_bodies[m_islandHeads[root]];
+			body.setNextInIsland( head.getNextInIsland() );
+			head.setNextInIsland( bodyId );
+		}
+
+		removeFromAwakeList( body );
+	}
+}
+
 physicsWorld::physicsWorld( const physicsWorldConfig& cinfo ) :
 	m_gravity( cinfo.m_gravity ),
 	m_cor( cinfo.m_cor ),
+	m_predictiveAabbs( cinfo.m_predictiveAabbs ),
+	m_predictiveAabbMargin( cinfo.m_predictiveAabbMargin ),
+	m_allowSleeping( cinfo.m_allowSleeping ),
+	m_sleepLinearTolerance( cinfo.m_sleepLinearTolerance ),
+	m_sleepAngularTolerance( cinfo.m_sleepAngularTolerance ),
+	m_sleepLinearSpeed( cinfo.m_sleepLinearSpeed ),
+	m_sleepAngularSpeed( cinfo.m_sleepAngularSpeed ),
+	m_timeToSleep( cinfo.m_timeToSleep ),
 	m_firstFreeBodyId( 0 )
 {
 	m_solver = new physicsSolver;
 
+	switch ( cinfo.m_broadphaseType )
+	{
+	case physicsBroadphase::HASH_GRID:
+		m_broadphase = new physicsHashGrid( cinfo.m_broadphaseCellSize );
+		break;
+	case physicsBroadphase::AABB_TREE:
+		m_broadphase = new physicsAabbTreeBroadphase( cinfo.m_broadphaseTreeMargin );
+		break;
+	case physicsBroadphase::SWEEP_AND_PRUNE:
+	default:
+		m_broadphase = new physicsSweepAndPrune;
+		break;
+	}
+
+	m_threadPool = new physicsThreadPool( cinfo.m_numThreads );
+	m_broadphase->setThreadPool( m_threadPool );
+	m_solver->setThreadPool( m_threadPool );
+	m_solver->setParallel( cinfo.m_parallelSolver );
+	m_solver->setWide( cinfo.m_wideContactSolver );
+
 	m_solverInfo.m_deltaTime = cinfo.m_deltaTime;
 	m_solverInfo.m_numIter = cinfo.m_numIter;
 
@@ -457,7 +833,7 @@ physicsWorld::physicsWorld( const physicsWorldConfig& cinfo ) :
 	self->registerColliderFunc( physicsShape::BASE, physicsShape::CONVEX, nullptr );
 	self->registerColliderFunc( physicsShape::CIRCLE, physicsShape::CIRCLE, physicsCircleCollider::collide );
 	self->registerColliderFunc( physicsShape::CIRCLE, physicsShape::BOX, physicsCircleBoxCollider::collide );
-	self->registerColliderFunc( physicsShape::CIRCLE, physicsShape::CONVEX, physicsConvexCollider::collide );
+	self->registerColliderFunc( physicsShape::CIRCLE, physicsShape::CONVEX, physicsCircleConvexCollider::collide );
 	self->registerColliderFunc( physicsShape::BOX, physicsShape::BOX, physicsBoxCollider::collide );
 	self->registerColliderFunc( physicsShape::BOX, physicsShape::CONVEX, physicsConvexCollider::collide );
 	self->registerColliderFunc( physicsShape::CONVEX, physicsShape::CONVEX, physicsConvexCollider::collide );
@@ -466,6 +842,8 @@ physicsWorld::physicsWorld( const physicsWorldConfig& cinfo ) :
 physicsWorld::~physicsWorld()
 {
 	delete m_solver;
+	delete m_broadphase;
+	delete m_threadPool;
 	m_bodies.clear();
 }
 
@@ -484,6 +862,13 @@ BodyId physicsWorld::createBody( const physicsBodyCinfo& cinfo )
 		m_activeBodyIds.push_back( body.getBodyId() );
 		body.setActiveListIdx( static_cast< int >( m_activeBodyIds.size() ) - 1 );
 
+		static_cast<physicsWorldEx*>( this )->addToBroadphase( body );
+
+		if ( !body.isStatic() )
+		{
+			static_cast<physicsWorldEx*>( this )->addToAwakeList( body );
+		}
+
 		return body.getBodyId();
 	}
 	else
@@ -497,6 +882,13 @@ BodyId physicsWorld::createBody( const physicsBodyCinfo& cinfo )
 		m_activeBodyIds.push_back( body.getBodyId() );
 		body.setActiveListIdx( static_cast< int >( m_activeBodyIds.size() ) - 1 );
 
+		static_cast<physicsWorldEx*>( this )->addToBroadphase( body );
+
+		if ( !body.isStatic() )
+		{
+			static_cast<physicsWorldEx*>( this )->addToAwakeList( body );
+		}
+
 		return body.getBodyId();
 	}
 }
@@ -505,12 +897,28 @@ void physicsWorld::removeBody( const BodyId bodyId )
 {
 	// Body removed locations will be re-used for future body additions
 	physicsBody& body = m_bodies[bodyId];
+	physicsWorldEx* self = static_cast<physicsWorldEx*>( this );
 
+	// Whatever rested on or hung from body falls, sleeping island loses a member
+	self->wakeJointedBodies( bodyId );
+
+	if ( body.isStatic() )
+	{
+		self->wakeBodiesOverlapping( body.getAabb() );
+	}
+	else
+	{
+		wakeBody( bodyId );
+		self->removeFromAwakeList( body );
+	}
 
+	// Pairs of removed body are reported lost on next step
+	m_broadphase->removeBody( bodyId );
 
 	// Remove bodyId from actively simulated set
 	int activeListIdx = body.getActiveListIdx();
-	std::swap( m_activeBodyIds[activeListIdx], m_activeBodyIds.back() );
+	m_activeBodyIds[activeListIdx] = m_activeBodyIds.back();
+	m_bodies[m_activeBodyIds[activeListIdx]].setActiveListIdx( activeListIdx );
 	m_activeBodyIds.pop_back();
 
 	// Add removed body's index to free body linked list
@@ -561,6 +969,10 @@ int physicsWorld::addJoint( const JointConfig& config )
 		}
 	}
 
+	// Jointed bodies share an island from now on
+	wakeBody( joint.bodyIdA );
+	wakeBody( joint.bodyIdB );
+
 	m_jointSolvePairs.push_back( joint );
 	return ( static_cast< int >( m_jointSolvePairs.size() ) - 1 );
 }
@@ -568,8 +980,10 @@ int physicsWorld::addJoint( const JointConfig& config )
 void physicsWorld::removeJoint( JointId jointId )
 {
 	// TODO: think about what to do with this
-	auto jiter = m_jointSolvePairs.begin();
-	m_jointSolvePairs.erase( jiter + jointId );
+	auto jiter = m_jointSolvePairs.begin() + jointId;
+	wakeBody( jiter->bodyIdA );
+	wakeBody( jiter->bodyIdB );
+	m_jointSolvePairs.erase( jiter );
 }
 
 void physicsWorld::step()
@@ -583,7 +997,59 @@ void physicsWorld::step()
 void physicsWorld::setPosition( BodyId bodyId, const Vector4& point )
 {
 	physicsBody& body = m_bodies[bodyId];
+	physicsWorldEx* self = static_cast<physicsWorldEx*>( this );
+
+	if ( body.isStatic() )
+	{
+		// Bodies resting where it was and where it lands have to react
+		self->wakeBodiesOverlapping( body.getAabb() );
+	}
+
 	body.setPosition( point );
+	body.updatePose();
+
+	if ( body.isStatic() )
+	{
+		// Static aabb's aren't refreshed every step
+		self->updateAabb( body );
+		m_broadphase->updateBody( bodyId, body.getAabb() );
+		self->wakeBodiesOverlapping( body.getAabb() );
+	}
+	else
+	{
+		wakeBody( bodyId );
+	}
+
+	// Joints pull bodies along, joints to static bodies aren't in any island
+	self->wakeJointedBodies( bodyId );
+}
+
+void physicsWorld::wakeBody( BodyId bodyId )
+{
+	physicsBody& body = m_bodies[bodyId];
+
+	if ( body.isStatic() )
+	{
+		return;
+	}
+
+	if ( !body.isSleeping() )
+	{
+		body.resetSleepTime();
+		return;
+	}
+
+	// Whole island wakes, members were linked when it fell asleep
+	BodyId memberId = bodyId;
+
+	do
+	{
+		physicsBody& member = m_bodies[memberId];
+		member.setSleeping( false );
+		static_cast<physicsWorldEx*>( this )->addToAwakeList( member );
+		memberId = member.getNextInIsland();
+	}
+	while ( memberId != bodyId );
 }
 
 physicsMotionType physicsWorld::getMotionType( BodyId bodyId ) const
@@ -594,7 +1060,49 @@ physicsMotionType physicsWorld::getMotionType( BodyId bodyId ) const
 void physicsWorld::setMotionType( BodyId bodyId, physicsMotionType type )
 {
 	physicsBody& body = m_bodies[bodyId];
-	body.setMotionType( type );
+	physicsWorldEx* self = static_cast<physicsWorldEx*>( this );
+
+	if ( body.isStatic() == ( type == physicsMotionType::STATIC ) )
+	{
+		body.setMotionType( type );
+		return;
+	}
+
+	// Neighbours react to the change, body itself joins or leaves awake bodies
+	self->wakeJointedBodies( bodyId );
+
+	if ( body.isStatic() )
+	{
+		self->wakeBodiesOverlapping( body.getAabb() );
+		body.setMotionType( type );
+		body.setSleeping( false );
+		self->addToAwakeList( body );
+	}
+	else
+	{
+		wakeBody( bodyId );
+		self->removeFromAwakeList( body );
+		body.setMotionType( type );
+		self->wakeBodiesOverlapping( body.getAabb() );
+	}
+
+	// Static bodies are kept apart in broadphase, re-register with new motion type
+	m_broadphase->removeBody( bodyId );
+	self->addToBroadphase( body );
+}
+
+void physicsWorld::setCollisionFilter( BodyId bodyId, unsigned int category, unsigned int mask )
+{
+	physicsBody& body = m_bodies[bodyId];
+	body.setCollisionFilter( category, mask );
+
+	// Pairs filtered in or out change what body and its neighbours rest on
+	wakeBody( bodyId );
+	static_cast<physicsWorldEx*>( this )->wakeBodiesOverlapping( body.getAabb() );
+
+	// Re-register so pairs are filtered again
+	m_broadphase->removeBody( bodyId );
+	static_cast<physicsWorldEx*>( this )->addToBroadphase( body );
 }
 
 //
@@ -605,21 +1113,23 @@ void physicsWorld::queryPoint( const Vector4& point, HitResult& hitResult ) cons
 	hitResult.numHits = 0;
 	hitResult.hitInfos.clear();
 
-	for ( auto i = 0; i < m_activeBodyIds.size(); i++ )
+	std::vector<BodyId> candidates;
+	m_broadphase->queryAabb( physicsAabb( point, point ), candidates );
+
+	for ( auto i = 0; i < candidates.size(); i++ )
 	{
-		const physicsBody& body = getBody( m_activeBodyIds[i] );
+		const physicsBody& body = getBody( candidates[i] );
 
 		Vector4 pointLocal;
-		pointLocal.setSub( point, body.getPosition() );
-		pointLocal.setRotatedDir( -body.getRotation() );
-		
+		body.getLocalPoint( point, pointLocal );
+
 		if ( body.getShape()->containsPoint( pointLocal ) )
 		{
 			hitResult.numHits++;
 
 			HitResult::HitInfo hitInfo;
 			{
-				hitInfo.bodyId = m_activeBodyIds[i];
+				hitInfo.bodyId = candidates[i];
 				hitInfo.hitPos.setSub( pointLocal, body.getPosition() );
 			}
 			hitResult.hitInfos.push_back( hitInfo );
@@ -7,6 +7,8 @@
 #include <physicsShape.h> // For physicsShape::NUM_SHAPES
 #include <physicsCollider.h>
 #include <physicsSolver.h>
+#include <physicsBroadphase.h>
+#include <physicsCircleBatch.h>
 
 struct ContactPoint;
 class physicsSolver;
@@ -16,7 +18,8 @@ typedef void( *ColliderFuncPtr )( const physicsShape* shapeA,
 								  const physicsShape* shapeB,
 								  const Transform& transformA,
 								  const Transform& transformB,
-								  std::vector<ContactPoint>& contacts);
+								  ContactManifold& contacts,
+								  ColliderCache* cache );
 
 struct physicsWorldConfig
 {
@@ -24,12 +27,40 @@ struct physicsWorldConfig
 	Real m_deltaTime;
 	Real m_cor;
 	int m_numIter;
+	physicsBroadphase::Type m_broadphaseType;
+	Real m_broadphaseCellSize; // Used by hash grid, around the size of a typical aabb
+	Real m_broadphaseTreeMargin; // Used by aabb tree, fat aabb's are enlarged by this much
+	int m_numThreads; // Including thread calling step
+	bool m_parallelSolver; // Constraints are graph colored and colors solved across threads, results don't depend on thread count
+	bool m_wideContactSolver; // Contacts are solved in color order, several pairs at once in SIMD lanes
+	bool m_predictiveAabbs; // Aabb's cover motion over a step plus margin, instead of being scaled up
+	Real m_predictiveAabbMargin;
+	bool m_allowSleeping; // Islands of bodies at rest stop being simulated until touched
+	Real m_sleepLinearTolerance; // Bodies which stay this close to where they started resting count as resting
+	Real m_sleepAngularTolerance; // Radians
+	Real m_sleepLinearSpeed; // Bodies moving faster don't count as resting even close to where they started, above solver jitter
+	Real m_sleepAngularSpeed; // Radians per second
+	Real m_timeToSleep; // Island sleeps once all its bodies have rested this long
 
 	physicsWorldConfig() :
 		m_gravity( 0.f, -98.1f ),
 		m_deltaTime( .016f ),
 		m_cor( 1.f ),
-		m_numIter( 8 ) {}
+		m_numIter( 8 ),
+		m_broadphaseType( physicsBroadphase::SWEEP_AND_PRUNE ),
+		m_broadphaseCellSize( 32.f ),
+		m_broadphaseTreeMargin( 4.f ),
+		m_numThreads( 1 ),
+		m_parallelSolver( false ),
+		m_wideContactSolver( false ),
+		m_predictiveAabbs( false ),
+		m_predictiveAabbMargin( 1.f ),
+		m_allowSleeping( true ),
+		m_sleepLinearTolerance( 2.f ),
+		m_sleepAngularTolerance( 10.f * g_degToRad ),
+		m_sleepLinearSpeed( 5.f ),
+		m_sleepAngularSpeed( .25f ),
+		m_timeToSleep( .5f ) {}
 };
 
 struct JointConfig
@@ -39,117 +70,72 @@ struct JointConfig
 	Vector4 pivot;
 };
 
+// Contact point kept across steps with impulses solver accumulated on it
+struct ManifoldPoint
+{
+	ContactPoint contact;
+	Real normalImpulse;
+	Real tangentImpulse;
+
+	ManifoldPoint() :
+		contact(), normalImpulse( 0.f ), tangentImpulse( 0.f ) {}
+};
+
 struct CachedPair : public BodyIdPair
 {
-	ContactPoint cpA;
-	ContactPoint cpB;
-	Real accumImp;
-	int numContacts;
-	int idx;
+	// Narrowphase bucketing reads only these, kept up front to share a cache line with pair
+	physicsShape::Type shapeTypeA;
+	physicsShape::Type shapeTypeB;
+	int numPoints;
+
+	ManifoldPoint points[ContactManifold::MAX_CONTACTS];
+	ColliderCache colliderCache; // Warm starts collider next step
 
 public:
 
-	CachedPair( const BodyId a, const BodyId b ):
+	CachedPair( const BodyId a = invalidId, const BodyId b = invalidId ):
 		BodyIdPair( a, b ),
-		cpA(), cpB(), accumImp( 0.f ), numContacts( 0 ), idx( 0 )
+		shapeTypeA( physicsShape::BASE ), shapeTypeB( physicsShape::BASE ),
+		numPoints( 0 ), colliderCache()
 	{
 
 	}
 
-	CachedPair( const BodyIdPair& other ) :
+	CachedPair( const BodyIdPair& other, const physicsShape::Type typeA, const physicsShape::Type typeB ) :
 		BodyIdPair( other ),
-		cpA(), cpB(), accumImp( 0.f ), numContacts( 0 ), idx( 0 )
+		shapeTypeA( typeA ), shapeTypeB( typeB ),
+		numPoints( 0 ), colliderCache()
 	{
 
 	}
 
-	// TODO: move implementation out
-	void addContact(const ContactPoint& cp)
-	{
-/*
-		if ( idx == 0 )
-		{
-			cpA = cp;
-			numContacts = 1;
-		}
-		if ( idx == 1 )
-		{
-			cpB = cp;
-
-			if ( numContacts < 2 )
-			{
-				numContacts = 2;
-			}
-		}
-		idx = ( idx + 1 ) % 2;
-*/
-		if ( numContacts == 0 )
-		{
-			cpA = cp;
-			numContacts = 1;
-		}
-		else if ( numContacts == 1 )
-		{
-			Real distToA;
-			ContactPointUtils::getContactDifference( cp, cpA, distToA );
-			if ( distToA < 5.f )
-			{
-				cpA = cp;
-				numContacts = 1;
-			}
-			else
-			{
-				cpB = cp;
-				numContacts = 2;
-			}
-		}
-		else
-		{
-			Real distToA, distToB;
-			ContactPointUtils::getContactDifference( cp, cpA, distToA );
-			ContactPointUtils::getContactDifference( cp, cpB, distToB );
-
-			if ( distToA < 5.f )
-			{
-				cpA = cp;
-			}
-			else if ( distToB < 5.f )
-			{
-				cpB = cp;
-			}
-			else
-			{
-				cpA = cp;
-				numContacts = 1;
-			}
-		}
-	}
-/*	
-	ContactPoint getContact()
-	{
-		if ( idx == 0 )
-		{
-			return cpA;
-		}
-		if ( idx == 1 )
-		{
-			return cpB;
-		}
-	}
-*/
+	// Replaces points with contacts found this step.
+	// Contacts made by the same features as a point last step take over its impulses, others start from zero
+	void updateManifold( const ContactManifold& contacts );
 };
 
-struct BroadphaseBody
+// Contacts one narrowphase thread generated, merged into cached pairs after all threads finish
+struct NarrowphaseOutput
 {
-	BodyId bodyId;
-	physicsAabb aabb;
-
-	BroadphaseBody( const BodyId bodyId, const physicsAabb& aabb ) :
-		bodyId( bodyId ),
-		aabb( aabb )
-	{
+	std::vector<int> slots; // Cached pair slots
+	std::vector<ContactManifold> manifolds; // Contacts of each slot, empty if pair stopped touching
+	std::vector<int> touchingCircles; // Scratch for circle batch
+};
 
-	}
+// Broadphase pair churn of last step.
+// Pairs dropping out and coming back throw away their collision caches, which predictive aabb's should reduce
+struct BroadphaseStats
+{
+	int numPairs;
+	int numAddedPairs;
+	int numRemovedPairs;
+	int numLostContactCaches; // Removed pairs which had contacts cached
+
+	BroadphaseStats() :
+		numPairs( 0 ),
+		numAddedPairs( 0 ),
+		numRemovedPairs( 0 ),
+		numLostContactCaches( 0 ) {}
 };
 
 struct HitResult
@@ -178,6 +164,9 @@ public:
 
 	const std::vector<BodyId>& getActiveBodyIds() const { return m_activeBodyIds; }
 
+	// Dynamic bodies which aren't sleeping, in no particular order
+	const std::vector<BodyId>& getAwakeBodyIds() const { return m_awakeBodyIds; }
+
 	// TODO: add O(1) check which checks body is active
 	const physicsBody& getBody( const BodyId bodyId ) const { return m_bodies[bodyId]; }
 
@@ -190,15 +179,23 @@ public:
 	// Utility funcs
 	void setPosition( BodyId bodyId, const Vector4& point );
 
+	// Wakes body's island, does nothing for static bodies
+	void wakeBody( BodyId bodyId );
+
 	physicsMotionType getMotionType( BodyId bodyId ) const;
 	void setMotionType( BodyId bodyId, physicsMotionType type );
 
+	// Bodies collide if each one's category is in the other's mask, non-collidable bodies stay so
+	void setCollisionFilter( BodyId bodyId, unsigned int category, unsigned int mask );
+
 	const Real getDeltaTime() const { return m_solverInfo.m_deltaTime; }
 
-	const std::vector<BroadphaseBody>& getBroadphaseBodies() const { return m_broadphaseBodies; }
+	void getBroadphaseBodies( std::vector<BroadphaseBody>& bodiesOut ) const { m_broadphase->getBroadphaseBodies( bodiesOut ); }
+
+	const BroadphaseStats& getBroadphaseStats() const { return m_broadphaseStats; }
 
 	// Spatial query
-    // Return first body which occupies point
+	// Return bodies which occupy point, candidates are found through broadphase
 	void queryPoint( const Vector4& point, HitResult& hitResult ) const;
 
 protected:
@@ -209,25 +206,59 @@ protected:
 	// Array of bodies, both simulated and freed
 	std::vector<physicsBody> m_bodies;
 
-    // Array of aabb's used for last step's broadphase
-	std::vector<struct BroadphaseBody> m_broadphaseBodies;
+	bool m_predictiveAabbs;
+	Real m_predictiveAabbMargin;
+
+	bool m_allowSleeping;
+	Real m_sleepLinearTolerance;
+	Real m_sleepAngularTolerance;
+	Real m_sleepLinearSpeed;
+	Real m_sleepAngularSpeed;
+	Real m_timeToSleep;
+
+	// Keeps overlapping aabb pairs between steps
+	physicsBroadphase* m_broadphase;
+	BroadphaseStats m_broadphaseStats;
+	physicsThreadPool* m_threadPool;
 	SolverInfo m_solverInfo;
 	physicsSolver* m_solver;
 	ColliderFuncPtr m_dispatchTable[physicsShape::NUM_SHAPES][physicsShape::NUM_SHAPES];
+	bool m_dispatchFlipped[physicsShape::NUM_SHAPES][physicsShape::NUM_SHAPES]; // Shapes are passed to collider in reverse
 
-	// New broadphase pairs
+	// Pairs found and lost by broadphase this step
 	std::vector<BodyIdPair> m_newPairs;
+	std::vector<BodyIdPair> m_lostPairs;
+
+	// Collision caches of all broadphase pairs
+	physicsPairMap<CachedPair> m_cachedPairs;
 
-	// Existing broadphase pairs from last frame
-	std::vector<BodyIdPair> m_existingPairs;
+	// Narrowphase work of this step, slot indices of cached pairs bucketed by shape types of bodies A and B.
+	// Circle-circle pairs go into the batch instead, m_circleBatchSlots maps batch entries back to slots
+	std::vector<int> m_narrowphaseBuckets[physicsShape::NUM_SHAPES][physicsShape::NUM_SHAPES];
+	physicsCircleBatch m_circleBatch;
+	std::vector<int> m_circleBatchSlots;
+	std::vector<int> m_circlesWithPoints; // Batch entries which had a contact last step
+	std::vector<NarrowphaseOutput> m_narrowphaseOutputs; // One per thread
+	std::vector<int> m_touchingSlots; // Slots of pairs which got contacts
+	std::vector<int> m_restingTouchingSlots; // Pairs with contacts skipped as neither body is awake, contacts stay valid as they don't move
 
-	std::vector<CachedPair> m_cachedPairs;
 	std::vector<ConstrainedPair> m_jointSolvePairs;
 	std::vector<ConstrainedPair> m_contactSolvePairs;
 
 	// Array of body Ids for which body is simulated
 	std::vector<BodyId> m_activeBodyIds;
 
+	// Dynamic bodies which aren't sleeping, gravity, aabb updates, solver and integration go through these only
+	std::vector<BodyId> m_awakeBodyIds;
+
+	// Joints solved this step, joints of sleeping islands are left out
+	std::vector<ConstrainedPair> m_awakeJointPairs;
+
+	// Island building scratch indexed by body Id, union-find parents then shortest sleep time and ring head per root
+	std::vector<BodyId> m_islandParents;
+	std::vector<Real> m_islandSleepTimes;
+	std::vector<BodyId> m_islandHeads;
+
 	std::vector<SolverBody> m_solverBodies;
 	BodyId m_firstFreeBodyId;
 };